@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cppcrudbp::bench {
+
+/**
+ * @brief Outcome of one measured loop.
+ */
+struct Result {
+  std::string name;
+  std::size_t iterations;
+  double ns_per_op;
+};
+
+/**
+ * @brief Collects results and prints them as they arrive.
+ */
+class Reporter {
+public:
+  void add(Result result);
+  void skip(const std::string &name, const std::string &reason);
+  [[nodiscard]] const std::vector<Result> &results() const { return results_; }
+
+  /**
+   * @brief Writes every result and skip as one JSON document, so runs from
+   * different commits can be diffed by name.
+   */
+  void writeJson(std::ostream &out) const;
+
+private:
+  std::vector<Result> results_;
+  std::vector<std::pair<std::string, std::string>> skipped_;
+};
+
+using BenchmarkFn = void (*)(Reporter &);
+
+/**
+ * @brief Registers a benchmark function at static-initialization time.
+ */
+struct Registrar {
+  Registrar(const char *name, BenchmarkFn fn);
+};
+
+#define CPPCRUDBP_BENCHMARK(fn)                                               \
+  static void fn(::cppcrudbp::bench::Reporter &);                             \
+  static const ::cppcrudbp::bench::Registrar fn##_registrar(#fn, fn);         \
+  static void fn(::cppcrudbp::bench::Reporter &reporter)
+
+/**
+ * @brief Runs @p op @p iterations times and returns the mean cost per call.
+ */
+template <typename Op>
+Result measure(std::string name, std::size_t iterations, Op &&op) {
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < iterations; ++i) {
+    op(i);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const double ns =
+      std::chrono::duration<double, std::nano>(elapsed).count();
+  return Result{std::move(name), iterations,
+                iterations ? ns / static_cast<double>(iterations) : 0.0};
+}
+
+/**
+ * @brief Keeps the optimizer from discarding a computed value.
+ */
+template <typename T> inline void doNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Connection string of the Postgres instance used by database
+ * benchmarks, taken from CPPCRUDBP_BENCH_PG; empty when unset.
+ */
+std::string benchDatabaseUrl();
+
+} // namespace cppcrudbp::bench
@@ -0,0 +1,169 @@
+#include "bench.h"
+#include "application/user_service.h"
+#include "infrastructure/in_memory_user_repository.h"
+#include "presentation/http.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kUsers = 100000;
+constexpr std::size_t kClientsPerWorker = 4;
+constexpr auto kDuration = std::chrono::seconds(3);
+
+// One keep-alive client connection doing blocking request/response.
+class LoadClient {
+public:
+  explicit LoadClient(std::uint16_t port) {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd_ < 0 || connect(fd_, reinterpret_cast<sockaddr *>(&address),
+                           sizeof(address)) < 0) {
+      throw std::runtime_error(std::string("connect: ") +
+                               std::strerror(errno));
+    }
+    const int on = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  }
+  ~LoadClient() { close(fd_); }
+
+  // Sends @p request and reads one full response; returns its status.
+  int roundTrip(const std::string &request) {
+    if (send(fd_, request.data(), request.size(), MSG_NOSIGNAL) !=
+        static_cast<ssize_t>(request.size())) {
+      return -1;
+    }
+    buffer_.clear();
+    std::size_t head_end = std::string::npos;
+    std::size_t total = 0;
+    char chunk[16 * 1024];
+    while (head_end == std::string::npos || buffer_.size() < total) {
+      const ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+      if (n <= 0) {
+        return -1;
+      }
+      buffer_.append(chunk, static_cast<std::size_t>(n));
+      if (head_end == std::string::npos) {
+        head_end = buffer_.find("\r\n\r\n");
+        if (head_end != std::string::npos) {
+          const std::size_t length = buffer_.find("Content-Length: ");
+          total = head_end + 4 +
+                  (length < head_end ? std::stoul(buffer_.substr(length + 16))
+                                     : 0);
+        }
+      }
+    }
+    return std::stoi(buffer_.substr(9, 3));
+  }
+
+private:
+  int fd_;
+  std::string buffer_;
+};
+
+double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  const auto index = static_cast<std::size_t>(p * (sorted.size() - 1));
+  return sorted[index];
+}
+
+} // namespace
+
+// Loopback load test of the HTTP adapter over the in-memory repository, so
+// the numbers reflect the server loop rather than the database. Clients run
+// in the same process and compete with the workers for the same cores.
+CPPCRUDBP_BENCHMARK(httpLoopback) {
+  auto repository =
+      std::make_shared<cppcrudbp::infrastructure::InMemoryUserRepository>(
+          kUsers);
+  std::vector<cppcrudbp::application::CreateUserRequest> users;
+  users.reserve(kUsers);
+  for (std::size_t i = 0; i < kUsers; ++i) {
+    users.push_back({"user " + std::to_string(i),
+                     "user" + std::to_string(i) + "@example.com"});
+  }
+  repository->bulkCreateUsers(users);
+
+  cppcrudbp::http::HttpOptions options;
+  options.address = "127.0.0.1";
+  options.port = 0;
+  cppcrudbp::http::HttpAdapter server(
+      std::make_shared<cppcrudbp::application::UserService>(repository),
+      options);
+  server.start();
+  const std::size_t workers =
+      std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t clients = workers * kClientsPerWorker;
+
+  // Each client records its own latencies; merged once everyone stops.
+  std::vector<std::vector<double>> latencies(clients);
+  std::vector<std::size_t> errors(clients, 0);
+  std::vector<std::thread> threads;
+  const auto deadline = Clock::now() + kDuration;
+  const auto start = Clock::now();
+  for (std::size_t c = 0; c < clients; ++c) {
+    threads.emplace_back([&, c] {
+      LoadClient client(server.port());
+      std::size_t i = c;
+      while (Clock::now() < deadline) {
+        const int id = static_cast<int>((i++ * 2654435761u) % kUsers) + 1;
+        const std::string request = "GET /users/" + std::to_string(id) +
+                                    " HTTP/1.1\r\nHost: bench\r\n\r\n";
+        const auto sent = Clock::now();
+        if (client.roundTrip(request) != 200) {
+          ++errors[c];
+          continue;
+        }
+        latencies[c].push_back(
+            std::chrono::duration<double, std::micro>(Clock::now() - sent)
+                .count());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  server.stop();
+  server.wait();
+
+  std::vector<double> all;
+  std::size_t failed = 0;
+  for (std::size_t c = 0; c < clients; ++c) {
+    all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+    failed += errors[c];
+  }
+  if (all.empty()) {
+    reporter.skip("http/GET /users/{id}", "no successful requests");
+    return;
+  }
+  std::sort(all.begin(), all.end());
+  const double requests_per_second = static_cast<double>(all.size()) / seconds;
+  reporter.add({"http/GET /users/{id}", all.size(),
+                seconds * 1e9 / static_cast<double>(all.size())});
+  std::cout << "http: " << clients << " clients, " << workers
+            << " workers, " << requests_per_second << " req/s ("
+            << requests_per_second / static_cast<double>(workers)
+            << " req/s per core), p50 " << percentile(all, 0.50)
+            << " us, p99 " << percentile(all, 0.99) << " us, " << failed
+            << " errors\n";
+}
@@ -0,0 +1,87 @@
+#include "bench.h"
+#include "infrastructure/in_memory_user_repository.h"
+#include "repository_suite.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using cppcrudbp::bench::doNotOptimize;
+using cppcrudbp::bench::measure;
+
+constexpr std::size_t kUsers = 1000000;
+
+std::vector<cppcrudbp::application::CreateUserRequest> makeUsers() {
+  std::vector<cppcrudbp::application::CreateUserRequest> users;
+  users.reserve(kUsers);
+  for (std::size_t i = 0; i < kUsers; ++i) {
+    users.push_back({"user " + std::to_string(i),
+                     "user" + std::to_string(i) + "@example.com"});
+  }
+  return users;
+}
+
+} // namespace
+
+// Baseline cost of the repository contract without any database.
+CPPCRUDBP_BENCHMARK(inMemoryRepository) {
+  cppcrudbp::infrastructure::InMemoryUserRepository repository(kUsers);
+  const auto users = makeUsers();
+
+  reporter.add(measure("inMemory/bulkCreateUsers(1M)", 1, [&](std::size_t) {
+    doNotOptimize(repository.bulkCreateUsers(users));
+  }));
+  std::cout << "inMemory bytes/user: "
+            << repository.memoryBytes() / repository.size() << "\n";
+
+  // Pseudo-random ids so lookups are not prefetch-friendly.
+  reporter.add(measure("inMemory/getUserById", kUsers, [&](std::size_t i) {
+    const int id = static_cast<int>((i * 2654435761u) % kUsers) + 1;
+    doNotOptimize(repository.getUserById(id));
+  }));
+  // The whole table as one UserBatch, against the per-user strings a
+  // std::vector<UserResponse> would allocate.
+  cppcrudbp::application::UserBatch all;
+  reporter.add(measure("inMemory/getAllUsers(1M)", 1, [&](std::size_t) {
+    all = repository.getAllUsers();
+  }));
+  std::vector<cppcrudbp::application::UserResponse> responses;
+  reporter.add(measure("inMemory/toUserResponses(1M)", 1, [&](std::size_t) {
+    responses.reserve(all.size());
+    for (std::size_t i = 0; i < all.size(); ++i) {
+      responses.push_back(all.user(i));
+    }
+  }));
+  std::size_t vector_bytes = responses.capacity() * sizeof(responses[0]);
+  for (const auto &user : responses) {
+    for (const std::string *text : {&user.name, &user.email}) {
+      vector_bytes += text->capacity() > 15 ? text->capacity() + 1 : 0;
+    }
+  }
+  std::cout << "inMemory listing bytes/user: UserBatch "
+            << all.memoryBytes() / all.size() << ", vector<UserResponse> "
+            << vector_bytes / responses.size() << "\n";
+  reporter.add(measure("inMemory/getUsersPage(100)", 10000, [&](std::size_t i) {
+    doNotOptimize(
+        repository.getUsersPage(static_cast<int>((i * 97) % kUsers), 100));
+  }));
+  reporter.add(measure("inMemory/getUserByEmail", kUsers, [&](std::size_t i) {
+    doNotOptimize(
+        repository.getUserByEmail(users[(i * 2654435761u) % kUsers].email));
+  }));
+  // "user 1234" matches 11 names; shorter prefixes fill the whole page.
+  const auto search = [&](std::size_t i) {
+    const std::string prefix = "user " + std::to_string(i % 10000);
+    doNotOptimize(repository.searchUsersByNamePrefix(prefix, {}, 20));
+  };
+  reporter.add(measure("inMemory/searchUsersByNamePrefix(20)", 100000,
+                       search));
+}
+
+// The same CRUD suite the Postgres benchmark runs, without the database.
+CPPCRUDBP_BENCHMARK(inMemoryCrudSuite) {
+  cppcrudbp::infrastructure::InMemoryUserRepository repository;
+  cppcrudbp::bench::runRepositorySuite("crud/inMemory", repository, reporter,
+                                       100000);
+}
@@ -0,0 +1,117 @@
+#include "bench.h"
+#include "presentation/json_reader.h"
+#include "presentation/json_writer.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using cppcrudbp::bench::doNotOptimize;
+using cppcrudbp::bench::measure;
+
+// The find/substr helpers cli.cpp used before JsonReader, kept verbatim as
+// the baseline.
+std::string legacyExtractJsonValue(const std::string &json,
+                                   const std::string &key) {
+  std::string search_key = "\"" + key + "\":\"";
+  size_t start_pos = json.find(search_key);
+  if (start_pos == std::string::npos) {
+    return "";
+  }
+  start_pos += search_key.length();
+  size_t end_pos = json.find("\"", start_pos);
+  if (end_pos == std::string::npos) {
+    return "";
+  }
+  return json.substr(start_pos, end_pos - start_pos);
+}
+
+// CliAdapter's stringstream serializers before JsonWriter, as the baseline.
+std::string legacySerializeUser(
+    const cppcrudbp::application::UserResponse &response) {
+  std::stringstream ss;
+  ss << "{\"id\":" << response.id << ",\"name\":\"" << response.name
+     << "\",\"email\":\"" << response.email << "\"}";
+  return ss.str();
+}
+
+std::string legacySerializeUsers(
+    const std::vector<cppcrudbp::application::UserResponse> &responses) {
+  std::stringstream ss;
+  ss << "[";
+  for (size_t i = 0; i < responses.size(); ++i) {
+    ss << legacySerializeUser(responses[i]);
+    if (i < responses.size() - 1) {
+      ss << ",";
+    }
+  }
+  ss << "]";
+  return ss.str();
+}
+
+std::vector<std::string> makeRequests(std::size_t count) {
+  std::vector<std::string> requests;
+  requests.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    requests.push_back(R"({"name":"Benchmark User Number )" +
+                       std::to_string(i) + R"(","email":"bench.user.)" +
+                       std::to_string(i) + R"(@example.com"})");
+  }
+  return requests;
+}
+
+} // namespace
+
+// Decoding a stream of create requests into CreateUserRequest.
+CPPCRUDBP_BENCHMARK(jsonRequestParsing) {
+  constexpr std::size_t kRequests = 200000;
+  const auto requests = makeRequests(kRequests);
+
+  reporter.add(measure("json/legacyExtract", kRequests, [&](std::size_t i) {
+    cppcrudbp::application::CreateUserRequest request;
+    request.name = legacyExtractJsonValue(requests[i], "name");
+    request.email = legacyExtractJsonValue(requests[i], "email");
+    doNotOptimize(request);
+  }));
+
+  // A reused request keeps its string capacity, as a batch importer would.
+  cppcrudbp::application::CreateUserRequest reused;
+  reporter.add(measure("json/JsonReader", kRequests, [&](std::size_t i) {
+    cppcrudbp::presentation::parseCreateUserJson(requests[i], reused);
+    doNotOptimize(reused);
+  }));
+}
+
+// Serializing a 1M-user listing.
+CPPCRUDBP_BENCHMARK(jsonResponseWriting) {
+  constexpr std::size_t kUsers = 1000000;
+  std::vector<cppcrudbp::application::UserResponse> users;
+  users.reserve(kUsers);
+  for (std::size_t i = 0; i < kUsers; ++i) {
+    users.push_back({static_cast<int>(i + 1),
+                     "Benchmark User " + std::to_string(i),
+                     "bench.user." + std::to_string(i) + "@example.com"});
+  }
+
+  reporter.add(measure("json/legacySerializeUsers(1M)", 1, [&](std::size_t) {
+    doNotOptimize(legacySerializeUsers(users));
+  }));
+  reporter.add(measure("json/JsonWriter::users(1M)", 1, [&](std::size_t) {
+    cppcrudbp::presentation::JsonWriter json;
+    json.users(users);
+    doNotOptimize(json.buffer());
+  }));
+
+  cppcrudbp::application::UserBatch batch;
+  batch.reserve(kUsers);
+  for (const auto &user : users) {
+    batch.push_back(user.id, user.name, user.email);
+  }
+  reporter.add(
+      measure("json/JsonWriter::users(UserBatch 1M)", 1, [&](std::size_t) {
+        cppcrudbp::presentation::JsonWriter json;
+        json.users(batch);
+        doNotOptimize(json.buffer());
+      }));
+}
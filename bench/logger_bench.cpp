@@ -0,0 +1,86 @@
+#include "bench.h"
+#include "common/logger.h"
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using cppcrudbp::bench::measure;
+using cppcrudbp::bench::Result;
+using cppcrudbp::common::Logger;
+using cppcrudbp::common::LoggerOptions;
+using cppcrudbp::common::LogLevel;
+
+constexpr const char *kWhat =
+    "duplicate key value violates unique constraint \"users_email_key\"";
+
+// Wall time of @p calls spread over @p threads, per call.
+template <typename Op>
+Result measureThreads(std::string name, std::size_t threads,
+                      std::size_t calls, Op &&op) {
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&op, calls, threads] {
+      for (std::size_t i = 0; i < calls / threads; ++i) {
+        op(i);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  const double ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  return Result{std::move(name), calls, ns / static_cast<double>(calls)};
+}
+
+} // namespace
+
+// What a failing repository call spends on its error line: a synchronous,
+// unbuffered stream write like std::cerr's versus the async logger, which
+// queues the record (or drops it when the writer falls behind) and, in a
+// storm from one call site, only counts it once the site's burst is spent.
+CPPCRUDBP_BENCHMARK(loggerOverhead) {
+  constexpr std::size_t kCalls = 1000000;
+  constexpr std::size_t kThreads = 4;
+  std::ofstream null_sink("/dev/null");
+  null_sink << std::unitbuf;
+  std::mutex sink_mutex;
+  const auto sync_write = [&](std::size_t) {
+    const std::lock_guard<std::mutex> lock(sink_mutex);
+    null_sink << "Error creating user: " << kWhat << '\n';
+  };
+
+  LoggerOptions unlimited;
+  unlimited.sink = &null_sink;
+  unlimited.capacity = 1 << 16;
+  unlimited.rate_burst = 0;
+  LoggerOptions limited = unlimited;
+  limited.rate_burst = 10;
+
+  reporter.add(measure("logger/syncOstream", kCalls, sync_write));
+  {
+    Logger logger(unlimited);
+    reporter.add(measure("logger/async", kCalls, [&](std::size_t) {
+      logger.log(LogLevel::kError, "bench", "Error creating user: ", kWhat);
+    }));
+  }
+
+  reporter.add(
+      measureThreads("logger/syncOstream4Threads", kThreads, kCalls,
+                     sync_write));
+  {
+    Logger logger(limited);
+    reporter.add(measureThreads(
+        "logger/rateLimited4Threads", kThreads, kCalls, [&](std::size_t) {
+          logger.log(LogLevel::kError, "bench", "Error creating user: ",
+                     kWhat);
+        }));
+  }
+}
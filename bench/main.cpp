@@ -0,0 +1,108 @@
+#include "bench.h"
+#include "presentation/json_writer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace cppcrudbp::bench {
+
+namespace {
+struct Entry {
+  const char *name;
+  BenchmarkFn fn;
+};
+
+std::vector<Entry> &registry() {
+  static std::vector<Entry> entries;
+  return entries;
+}
+} // namespace
+
+Registrar::Registrar(const char *name, BenchmarkFn fn) {
+  registry().push_back({name, fn});
+}
+
+void Reporter::add(Result result) {
+  std::cout << result.name << ": " << result.ns_per_op << " ns/op ("
+            << result.iterations << " iterations)\n";
+  results_.push_back(std::move(result));
+}
+
+void Reporter::skip(const std::string &name, const std::string &reason) {
+  std::cout << name << ": skipped (" << reason << ")\n";
+  skipped_.emplace_back(name, reason);
+}
+
+void Reporter::writeJson(std::ostream &out) const {
+#ifdef NDEBUG
+  constexpr const char *kBuild = "release";
+#else
+  constexpr const char *kBuild = "debug";
+#endif
+  const auto now = std::chrono::system_clock::now().time_since_epoch();
+  presentation::JsonWriter json(&out);
+  json.raw("{\"timestamp\":")
+      .number(std::chrono::duration_cast<std::chrono::seconds>(now).count());
+  json.raw(",\"compiler\":").string(__VERSION__);
+  json.raw(",\"build\":").string(kBuild);
+  json.raw(",\"results\":[");
+  for (std::size_t i = 0; i < results_.size(); ++i) {
+    char ns[32];
+    std::snprintf(ns, sizeof(ns), "%.3f", results_[i].ns_per_op);
+    json.raw(i == 0 ? "{\"name\":" : ",{\"name\":").string(results_[i].name);
+    json.raw(",\"iterations\":")
+        .number(static_cast<long long>(results_[i].iterations));
+    json.raw(",\"ns_per_op\":").raw(ns).raw("}");
+  }
+  json.raw("],\"skipped\":[");
+  for (std::size_t i = 0; i < skipped_.size(); ++i) {
+    json.raw(i == 0 ? "{\"name\":" : ",{\"name\":").string(skipped_[i].first);
+    json.raw(",\"reason\":").string(skipped_[i].second).raw("}");
+  }
+  json.raw("]}\n");
+}
+
+std::string benchDatabaseUrl() {
+  const char *url = std::getenv("CPPCRUDBP_BENCH_PG");
+  return url ? url : "";
+}
+
+} // namespace cppcrudbp::bench
+
+// Usage: cppcrudbp_bench [--json <file>] [name-substring]
+int main(const int argc, char *argv[]) {
+  const char *filter = nullptr;
+  const char *json_path = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      json_path = argv[++i];
+    } else {
+      filter = argv[i];
+    }
+  }
+  cppcrudbp::bench::Reporter reporter;
+  for (const auto &entry : cppcrudbp::bench::registry()) {
+    if (filter && !std::strstr(entry.name, filter)) {
+      continue;
+    }
+    try {
+      entry.fn(reporter);
+    } catch (const std::exception &e) {
+      std::cerr << entry.name << " failed: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+  if (json_path) {
+    std::ofstream out(json_path);
+    reporter.writeJson(out);
+    if (!out) {
+      std::cerr << "Cannot write " << json_path << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,20 @@
+#include "bench.h"
+#include "common/metrics.h"
+
+namespace {
+
+using cppcrudbp::bench::measure;
+
+} // namespace
+
+// Cost metrics add to every instrumented call: two clock reads and the
+// per-thread counter updates.
+CPPCRUDBP_BENCHMARK(metricsOverhead) {
+  constexpr std::size_t kCalls = 10000000;
+  const auto id = cppcrudbp::common::Metrics::global().registerOperation(
+      "bench", "metricsOverhead");
+  reporter.add(measure("metrics/OperationTimer", kCalls, [&](std::size_t i) {
+    cppcrudbp::common::OperationTimer timer(id);
+    timer.addRows(i & 1);
+  }));
+}
@@ -0,0 +1,352 @@
+#include "bench.h"
+#include "common/connection_pool.h"
+#include "infrastructure/pipelined_user_repository.h"
+#include "infrastructure/postgre_user_repository.h"
+#include "infrastructure/replica_routing_user_repository.h"
+#include "infrastructure/replicated_user_repository.h"
+#include "infrastructure/sharded_user_repository.h"
+#include "repository_suite.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using cppcrudbp::bench::doNotOptimize;
+using cppcrudbp::bench::measure;
+
+constexpr std::size_t kLookups = 20000;
+constexpr std::size_t kInFlight = 1000;
+
+int seedUser(cppcrudbp::common::ConnectionPool &pool) {
+  auto conn = pool.acquire();
+  pqxx::work txn(*conn);
+  const auto row = txn.exec_params1(
+      "INSERT INTO users (name, email) VALUES ($1, $2) RETURNING id",
+      "bench-user", "bench-" + std::to_string(::getpid()) + "@example.com");
+  txn.commit();
+  return row[0].as<int>();
+}
+
+void removeUser(cppcrudbp::common::ConnectionPool &pool, int id) {
+  auto conn = pool.acquire();
+  pqxx::work txn(*conn);
+  txn.exec_params0("DELETE FROM users WHERE id = $1", id);
+  txn.commit();
+}
+
+// One pool per URL of the comma-separated @p urls.
+std::vector<std::shared_ptr<cppcrudbp::common::ConnectionPool>>
+poolsOf(const std::string &urls) {
+  std::vector<std::shared_ptr<cppcrudbp::common::ConnectionPool>> pools;
+  for (std::size_t start = 0; start <= urls.size();) {
+    const std::size_t end = std::min(urls.find(',', start), urls.size());
+    if (end > start) {
+      pools.push_back(std::make_shared<cppcrudbp::common::ConnectionPool>(
+          urls.substr(start, end - start)));
+    }
+    start = end + 1;
+  }
+  return pools;
+}
+
+} // namespace
+
+// Per-call latency of getUserById with a re-parsed statement versus the
+// repository's prepared statement, on one pooled connection.
+CPPCRUDBP_BENCHMARK(getUserById) {
+  const std::string url = cppcrudbp::bench::benchDatabaseUrl();
+  if (url.empty()) {
+    reporter.skip("getUserById", "set CPPCRUDBP_BENCH_PG to a Postgres URL");
+    return;
+  }
+  cppcrudbp::common::ConnectionPoolOptions options;
+  options.min_size = 1;
+  options.max_size = 1;
+  auto pool = std::make_shared<cppcrudbp::common::ConnectionPool>(url, options);
+  cppcrudbp::infrastructure::PostgreUserRepository repository(pool);
+  const int id = seedUser(*pool);
+
+  reporter.add(measure("getUserById/exec_params", kLookups, [&](std::size_t) {
+    auto conn = pool->acquire();
+    pqxx::work txn(*conn);
+    const auto res =
+        txn.exec_params("SELECT id, name, email FROM users WHERE id = $1", id);
+    doNotOptimize(res.size());
+  }));
+  reporter.add(measure("getUserById/prepared", kLookups, [&](std::size_t) {
+    const auto user = repository.getUserById(id);
+    doNotOptimize(user->id);
+  }));
+
+  removeUser(*pool, id);
+}
+
+// One calling thread: blocking lookups one after another versus keeping
+// kInFlight lookups pipelined over two connections.
+CPPCRUDBP_BENCHMARK(asyncGetUserById) {
+  const std::string url = cppcrudbp::bench::benchDatabaseUrl();
+  if (url.empty()) {
+    reporter.skip("asyncGetUserById",
+                  "set CPPCRUDBP_BENCH_PG to a Postgres URL");
+    return;
+  }
+  cppcrudbp::common::ConnectionPoolOptions options;
+  options.min_size = 1;
+  options.max_size = 1;
+  auto pool = std::make_shared<cppcrudbp::common::ConnectionPool>(url, options);
+  cppcrudbp::infrastructure::PostgreUserRepository blocking(pool);
+  cppcrudbp::infrastructure::PipelinedUserRepository pipelined(url);
+  const int id = seedUser(*pool);
+
+  reporter.add(measure("getUserById/blocking", kLookups, [&](std::size_t) {
+    doNotOptimize(blocking.getUserById(id)->id);
+  }));
+
+  std::vector<std::future<std::optional<cppcrudbp::application::UserResponse>>>
+      window(kInFlight);
+  reporter.add(measure("getUserById/pipelined", kLookups, [&](std::size_t i) {
+    auto &slot = window[i % kInFlight];
+    if (slot.valid()) {
+      doNotOptimize(slot.get()->id);
+    }
+    slot = pipelined.getUserById(id);
+  }));
+  for (auto &slot : window) {
+    if (slot.valid()) {
+      slot.get();
+    }
+  }
+
+  removeUser(*pool, id);
+}
+
+// getUserByEmail and searchUsersByNamePrefix on a table of kLookupTableRows
+// users. Both are index range reads, so they should stay well under a
+// millisecond however large the table grows.
+CPPCRUDBP_BENCHMARK(postgresLookups) {
+  const std::string url = cppcrudbp::bench::benchDatabaseUrl();
+  if (url.empty()) {
+    reporter.skip("postgresLookups",
+                  "set CPPCRUDBP_BENCH_PG to a Postgres URL");
+    return;
+  }
+  constexpr long long kLookupTableRows = 2000000;
+  cppcrudbp::common::ConnectionPoolOptions options;
+  options.min_size = 1;
+  options.max_size = 1;
+  auto pool = std::make_shared<cppcrudbp::common::ConnectionPool>(url, options);
+  cppcrudbp::infrastructure::PostgreUserRepository repository(pool);
+  const std::string tag = "lookup-" + std::to_string(::getpid()) + "-";
+  {
+    auto conn = pool->acquire();
+    pqxx::work txn(*conn);
+    if (txn.query_value<long long>(
+            "SELECT count(*) FROM pg_indexes "
+            "WHERE indexname = 'users_name_c_id_idx'") == 0) {
+      reporter.skip("postgresLookups", "apply sql/migrations first");
+      return;
+    }
+    // md5 spreads the names like real ones: each two-hex-digit prefix
+    // matches about 1/256th of the rows.
+    txn.exec_params0("INSERT INTO users (name, email) "
+                     "SELECT 'Lookup ' || md5(g::text), $1 || g || "
+                     "'@example.com' FROM generate_series(1, $2) AS g",
+                     tag, kLookupTableRows);
+    txn.commit();
+    pqxx::nontransaction analyze(*conn);
+    analyze.exec("ANALYZE users");
+  }
+
+  reporter.add(measure("postgres/getUserByEmail", kLookups, [&](std::size_t i) {
+    const auto row = (i * 2654435761u) % kLookupTableRows + 1;
+    doNotOptimize(repository.getUserByEmail(tag + std::to_string(row) +
+                                            "@example.com"));
+  }));
+  const char *const hex = "0123456789abcdef";
+  std::string prefix = "Lookup xx";
+  const auto firstPage = [&](std::size_t i) {
+    prefix[7] = hex[(i >> 4) & 0xF];
+    prefix[8] = hex[i & 0xF];
+    doNotOptimize(repository.searchUsersByNamePrefix(prefix, {}, 20));
+  };
+  reporter.add(
+      measure("postgres/searchUsersByNamePrefix(20)", kLookups, firstPage));
+  // Following the cursor deep into one prefix costs the same per page.
+  cppcrudbp::application::NameCursor cursor;
+  const auto nextPage = [&](std::size_t) {
+    const auto page =
+        repository.searchUsersByNamePrefix("Lookup a", cursor, 20);
+    cursor = page.empty() ? cppcrudbp::application::NameCursor{}
+                          : cppcrudbp::application::NameCursor{
+                                std::string(page.back().name),
+                                page.back().id};
+  };
+  reporter.add(measure("postgres/searchUsersByNamePrefix(20)/next", kLookups,
+                       nextPage));
+
+  auto conn = pool->acquire();
+  pqxx::work txn(*conn);
+  txn.exec_params0("DELETE FROM users WHERE email LIKE $1 || '%'", tag);
+  txn.commit();
+}
+
+// End-to-end CRUD through PostgreUserRepository; compare with crud/inMemory
+// for the share of each call spent on the database round trip.
+CPPCRUDBP_BENCHMARK(postgresCrudSuite) {
+  const std::string url = cppcrudbp::bench::benchDatabaseUrl();
+  if (url.empty()) {
+    reporter.skip("postgresCrudSuite",
+                  "set CPPCRUDBP_BENCH_PG to a Postgres URL");
+    return;
+  }
+  auto pool = std::make_shared<cppcrudbp::common::ConnectionPool>(url);
+  cppcrudbp::infrastructure::PostgreUserRepository repository(pool);
+  cppcrudbp::bench::runRepositorySuite("crud/postgres", repository, reporter,
+                                       2000);
+}
+
+// Reads by id from the LISTEN/NOTIFY replica versus the database, and how
+// long a change committed elsewhere takes to show up in the replica.
+CPPCRUDBP_BENCHMARK(postgresReplica) {
+  const std::string url = cppcrudbp::bench::benchDatabaseUrl();
+  if (url.empty()) {
+    reporter.skip("postgresReplica",
+                  "set CPPCRUDBP_BENCH_PG to a Postgres URL");
+    return;
+  }
+  constexpr std::size_t kChanges = 200;
+  cppcrudbp::common::ConnectionPoolOptions options;
+  options.min_size = 1;
+  options.max_size = 2;
+  auto pool = std::make_shared<cppcrudbp::common::ConnectionPool>(url, options);
+  auto database =
+      std::make_shared<cppcrudbp::infrastructure::PostgreUserRepository>(pool);
+  cppcrudbp::infrastructure::UserReplicaOptions replica_options;
+  replica_options.heartbeat = std::chrono::milliseconds(50);
+  cppcrudbp::infrastructure::ReplicatedUserRepository replica(
+      database, url, replica_options);
+  if (!replica.waitUntilCurrent(std::chrono::seconds(30))) {
+    reporter.skip("postgresReplica",
+                  "replica did not load; apply "
+                  "sql/migrations/002_users_change_notify.sql");
+    return;
+  }
+  const int id = seedUser(*pool);
+
+  reporter.add(measure("replica/getUserById/database", kLookups,
+                       [&](std::size_t) {
+                         const auto user = database->getUserById(id);
+                         doNotOptimize(user->id);
+                       }));
+  // Wait for the seeded row, then time local reads.
+  while (!replica.getUserById(id)) {
+  }
+  reporter.add(measure("replica/getUserById/local", kLookups * 100,
+                       [&](std::size_t) {
+                         const auto user = replica.getUserById(id);
+                         doNotOptimize(user->id);
+                       }));
+
+  // Written through the database repository, so only the notification
+  // can bring the change; the spin measures commit-to-visible latency.
+  const auto email = database->getUserById(id)->email;
+  reporter.add(measure(
+      "replica/changeVisible", kChanges, [&](std::size_t i) {
+        const std::string name = "bench-user-" + std::to_string(i);
+        database->updateUser({id, name, email});
+        while (replica.getUserById(id)->name != name) {
+        }
+      }));
+
+  removeUser(*pool, id);
+}
+
+// The CRUD suite over several databases, e.g. the pgshard services of
+// docker-compose.yml; compare with crud/postgres. getAllUsers queries the
+// shards in parallel, so it should take about as long as on the largest
+// shard alone.
+CPPCRUDBP_BENCHMARK(postgresShardedCrudSuite) {
+  const char *urls = std::getenv("CPPCRUDBP_BENCH_PG_SHARDS");
+  if (!urls || !*urls) {
+    reporter.skip("postgresShardedCrudSuite",
+                  "set CPPCRUDBP_BENCH_PG_SHARDS to comma-separated "
+                  "Postgres URLs");
+    return;
+  }
+  const auto pools = poolsOf(urls);
+  cppcrudbp::infrastructure::ShardedUserRepository repository(pools);
+  cppcrudbp::bench::runRepositorySuite("crud/sharded", repository, reporter,
+                                       2000);
+  reporter.add(measure("sharded/getAllUsers", 20, [&](std::size_t) {
+    doNotOptimize(repository.getAllUsers().size());
+  }));
+  for (std::size_t shard = 0; shard < pools.size(); ++shard) {
+    cppcrudbp::infrastructure::PostgreUserRepository single(pools[shard]);
+    reporter.add(measure("sharded/getAllUsers/shard" + std::to_string(shard),
+                         20, [&](std::size_t) {
+                           doNotOptimize(single.getAllUsers().size());
+                         }));
+  }
+}
+
+// Reads through ReplicaRoutingUserRepository with CPPCRUDBP_BENCH_PG as the
+// primary: plain reads, which go to the replicas, and reads right after a
+// write by the same thread, which go to the primary until a replica has
+// replayed the write.
+CPPCRUDBP_BENCHMARK(postgresReadReplicas) {
+  const std::string url = cppcrudbp::bench::benchDatabaseUrl();
+  const char *urls = std::getenv("CPPCRUDBP_BENCH_PG_REPLICAS");
+  if (url.empty() || !urls || !*urls) {
+    reporter.skip("postgresReadReplicas",
+                  "set CPPCRUDBP_BENCH_PG to the primary and "
+                  "CPPCRUDBP_BENCH_PG_REPLICAS to comma-separated replica "
+                  "URLs");
+    return;
+  }
+  auto primary = std::make_shared<cppcrudbp::common::ConnectionPool>(url);
+  cppcrudbp::infrastructure::ReplicaRoutingUserRepository repository(
+      primary, poolsOf(urls));
+  const int id = seedUser(*primary);
+  // From the primary: a replica may not have replayed the row yet.
+  const auto email =
+      cppcrudbp::infrastructure::PostgreUserRepository(primary)
+          .getUserById(id)
+          ->email;
+
+  // Another thread's write does not pin this one to the primary; wait for
+  // the replicas to report in and replay the seeded row.
+  std::async(std::launch::async, [&] {
+    repository.updateUser({id, "bench-user", email});
+  }).wait();
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  reporter.add(measure("readReplicas/getUserById", kLookups,
+                       [&](std::size_t) {
+                         doNotOptimize(repository.getUserById(id));
+                       }));
+  reporter.add(measure(
+      "readReplicas/updateThenGetUserById", kLookups / 10, [&](std::size_t i) {
+        const std::string name = "bench-user-" + std::to_string(i);
+        repository.updateUser({id, name, email});
+        doNotOptimize(repository.getUserById(id));
+      }));
+  const auto stats = repository.stats();
+  std::cout << "readReplicas: " << stats.primary_reads << " primary reads, "
+            << stats.lag_fallbacks << " because of lag or own writes\n";
+  for (std::size_t i = 0; i < stats.replicas.size(); ++i) {
+    std::cout << "  replica " << i << ": " << stats.replicas[i].reads
+              << " reads, lag "
+              << (stats.replicas[i].lag
+                      ? std::to_string(stats.replicas[i].lag->count()) + " ms"
+                      : std::string("unknown"))
+              << "\n";
+  }
+  removeUser(*primary, id);
+}
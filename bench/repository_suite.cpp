@@ -0,0 +1,105 @@
+#include "repository_suite.h"
+#include <algorithm>
+#include <utility>
+#include <unistd.h>
+#include <vector>
+
+namespace cppcrudbp::bench {
+
+void runRepositorySuite(const std::string &prefix,
+                        domain::IUserRepository &repository,
+                        Reporter &reporter, std::size_t operations) {
+  const std::string tag = "suite-" + std::to_string(::getpid()) + "-";
+  std::vector<application::CreateUserRequest> users;
+  users.reserve(operations);
+  for (std::size_t i = 0; i < operations; ++i) {
+    users.push_back({"Suite User " + std::to_string(i),
+                     tag + std::to_string(i) + "@example.com"});
+  }
+
+  std::vector<application::UserResponse> created;
+  created.reserve(operations);
+  reporter.add(
+      measure(prefix + "/createUser", operations, [&](std::size_t i) {
+        if (auto user = repository.createUser(users[i])) {
+          created.push_back(std::move(*user));
+        }
+      }));
+  if (created.empty()) {
+    reporter.skip(prefix + "/*", "no user could be created");
+    return;
+  }
+
+  reporter.add(
+      measure(prefix + "/getUserById", operations, [&](std::size_t i) {
+        doNotOptimize(repository.getUserById(created[i % created.size()].id));
+      }));
+  reporter.add(
+      measure(prefix + "/getUserByEmail", operations, [&](std::size_t i) {
+        doNotOptimize(
+            repository.getUserByEmail(created[i % created.size()].email));
+      }));
+  reporter.add(
+      measure(prefix + "/getUsersPage(100)", operations, [&](std::size_t i) {
+        const int after_id = created[i % created.size()].id - 1;
+        doNotOptimize(repository.getUsersPage(after_id, 100));
+      }));
+  // Pages of 20 from a random point of the suite's names.
+  const auto search = [&](std::size_t i) {
+    const std::size_t from = (i * 2654435761u) % created.size();
+    doNotOptimize(repository.searchUsersByNamePrefix(
+        "Suite User ", {created[from].name, created[from].id}, 20));
+  };
+  reporter.add(
+      measure(prefix + "/searchUsersByNamePrefix(20)", operations, search));
+  // One call per 100 ids; compare with 100x getUserById.
+  constexpr std::size_t kIdsPerCall = 100;
+  std::vector<int> ids;
+  const auto getByIds = [&](std::size_t i) {
+    ids.clear();
+    for (std::size_t k = 0; k < kIdsPerCall; ++k) {
+      ids.push_back(created[(i * kIdsPerCall + k) % created.size()].id);
+    }
+    doNotOptimize(repository.getUsersByIds(ids));
+  };
+  reporter.add(measure(prefix + "/getUsersByIds(100)",
+                       std::max<std::size_t>(1, operations / kIdsPerCall),
+                       getByIds));
+  const std::size_t count = created.size();
+  reporter.add(measure(prefix + "/updateUser", count, [&](std::size_t i) {
+    doNotOptimize(repository.updateUser(
+        domain::User{created[i].id, "Suite User Updated", created[i].email}));
+  }));
+  // Renames every user, kUpsertBatch rows per call.
+  constexpr std::size_t kUpsertBatch = 1000;
+  for (auto &user : users) {
+    user.name += " Synced";
+  }
+  std::vector<application::CreateUserRequest> batch;
+  const auto upsert = [&](std::size_t i) {
+    const std::size_t first = i * kUpsertBatch;
+    const std::size_t last = std::min(operations, first + kUpsertBatch);
+    batch.assign(users.begin() + first, users.begin() + last);
+    doNotOptimize(repository.upsertUsers(batch));
+  };
+  reporter.add(measure(prefix + "/upsertUsers(1000)",
+                       (operations + kUpsertBatch - 1) / kUpsertBatch,
+                       upsert));
+  // The first half goes one by one, the rest kIdsPerCall at a time.
+  const std::size_t half = count / 2;
+  reporter.add(measure(prefix + "/deleteUser", half, [&](std::size_t i) {
+    doNotOptimize(repository.deleteUser(created[i].id));
+  }));
+  const auto deleteByIds = [&](std::size_t i) {
+    ids.clear();
+    const std::size_t first = half + i * kIdsPerCall;
+    for (std::size_t k = first; k < std::min(count, first + kIdsPerCall); ++k) {
+      ids.push_back(created[k].id);
+    }
+    doNotOptimize(repository.deleteUsers(ids));
+  };
+  const std::size_t batches = (count - half + kIdsPerCall - 1) / kIdsPerCall;
+  reporter.add(measure(prefix + "/deleteUsers(100)", batches, deleteByIds));
+}
+
+} // namespace cppcrudbp::bench
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "bench.h"
+#include "domain/user_repository.h"
+#include <cstddef>
+#include <string>
+
+namespace cppcrudbp::bench {
+
+/**
+ * @brief Measures create, getUserById, getUserByEmail, getUsersByIds,
+ * getUsersPage, searchUsersByNamePrefix, updateUser, upsertUsers,
+ * deleteUser and deleteUsers through the IUserRepository interface, so
+ * every engine is timed by the same code.
+ * Results are named "<prefix>/<operation>".
+ *
+ * Creates @p operations users with emails unique to this process and
+ * deletes them again by the end.
+ */
+void runRepositorySuite(const std::string &prefix,
+                        domain::IUserRepository &repository,
+                        Reporter &reporter, std::size_t operations);
+
+} // namespace cppcrudbp::bench
@@ -0,0 +1,31 @@
+#include "bench.h"
+#include "infrastructure/user_statements.h"
+#include <array>
+#include <string_view>
+
+namespace {
+
+using cppcrudbp::bench::doNotOptimize;
+using cppcrudbp::bench::measure;
+
+} // namespace
+
+// Decoding one users row from its text-format fields by position, as the
+// Postgres repositories do for every row they read.
+CPPCRUDBP_BENCHMARK(rowMapping) {
+  using cppcrudbp::application::UserResponse;
+  constexpr std::size_t kRows = 5000000;
+  const std::array<std::string_view, 3> fields = {"123456", "Alice Example",
+                                                  "alice@example.com"};
+  const auto field = [&fields](std::size_t i) { return fields[i]; };
+
+  reporter.add(measure("rowMapping/mapRow", kRows, [&](std::size_t) {
+    doNotOptimize(cppcrudbp::infrastructure::mapRow<UserResponse>(field));
+  }));
+
+  UserResponse reused;
+  reporter.add(measure("rowMapping/mapRowInto", kRows, [&](std::size_t) {
+    cppcrudbp::infrastructure::mapRowInto(reused, field);
+    doNotOptimize(reused);
+  }));
+}
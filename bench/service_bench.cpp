@@ -0,0 +1,164 @@
+#include "bench.h"
+#include "application/user_dto.h"
+#include "application/user_service.h"
+#include "infrastructure/in_memory_user_repository.h"
+#include "presentation/cli.h"
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using cppcrudbp::bench::doNotOptimize;
+using cppcrudbp::bench::measure;
+
+class NoopUnitOfWork : public cppcrudbp::domain::IUnitOfWork {
+public:
+  bool commit() override { return true; }
+  void rollback() override {}
+};
+
+// Answers every call with a fixed value, so only call overhead is timed.
+class FixedUserRepository : public cppcrudbp::domain::IUserRepository {
+public:
+  std::optional<cppcrudbp::application::UserResponse>
+  createUser(const cppcrudbp::application::CreateUserRequest &user) override {
+    return cppcrudbp::application::UserResponse{1, user.name, user.email};
+  }
+  cppcrudbp::application::BulkCreateResult bulkCreateUsers(
+      const std::vector<cppcrudbp::application::CreateUserRequest> &users)
+      override {
+    return {users.size(), {}, 0};
+  }
+  cppcrudbp::application::BulkUpsertResult upsertUsers(
+      const std::vector<cppcrudbp::application::CreateUserRequest> &users)
+      override {
+    return {0, users.size(), 0, 0};
+  }
+  std::optional<cppcrudbp::application::UserResponse>
+  getUserById(int id) override {
+    return cppcrudbp::application::UserResponse{id, "Fixed User",
+                                                "fixed@example.com"};
+  }
+  std::optional<cppcrudbp::application::UserResponse>
+  getUserByEmail(const std::string &) override {
+    return std::nullopt;
+  }
+  cppcrudbp::application::UserBatch
+  getUsersByIds(const std::vector<int> &) override {
+    return {};
+  }
+  cppcrudbp::application::UserBatch getAllUsers() override {
+    return {};
+  }
+  cppcrudbp::application::UserBatch getUsersPage(int, std::size_t) override {
+    return {};
+  }
+  cppcrudbp::application::UserBatch
+  searchUsersByNamePrefix(const std::string &,
+                          const cppcrudbp::application::NameCursor &,
+                          std::size_t) override {
+    return {};
+  }
+  bool forEachUser(const cppcrudbp::domain::UserVisitor &) override {
+    return true;
+  }
+  std::optional<cppcrudbp::application::UserResponse>
+  updateUser(const cppcrudbp::domain::User &user) override {
+    return cppcrudbp::application::toUserResponse(user);
+  }
+  std::vector<int>
+  updateUsers(const std::vector<cppcrudbp::domain::User> &users) override {
+    std::vector<int> ids;
+    for (const auto &user : users) {
+      ids.push_back(user.id);
+    }
+    return ids;
+  }
+  bool deleteUser(int) override { return true; }
+  std::vector<int> deleteUsers(const std::vector<int> &ids) override {
+    return ids;
+  }
+  std::unique_ptr<cppcrudbp::domain::IUnitOfWork> beginUnitOfWork() override {
+    return std::make_unique<NoopUnitOfWork>();
+  }
+};
+
+// Discards everything written to it.
+class NullBuffer : public std::streambuf {
+protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char *, std::streamsize n) override {
+    return n;
+  }
+};
+
+} // namespace
+
+// What UserService adds on top of a direct repository call.
+CPPCRUDBP_BENCHMARK(userServiceDispatch) {
+  constexpr std::size_t kCalls = 5000000;
+  auto repository = std::make_shared<FixedUserRepository>();
+  cppcrudbp::application::UserService service(repository);
+  std::shared_ptr<cppcrudbp::domain::IUserRepository> direct = repository;
+
+  reporter.add(
+      measure("service/repository.getUserById", kCalls, [&](std::size_t i) {
+        doNotOptimize(direct->getUserById(static_cast<int>(i)));
+      }));
+  reporter.add(
+      measure("service/UserService.getUserById", kCalls, [&](std::size_t i) {
+        doNotOptimize(service.getUserById(static_cast<int>(i)));
+      }));
+  const cppcrudbp::application::UpdateUserRequest update{1, "Fixed User",
+                                                         "fixed@example.com"};
+  reporter.add(
+      measure("service/UserService.updateUser", kCalls, [&](std::size_t) {
+        doNotOptimize(service.updateUser(update));
+      }));
+}
+
+CPPCRUDBP_BENCHMARK(toUserResponse) {
+  constexpr std::size_t kConversions = 5000000;
+  const cppcrudbp::domain::User user{42, "Conversion Benchmark User",
+                                     "conversion.benchmark@example.com"};
+  reporter.add(measure("dto/toUserResponse", kConversions, [&](std::size_t) {
+    doNotOptimize(cppcrudbp::application::toUserResponse(user));
+  }));
+}
+
+// Whole CLI path per command: parsing, dispatch and response formatting.
+CPPCRUDBP_BENCHMARK(cliBatch) {
+  constexpr std::size_t kUsers = 10000;
+  constexpr std::size_t kCommands = 200000;
+  auto repository =
+      std::make_shared<cppcrudbp::infrastructure::InMemoryUserRepository>();
+  std::vector<cppcrudbp::application::CreateUserRequest> users;
+  for (std::size_t i = 0; i < kUsers; ++i) {
+    users.push_back({"CLI User " + std::to_string(i),
+                     "cli.user." + std::to_string(i) + "@example.com"});
+  }
+  repository->bulkCreateUsers(users);
+  cppcrudbp::cli::CliAdapter cli(
+      std::make_shared<cppcrudbp::application::UserService>(repository));
+
+  std::string script;
+  for (std::size_t i = 0; i < kCommands; ++i) {
+    script += "get " + std::to_string(i % kUsers + 1) + "\n";
+  }
+  NullBuffer sink;
+  std::streambuf *const original = std::cout.rdbuf(&sink);
+  auto result = measure("cli/batch get", 1, [&](std::size_t) {
+    std::istringstream input(script);
+    cli.runBatch(input, 1);
+  });
+  std::cout.rdbuf(original);
+  // One run covers every command; report it per command.
+  result.iterations = kCommands;
+  result.ns_per_op /= static_cast<double>(kCommands);
+  reporter.add(std::move(result));
+}
@@ -0,0 +1,73 @@
+#include "bench.h"
+#include "infrastructure/in_memory_user_repository.h"
+#include "infrastructure/user_snapshot.h"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using cppcrudbp::bench::doNotOptimize;
+using cppcrudbp::bench::measure;
+using cppcrudbp::infrastructure::InMemoryUserRepository;
+using cppcrudbp::infrastructure::UserSnapshot;
+
+constexpr std::size_t kUsers = 2000000;
+
+std::vector<cppcrudbp::application::CreateUserRequest> makeUsers() {
+  std::vector<cppcrudbp::application::CreateUserRequest> users;
+  users.reserve(kUsers);
+  for (std::size_t i = 0; i < kUsers; ++i) {
+    users.push_back({"user " + std::to_string(i),
+                     "user" + std::to_string(i) + "@example.com"});
+  }
+  return users;
+}
+
+} // namespace
+
+// Warm start from a snapshot file of 2M users: mapping it, with and
+// without the checksum pass, against rebuilding the same table in memory
+// from its rows, which is what a restart without a snapshot pays before
+// the database round trips. The file sits in the page cache, as it does
+// right after a refresh.
+CPPCRUDBP_BENCHMARK(userSnapshot) {
+  const std::string path =
+      "/tmp/cppcrudbp_bench_" + std::to_string(::getpid()) + ".snap";
+  const auto users = makeUsers();
+  InMemoryUserRepository source(kUsers);
+  source.bulkCreateUsers(users);
+
+  reporter.add(measure("snapshot/write(2M)", 1, [&](std::size_t) {
+    doNotOptimize(UserSnapshot::write(path, source));
+  }));
+  std::shared_ptr<const UserSnapshot> snapshot;
+  reporter.add(measure("snapshot/openVerified(2M)", 5, [&](std::size_t) {
+    snapshot = UserSnapshot::open(path);
+  }));
+  std::cout << "snapshot file bytes/user: " << snapshot->bytes() / kUsers
+            << "\n";
+  reporter.add(measure("snapshot/openUnverified(2M)", 5, [&](std::size_t) {
+    doNotOptimize(UserSnapshot::open(path, false));
+  }));
+  reporter.add(measure("snapshot/inMemoryRebuild(2M)", 1, [&](std::size_t) {
+    InMemoryUserRepository rebuilt(kUsers);
+    doNotOptimize(rebuilt.bulkCreateUsers(users));
+  }));
+
+  // Pseudo-random ids so lookups are not prefetch-friendly.
+  reporter.add(measure("snapshot/find", kUsers, [&](std::size_t i) {
+    const int id = static_cast<int>((i * 2654435761u) % kUsers) + 1;
+    doNotOptimize(snapshot->find(id));
+  }));
+  reporter.add(measure("snapshot/inMemoryGetUserById", kUsers,
+                       [&](std::size_t i) {
+                         const int id = static_cast<int>(
+                                            (i * 2654435761u) % kUsers) +
+                                        1;
+                         doNotOptimize(source.getUserById(id));
+                       }));
+  std::remove(path.c_str());
+}
@@ -0,0 +1,114 @@
+#include "bench.h"
+#include "common/connection_pool.h"
+#include "infrastructure/in_memory_user_repository.h"
+#include "infrastructure/postgre_user_repository.h"
+#include "infrastructure/write_behind_user_repository.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using cppcrudbp::bench::doNotOptimize;
+using cppcrudbp::bench::measure;
+using cppcrudbp::infrastructure::WriteBehindUserRepository;
+
+// Bursty traffic: every update lands on one of a few hot users.
+constexpr std::size_t kHotUsers = 16;
+
+std::vector<int> seedHotUsers(cppcrudbp::domain::IUserRepository &repository,
+                              const std::string &tag) {
+  std::vector<int> ids;
+  for (std::size_t i = 0; i < kHotUsers; ++i) {
+    const auto user = repository.createUser(
+        {"hot " + std::to_string(i), tag + std::to_string(i) + "-" +
+                                         std::to_string(::getpid()) +
+                                         "@example.com"});
+    ids.push_back(user->id);
+  }
+  return ids;
+}
+
+cppcrudbp::domain::User hotUpdate(const std::vector<int> &ids,
+                                  const std::string &tag, std::size_t i) {
+  const std::size_t hot = i % ids.size();
+  return {ids[hot], "hot " + std::to_string(i),
+          tag + std::to_string(hot) + "-" + std::to_string(::getpid()) +
+              "@example.com"};
+}
+
+void printStats(const std::string &name,
+                const WriteBehindUserRepository &repo) {
+  const auto stats = repo.stats();
+  std::cout << name << ": " << stats.updates << " updates, "
+            << stats.coalescingRatio() << " per row written, "
+            << stats.flushes << " flushes, mean flush "
+            << (stats.flushes ? stats.flush_time.count() / 1000 /
+                                    static_cast<long long>(stats.flushes)
+                              : 0)
+            << " us, max " << stats.max_flush_time.count() / 1000 << " us\n";
+}
+
+} // namespace
+
+// Per-call cost of queuing an update against applying it in memory, and
+// how many rows the queue writes for a burst on a few users. Queuing costs
+// about what the in-memory update does, a hash map insert under a mutex;
+// the gain is in front of a repository that makes a round trip per write.
+CPPCRUDBP_BENCHMARK(writeBehindQueue) {
+  constexpr std::size_t kUpdates = 1000000;
+  auto memory =
+      std::make_shared<cppcrudbp::infrastructure::InMemoryUserRepository>();
+  const auto ids = seedHotUsers(*memory, "queue");
+  reporter.add(measure("writeBehind/inMemory/direct", kUpdates,
+                       [&](std::size_t i) {
+                         doNotOptimize(
+                             memory->updateUser(hotUpdate(ids, "queue", i)));
+                       }));
+  WriteBehindUserRepository queued(memory);
+  reporter.add(measure("writeBehind/inMemory/queued", kUpdates,
+                       [&](std::size_t i) {
+                         doNotOptimize(
+                             queued.updateUser(hotUpdate(ids, "queue", i)));
+                       }));
+  queued.flush();
+  printStats("writeBehind/inMemory", queued);
+}
+
+// A burst of updates to a few users, one transaction each versus queued
+// and written in batches; the queued run ends with a flush, so both have
+// stored every update when timing stops.
+CPPCRUDBP_BENCHMARK(postgresWriteBehind) {
+  const std::string url = cppcrudbp::bench::benchDatabaseUrl();
+  if (url.empty()) {
+    reporter.skip("postgresWriteBehind",
+                  "set CPPCRUDBP_BENCH_PG to a Postgres URL");
+    return;
+  }
+  constexpr std::size_t kUpdates = 5000;
+  auto database =
+      std::make_shared<cppcrudbp::infrastructure::PostgreUserRepository>(
+          std::make_shared<cppcrudbp::common::ConnectionPool>(url));
+  const auto ids = seedHotUsers(*database, "write-behind");
+
+  reporter.add(measure("writeBehind/postgres/direct", kUpdates,
+                       [&](std::size_t i) {
+                         doNotOptimize(database->updateUser(
+                             hotUpdate(ids, "write-behind", i)));
+                       }));
+  {
+    WriteBehindUserRepository queued(database);
+    reporter.add(measure("writeBehind/postgres/queued", kUpdates,
+                         [&](std::size_t i) {
+                           doNotOptimize(queued.updateUser(
+                               hotUpdate(ids, "write-behind", i)));
+                           if (i + 1 == kUpdates) {
+                             queued.flush();
+                           }
+                         }));
+    printStats("writeBehind/postgres", queued);
+  }
+  database->deleteUsers(ids);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "application/user_batch.h"
+#include "application/user_dto.h"
+#include "domain/async_user_repository.h"
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace cppcrudbp::application {
+
+/**
+ * @brief UserService for callers that keep many requests in flight.
+ * Each call returns immediately with a future for its result.
+ */
+class AsyncUserService {
+public:
+  explicit AsyncUserService(
+      std::shared_ptr<cppcrudbp::domain::IAsyncUserRepository> repository);
+
+  std::future<std::optional<application::UserResponse>>
+  createUser(const application::CreateUserRequest &user);
+  std::future<std::optional<application::UserResponse>> getUserById(int id);
+  std::future<application::UserBatch> getUsersPage(int after_id,
+                                                  std::size_t limit);
+  std::future<std::optional<application::UserResponse>>
+  updateUser(const application::UpdateUserRequest &user);
+  std::future<bool> deleteUser(int id);
+
+private:
+  std::shared_ptr<cppcrudbp::domain::IAsyncUserRepository> repository_;
+};
+
+} // namespace cppcrudbp::application
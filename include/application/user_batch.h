@@ -0,0 +1,108 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cppcrudbp::application {
+
+/**
+ * @brief Non-owning view of one user, e.g. an entry of a UserBatch.
+ */
+struct UserView {
+  int id;
+  std::string_view name;
+  std::string_view email;
+};
+
+/**
+ * @brief A list of users stored column-wise: the ids in one array, and
+ * every name and email packed back to back in a single text buffer.
+ *
+ * Filling it takes a few allocations however many users it holds, not
+ * two strings per user, and needs about half the memory of the
+ * equivalent std::vector<UserResponse>. Views returned by operator[] point
+ * into the buffer and are invalidated by the next push_back().
+ */
+class UserBatch {
+public:
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = UserView;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = UserView;
+
+    const_iterator(const UserBatch *batch, std::size_t index)
+        : batch_(batch), index_(index) {}
+
+    UserView operator*() const { return (*batch_)[index_]; }
+    const_iterator &operator++() {
+      ++index_;
+      return *this;
+    }
+    bool operator==(const const_iterator &other) const {
+      return index_ == other.index_;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return index_ != other.index_;
+    }
+
+  private:
+    const UserBatch *batch_;
+    std::size_t index_;
+  };
+
+  UserBatch() = default;
+
+  /**
+   * @param text_bytes Total length of the names and emails to come, if
+   * known; the buffer then never reallocates.
+   */
+  void reserve(std::size_t users, std::size_t text_bytes = 0);
+
+  /** @throws std::length_error past 4 GiB of text. */
+  void push_back(int id, std::string_view name, std::string_view email);
+  void push_back(const UserView &user) {
+    push_back(user.id, user.name, user.email);
+  }
+  void clear();
+
+  [[nodiscard]] std::size_t size() const { return ids_.size(); }
+  [[nodiscard]] bool empty() const { return ids_.empty(); }
+
+  UserView operator[](std::size_t i) const {
+    return UserView{ids_[i], text(offsets_[2 * i], offsets_[2 * i + 1]),
+                    text(offsets_[2 * i + 1], offsets_[2 * i + 2])};
+  }
+  [[nodiscard]] UserView back() const { return (*this)[size() - 1]; }
+  [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+  [[nodiscard]] const_iterator end() const { return {this, size()}; }
+
+  /** @brief Every id, in batch order. */
+  [[nodiscard]] const std::vector<int> &ids() const { return ids_; }
+
+  /** @brief An owning copy of entry @p i. */
+  [[nodiscard]] UserResponse user(std::size_t i) const;
+
+  /** @brief Bytes held, buffer capacity included. */
+  [[nodiscard]] std::size_t memoryBytes() const;
+
+private:
+  std::string_view text(std::uint32_t begin, std::uint32_t end) const {
+    return std::string_view(text_.data() + begin, end - begin);
+  }
+
+  std::vector<int> ids_;
+  // Entry i's name is text_[offsets_[2i], offsets_[2i+1]) and its email
+  // text_[offsets_[2i+1], offsets_[2i+2]).
+  std::vector<std::uint32_t> offsets_{0};
+  std::string text_;
+};
+
+} // namespace cppcrudbp::application
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "domain/user.h"
+#include <cstddef>
 #include <optional>
 #include <stdexcept>
 #include <string>
@@ -37,6 +38,38 @@ struct UserResponse {
   std::string email;
 };
 
+/**
+ * @brief Keyset cursor for pages ordered by name, then id: the last user
+ * of the previous page. The default value starts at the first page.
+ */
+struct NameCursor {
+  std::string name;
+  int id = 0;
+};
+
+/**
+ * @brief Outcome of a bulk user import.
+ * Rows whose email already exists, or repeats an earlier row of the same
+ * batch, are skipped and reported instead of failing the whole batch.
+ */
+struct BulkCreateResult {
+  std::size_t inserted = 0;
+  std::vector<std::string> rejected_emails;
+  std::size_t failed = 0; // Rows lost to a batch-level error.
+};
+
+/**
+ * @brief Outcome of a bulk upsert keyed on email.
+ * When an email repeats within the batch, its last row wins; the counts are
+ * per distinct email.
+ */
+struct BulkUpsertResult {
+  std::size_t inserted = 0;
+  std::size_t updated = 0;
+  std::size_t unchanged = 0; // Already stored with the same name.
+  std::size_t failed = 0;    // Rows lost to a batch-level error.
+};
+
 /**
  * @brief Helper function to convert a Domain::Entities::User to a UserResponse
  * DTO.
@@ -1,10 +1,13 @@
 #pragma once
 
+#include "application/user_batch.h"
 #include "application/user_dto.h"
 #include "domain/user.h"
 #include "domain/user_repository.h"
+#include <cstddef>
 #include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 
 namespace cppcrudbp::application {
@@ -14,11 +17,34 @@ public:
   explicit UserService(
       std::shared_ptr<cppcrudbp::domain::IUserRepository> repository);
 
-  bool createUser(const application::CreateUserRequest &user);
+  std::optional<application::UserResponse>
+  createUser(const application::CreateUserRequest &user);
+  application::BulkCreateResult
+  bulkCreateUsers(const std::vector<application::CreateUserRequest> &users);
+  application::BulkUpsertResult
+  upsertUsers(const std::vector<application::CreateUserRequest> &users);
   std::optional<application::UserResponse> getUserById(int id);
-  std::vector<application::UserResponse> getAllUsers();
-  bool updateUser(const application::UpdateUserRequest &user);
+  std::optional<application::UserResponse>
+  getUserByEmail(const std::string &email);
+  application::UserBatch getUsersByIds(const std::vector<int> &ids);
+  application::UserBatch getAllUsers();
+  application::UserBatch getUsersPage(int after_id, std::size_t limit);
+  application::UserBatch
+  searchUsersByNamePrefix(const std::string &prefix,
+                          const application::NameCursor &after,
+                          std::size_t limit);
+  bool forEachUser(const domain::UserVisitor &visitor);
+  std::optional<application::UserResponse>
+  updateUser(const application::UpdateUserRequest &user);
   bool deleteUser(int id);
+  std::vector<int> deleteUsers(const std::vector<int> &ids);
+
+  /**
+   * @brief Groups the calls this thread makes until the returned unit of
+   * work is committed or destroyed into one transaction.
+   * @return nullptr if one could not be started.
+   */
+  std::unique_ptr<domain::IUnitOfWork> beginUnitOfWork();
 
 private:
   std::shared_ptr<cppcrudbp::domain::IUserRepository> repository_;
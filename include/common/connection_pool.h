@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <pqxx/pqxx>
+#include <string>
+#include <vector>
+
+namespace cppcrudbp::common {
+
+/**
+ * @brief Sizing and health-check settings for a ConnectionPool.
+ */
+struct ConnectionPoolOptions {
+  std::size_t min_size = 1; // Connections opened eagerly and kept warm.
+  std::size_t max_size = 8; // Hard cap on simultaneously open connections.
+  std::chrono::milliseconds acquire_timeout{5000};
+  // Idle connections older than this are pinged before being handed out.
+  std::chrono::milliseconds health_check_after{30000};
+};
+
+/**
+ * @brief Snapshot of the pool counters, see ConnectionPool::stats().
+ */
+struct ConnectionPoolStats {
+  std::size_t open = 0;
+  std::size_t idle = 0;
+  std::size_t in_use = 0;
+  std::uint64_t acquisitions = 0;
+  std::uint64_t timeouts = 0;
+  std::uint64_t connections_opened = 0;
+  std::uint64_t reconnects = 0;
+  std::uint64_t total_wait_us = 0;
+  std::uint64_t max_wait_us = 0;
+};
+
+/**
+ * @brief Thread-safe pool of pqxx connections.
+ *
+ * Callers check a connection out with acquire() and get it back through the
+ * returned Lease, which hands the connection back to the pool when it goes
+ * out of scope. Connections found closed on return are dropped and replaced
+ * on demand; idle connections are pinged before reuse.
+ */
+class ConnectionPool {
+  struct Slot;
+
+public:
+  /**
+   * @brief RAII handle to a checked-out connection.
+   */
+  class Lease {
+  public:
+    Lease(Lease &&other) noexcept;
+    Lease &operator=(Lease &&other) noexcept;
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+    ~Lease();
+
+    pqxx::connection &operator*() const;
+    pqxx::connection *operator->() const;
+
+    /**
+     * @brief Prepares @p name on this connection unless it already was.
+     *
+     * Preparation is remembered per physical connection, so a statement is
+     * sent to the server once per connection and again after a reconnect.
+     */
+    void prepare(const std::string &name, const std::string &sql);
+
+    /**
+     * @brief Marks the connection as unusable so it is discarded, not
+     * recycled, when the lease is released.
+     */
+    void invalidate() noexcept { broken_ = true; }
+
+  private:
+    friend class ConnectionPool;
+    Lease(ConnectionPool *pool, std::unique_ptr<Slot> slot);
+    void release() noexcept;
+
+    ConnectionPool *pool_;
+    std::unique_ptr<Slot> slot_;
+    bool broken_ = false;
+  };
+
+  explicit ConnectionPool(std::string connection_string,
+                          ConnectionPoolOptions options = {});
+  ~ConnectionPool();
+
+  ConnectionPool(const ConnectionPool &) = delete;
+  ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+  /**
+   * @brief Checks out a healthy connection, blocking up to acquire_timeout.
+   * @throws std::runtime_error if no connection becomes available in time or
+   * a new connection cannot be opened.
+   */
+  [[nodiscard]] Lease acquire();
+
+  [[nodiscard]] ConnectionPoolStats stats() const;
+
+  [[nodiscard]] const std::string &connectionString() const {
+    return connection_string_;
+  }
+
+  [[nodiscard]] const ConnectionPoolOptions &options() const {
+    return options_;
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::unique_ptr<Slot> connect();
+  void ensureHealthy(Slot &slot);
+  void release(std::unique_ptr<Slot> slot, bool broken) noexcept;
+
+  const std::string connection_string_;
+  const ConnectionPoolOptions options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable available_;
+  std::vector<std::unique_ptr<Slot>> idle_;
+  std::size_t open_ = 0;
+  std::size_t in_use_ = 0;
+  ConnectionPoolStats counters_;
+};
+
+} // namespace cppcrudbp::common
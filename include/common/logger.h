@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace cppcrudbp::common {
+
+enum class LogLevel : std::uint8_t { kDebug, kInfo, kWarning, kError };
+
+/** @brief "debug", "info", "warning" or "error". */
+std::string_view toString(LogLevel level);
+/** @brief The level named @p name, as printed by toString(). */
+std::optional<LogLevel> parseLogLevel(std::string_view name);
+
+struct LoggerOptions {
+  // Queued records; rounded up to a power of two. When every slot is
+  // taken, new records are dropped rather than waited for.
+  std::size_t capacity = 1024;
+  LogLevel min_level = LogLevel::kInfo;
+  // Records from one call site beyond rate_burst per rate_window are
+  // suppressed and only counted.
+  std::size_t rate_burst = 10;
+  std::chrono::milliseconds rate_window{1000};
+  // Written by the logger's thread, or under its lock once stopped.
+  std::ostream *sink = nullptr; // nullptr: std::cerr.
+};
+
+struct LoggerStats {
+  std::uint64_t written = 0;
+  std::uint64_t dropped = 0;    // Queue full.
+  std::uint64_t suppressed = 0; // Rate-limited.
+};
+
+/**
+ * @brief Asynchronous structured logger.
+ *
+ * log() formats nothing and takes no lock: it claims a slot of a bounded
+ * multi-producer ring with one compare-and-swap, copies the message parts
+ * into it (truncated to kMaxMessage bytes) and returns. A background thread
+ * drains the ring and writes one logfmt line per record, e.g.
+ *
+ * @code
+ * ts=2024-05-01T12:00:00.123Z level=error component=postgres msg="..."
+ * @endcode
+ *
+ * A call site is its component and first message part, normally the fixed
+ * text naming the failure, so an error storm from one site costs a hash and
+ * a compare-and-swap per call once its burst is spent. Drops and
+ * suppressions are reported by the writer in a periodic warning line.
+ */
+class Logger {
+public:
+  static constexpr std::size_t kMaxMessage = 472;
+
+  /**
+   * @brief The process-wide logger, flushed and stopped at exit. Records
+   * logged after that are written synchronously.
+   */
+  static Logger &global();
+
+  explicit Logger(LoggerOptions options = {});
+  /** @brief Writes every queued record, then stops the writer thread. */
+  ~Logger();
+
+  Logger(const Logger &) = delete;
+  Logger &operator=(const Logger &) = delete;
+
+  void setMinLevel(LogLevel level) {
+    min_level_.store(level, std::memory_order_relaxed);
+  }
+  [[nodiscard]] bool enabled(LogLevel level) const {
+    return level >= min_level_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @param component A string literal, e.g. "postgres"; kept by pointer.
+   * @param parts Concatenated to form the message.
+   */
+  void write(LogLevel level, const char *component,
+             std::initializer_list<std::string_view> parts);
+
+  template <typename... Parts>
+  void log(LogLevel level, const char *component, const Parts &...parts) {
+    if (enabled(level)) {
+      write(level, component, {std::string_view(parts)...});
+    }
+  }
+
+  /** @brief Blocks until every record queued so far has been written. */
+  void flush();
+  /** @brief flush(), then stops the writer; later records are synchronous. */
+  void stop();
+
+  [[nodiscard]] LoggerStats stats() const;
+
+private:
+  struct Slot;
+
+  bool allow(std::uint64_t site, std::chrono::steady_clock::time_point now);
+  [[nodiscard]] bool hasRecord() const;
+  /** @brief Formats the oldest record onto @p out and frees its slot. */
+  bool popInto(std::string &out);
+  void reportLosses(std::string &out);
+  void writeOut(const std::string &text);
+  void run();
+
+  const LoggerOptions options_;
+  std::ostream &sink_;
+  std::atomic<LogLevel> min_level_;
+
+  std::size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+  alignas(64) std::size_t dequeue_pos_ = 0; // Writer thread only.
+  // Per call-site bucket: site tag, window number and count packed into
+  // one word so a producer updates it with a single compare-and-swap.
+  std::unique_ptr<std::atomic<std::uint64_t>[]> rate_buckets_;
+
+  alignas(64) std::atomic<std::uint64_t> written_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+  std::atomic<std::uint64_t> suppressed_{0};
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable drained_;
+  std::atomic<bool> idle_{false};
+  bool stopping_ = false;        // mutex_
+  std::size_t flushed_pos_ = 0;  // mutex_
+  std::atomic<bool> stopped_{false};
+  std::mutex sink_mutex_;
+  std::uint64_t reported_dropped_ = 0;    // Writer thread only.
+  std::uint64_t reported_suppressed_ = 0; // Writer thread only.
+  std::chrono::steady_clock::time_point last_report_;
+  std::thread writer_;
+};
+
+/** @brief Logs to Logger::global(). */
+template <typename... Parts>
+void logError(const char *component, const Parts &...parts) {
+  Logger::global().log(LogLevel::kError, component, parts...);
+}
+template <typename... Parts>
+void logWarning(const char *component, const Parts &...parts) {
+  Logger::global().log(LogLevel::kWarning, component, parts...);
+}
+
+} // namespace cppcrudbp::common
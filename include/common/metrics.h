@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace cppcrudbp::common {
+
+/**
+ * @brief Log-linear latency buckets in nanoseconds, HdrHistogram style.
+ *
+ * Values below 16 ns get a bucket each; above that every power of two is
+ * split into 16 sub-buckets, so a bucket spans at most 1/16 (~6%) of its
+ * value. Values of 2^36 ns (~69 s) and up share the last bucket.
+ */
+struct LatencyBuckets {
+  static constexpr std::size_t kSubBuckets = 16;
+  static constexpr std::size_t kCount = 33 * kSubBuckets;
+
+  static std::size_t indexOf(std::uint64_t ns);
+  /** @brief Largest value that lands in bucket @p index. */
+  static std::uint64_t upperBound(std::size_t index);
+};
+
+/**
+ * @brief Merged view of one histogram.
+ */
+struct LatencySnapshot {
+  std::array<std::uint64_t, LatencyBuckets::kCount> buckets{};
+  std::uint64_t count = 0;
+  std::uint64_t sum_ns = 0;
+  std::uint64_t max_ns = 0;
+
+  /** @brief Upper bound of the bucket holding quantile @p q in [0, 1]. */
+  [[nodiscard]] std::uint64_t quantileNs(double q) const;
+  [[nodiscard]] double meanNs() const {
+    return count ? static_cast<double>(sum_ns) / static_cast<double>(count)
+                 : 0.0;
+  }
+};
+
+/**
+ * @brief Totals for one operation, summed over every thread.
+ */
+struct OperationStats {
+  std::string layer;     // e.g. "service", "repository", "http".
+  std::string operation; // e.g. "getUserById".
+  std::uint64_t calls = 0;
+  std::uint64_t errors = 0;
+  std::uint64_t rows = 0;
+  std::uint64_t bytes = 0; // Response bytes serialized.
+  LatencySnapshot latency;
+};
+
+using MetricId = std::size_t;
+
+/**
+ * @brief Process-wide registry of per-operation counters and histograms.
+ *
+ * Each thread records into its own shard with plain relaxed loads and
+ * stores, so recording takes no lock and causes no cache-line sharing
+ * between threads. snapshot() sums all shards; it may miss the few
+ * recordings racing with it but never blocks writers. A shard left by an
+ * exiting thread is reused, counts included, by the next new thread.
+ */
+class Metrics {
+public:
+  static constexpr std::size_t kMaxOperations = 64;
+
+  static Metrics &global();
+
+  Metrics(const Metrics &) = delete;
+  Metrics &operator=(const Metrics &) = delete;
+
+  /**
+   * @brief Returns the id for @p layer / @p operation, registering it on
+   * first use. Meant for start-up; takes a lock.
+   * @throws std::length_error past kMaxOperations distinct operations.
+   */
+  MetricId registerOperation(const std::string &layer,
+                             const std::string &operation);
+
+  void record(MetricId id, std::chrono::nanoseconds latency, bool failed,
+              std::uint64_t rows, std::uint64_t bytes);
+
+  [[nodiscard]] std::vector<OperationStats> snapshot() const;
+
+private:
+  struct Counters;
+  struct Shard;
+  friend struct ShardLease;
+
+  Metrics() = default;
+  ~Metrics();
+
+  Shard &localShard();
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Shard>> shards_;                  // mutex_
+  std::vector<std::pair<std::string, std::string>> operations_; // mutex_
+};
+
+/**
+ * @brief Times one call and records it when it goes out of scope.
+ * A call left by an exception counts as an error.
+ */
+class OperationTimer {
+public:
+  explicit OperationTimer(MetricId id)
+      : id_(id), exceptions_(std::uncaught_exceptions()),
+        start_(std::chrono::steady_clock::now()) {}
+  ~OperationTimer() {
+    Metrics::global().record(
+        id_, std::chrono::steady_clock::now() - start_,
+        failed_ || std::uncaught_exceptions() > exceptions_, rows_, bytes_);
+  }
+
+  OperationTimer(const OperationTimer &) = delete;
+  OperationTimer &operator=(const OperationTimer &) = delete;
+
+  /** @brief Marks the call failed unless @p ok; returns @p ok. */
+  bool check(bool ok) {
+    failed_ = failed_ || !ok;
+    return ok;
+  }
+  void fail() { failed_ = true; }
+  void addRows(std::uint64_t rows) { rows_ += rows; }
+  void addBytes(std::uint64_t bytes) { bytes_ += bytes; }
+
+private:
+  MetricId id_;
+  int exceptions_;
+  std::chrono::steady_clock::time_point start_;
+  bool failed_ = false;
+  std::uint64_t rows_ = 0;
+  std::uint64_t bytes_ = 0;
+};
+
+/**
+ * @brief Writes @p stats in the Prometheus text exposition format: a
+ * cppcrudbp_operation_duration_seconds histogram plus calls, errors, rows
+ * and bytes counters, labelled by layer and operation.
+ */
+void writePrometheus(const std::vector<OperationStats> &stats,
+                     std::ostream &out);
+
+} // namespace cppcrudbp::common
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cppcrudbp::common {
+
+/**
+ * @brief Linear-probing hash index from a key hash to a 32-bit record number.
+ *
+ * Keys live in the caller's records, not in the index: each slot holds only
+ * a 32-bit tag of the hash and the record number, i.e. 8 bytes per slot.
+ * Lookups compare tags first and call the caller's matcher to confirm.
+ * Erase uses backward shifting, so no tombstones accumulate.
+ */
+class OpenAddressingIndex {
+public:
+  static constexpr std::uint32_t kNoRecord = UINT32_MAX;
+
+  explicit OpenAddressingIndex(std::size_t expected = 0) { reserve(expected); }
+
+  /**
+   * @brief Returns the record matching @p hash and @p match, or kNoRecord.
+   * @param match Called with a candidate record number; returns true if that
+   * record holds the key being looked up.
+   */
+  template <typename Match>
+  [[nodiscard]] std::uint32_t find(std::uint64_t hash, Match &&match) const {
+    if (slots_.empty()) {
+      return kNoRecord;
+    }
+    const std::uint32_t tag = tagOf(hash);
+    for (std::size_t i = tag & mask_;; i = (i + 1) & mask_) {
+      const Slot &slot = slots_[i];
+      if (slot.record == kNoRecord) {
+        return kNoRecord;
+      }
+      if (slot.tag == tag && match(slot.record)) {
+        return slot.record;
+      }
+    }
+  }
+
+  /**
+   * @brief Adds @p record under @p hash. The key must not be present yet.
+   */
+  void insert(std::uint64_t hash, std::uint32_t record) {
+    if ((size_ + 1) * 10 > slots_.size() * 7) { // Load factor 0.7.
+      rehash(slots_.empty() ? 16 : slots_.size() * 2);
+    }
+    place(Slot{tagOf(hash), record});
+    ++size_;
+  }
+
+  /**
+   * @brief Removes the entry matching @p hash and @p match.
+   * @return false if there was none.
+   */
+  template <typename Match> bool erase(std::uint64_t hash, Match &&match) {
+    if (slots_.empty()) {
+      return false;
+    }
+    const std::uint32_t tag = tagOf(hash);
+    std::size_t i = tag & mask_;
+    for (;; i = (i + 1) & mask_) {
+      if (slots_[i].record == kNoRecord) {
+        return false;
+      }
+      if (slots_[i].tag == tag && match(slots_[i].record)) {
+        break;
+      }
+    }
+    // Shift later members of the probe run back into the hole.
+    for (std::size_t j = (i + 1) & mask_; slots_[j].record != kNoRecord;
+         j = (j + 1) & mask_) {
+      const std::size_t home = slots_[j].tag & mask_;
+      const bool movable = (i <= j) ? (home <= i || home > j)
+                                    : (home <= i && home > j);
+      if (movable) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+    slots_[i] = Slot{0, kNoRecord};
+    --size_;
+    return true;
+  }
+
+  void reserve(std::size_t expected) {
+    std::size_t capacity = 16;
+    while (capacity * 7 < expected * 10) {
+      capacity *= 2;
+    }
+    if (capacity > slots_.size()) {
+      rehash(capacity);
+    }
+  }
+
+  void clear() {
+    slots_.assign(slots_.size(), Slot{0, kNoRecord});
+    size_ = 0;
+  }
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+  [[nodiscard]] std::size_t memoryBytes() const {
+    return slots_.capacity() * sizeof(Slot);
+  }
+
+private:
+  struct Slot {
+    std::uint32_t tag;
+    std::uint32_t record;
+  };
+
+  static std::uint32_t tagOf(std::uint64_t hash) {
+    return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+  }
+
+  void place(Slot slot) {
+    std::size_t i = slot.tag & mask_;
+    while (slots_[i].record != kNoRecord) {
+      i = (i + 1) & mask_;
+    }
+    slots_[i] = slot;
+  }
+
+  void rehash(std::size_t capacity) {
+    std::vector<Slot> old(capacity, Slot{0, kNoRecord});
+    old.swap(slots_);
+    mask_ = capacity - 1;
+    for (const Slot &slot : old) {
+      if (slot.record != kNoRecord) {
+        place(slot);
+      }
+    }
+  }
+
+  std::vector<Slot> slots_;
+  std::size_t mask_ = 0;
+  std::size_t size_ = 0;
+};
+
+} // namespace cppcrudbp::common
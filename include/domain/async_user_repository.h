@@ -0,0 +1,36 @@
+#pragma once
+
+#include "application/user_batch.h"
+#include "application/user_dto.h"
+#include "user.h"
+#include <cstddef>
+#include <future>
+#include <optional>
+#include <vector>
+
+namespace cppcrudbp::domain {
+
+/**
+ * @brief Non-blocking counterpart of IUserRepository for point operations.
+ *
+ * Every call queues its query and returns at once; the future becomes ready
+ * when the result arrives. Failures are reported the same way as the
+ * blocking repository (false, nullopt or an empty page), not as exceptions
+ * stored in the future. Streaming and bulk reads stay on IUserRepository.
+ */
+class IAsyncUserRepository {
+public:
+  virtual ~IAsyncUserRepository() = default;
+
+  virtual std::future<std::optional<application::UserResponse>>
+  createUser(const application::CreateUserRequest &user) = 0;
+  virtual std::future<std::optional<application::UserResponse>>
+  getUserById(int id) = 0;
+  virtual std::future<application::UserBatch>
+  getUsersPage(int after_id, std::size_t limit) = 0;
+  virtual std::future<std::optional<application::UserResponse>>
+  updateUser(const User &user) = 0;
+  virtual std::future<bool> deleteUser(int id) = 0;
+};
+
+} // namespace cppcrudbp::domain
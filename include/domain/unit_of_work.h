@@ -0,0 +1,26 @@
+#pragma once
+
+namespace cppcrudbp::domain {
+
+/**
+ * @brief A group of repository operations that commit or roll back together.
+ *
+ * Obtained from IUserRepository::beginUnitOfWork(). While it is open, every
+ * call the opening thread makes on that repository runs inside it; calls
+ * from other threads are unaffected. It must be closed on the thread that
+ * opened it. Destroying it without commit() rolls it back.
+ */
+class IUnitOfWork {
+public:
+  virtual ~IUnitOfWork() = default;
+
+  /**
+   * @brief Makes every write since the unit of work began durable.
+   * @return false if it was rolled back instead, e.g. because an operation
+   * inside it failed.
+   */
+  virtual bool commit() = 0;
+  virtual void rollback() = 0;
+};
+
+} // namespace cppcrudbp::domain
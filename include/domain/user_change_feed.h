@@ -0,0 +1,45 @@
+#pragma once
+
+#include "user.h"
+#include <cstdint>
+#include <functional>
+
+namespace cppcrudbp::domain {
+
+/**
+ * @brief One committed change to the stored users.
+ */
+struct UserChange {
+  enum class Kind { kInsert, kUpdate, kDelete, kTruncate };
+
+  Kind kind;
+  // The user as read once the change was committed: only the id is set
+  // for kDelete, or if the user was deleted again meanwhile; nothing is
+  // for kTruncate, which removes every user.
+  User user;
+};
+
+/**
+ * @brief Called for each change, in commit order, on the feed's own
+ * thread. It should return quickly: later changes wait for it.
+ */
+using UserChangeListener = std::function<void(const UserChange &)>;
+
+/**
+ * @brief A live feed of the changes made to the stored users, by this
+ * process or any other.
+ */
+class IUserChangeFeed {
+public:
+  virtual ~IUserChangeFeed() = default;
+
+  /** @return A handle for unsubscribe(). */
+  virtual std::uint64_t subscribe(UserChangeListener listener) = 0;
+  /**
+   * @brief Stops calls to the listener; once it returns, none is running.
+   * Must not be called from inside a listener.
+   */
+  virtual void unsubscribe(std::uint64_t subscription) = 0;
+};
+
+} // namespace cppcrudbp::domain
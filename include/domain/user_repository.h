@@ -1,21 +1,137 @@
 #pragma once
 
+#include "application/user_batch.h"
 #include "application/user_dto.h"
+#include "unit_of_work.h"
 #include "user.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 
 namespace cppcrudbp::domain {
 
+/**
+ * @brief Callback receiving users one at a time from a streaming read.
+ * The referenced object is only valid for the duration of the call.
+ */
+using UserVisitor = std::function<void(const application::UserResponse &)>;
+
 class IUserRepository {
 public:
   virtual ~IUserRepository() = default;
 
-  virtual bool createUser(const application::CreateUserRequest &user) = 0;
+  /**
+   * @return The stored user, id included, or nullopt if it could not be
+   * created (e.g. the email is taken).
+   */
+  virtual std::optional<application::UserResponse>
+  createUser(const application::CreateUserRequest &user) = 0;
+
+  /**
+   * @brief Inserts many users in a single round trip.
+   * Duplicate emails are reported in the result rather than aborting the
+   * batch; any other failure rejects the batch as a whole.
+   */
+  virtual application::BulkCreateResult
+  bulkCreateUsers(const std::vector<application::CreateUserRequest> &users) = 0;
+
+  /**
+   * @brief Inserts new emails and renames existing ones, in one round trip
+   * per batch; running the same batch twice changes nothing the second
+   * time.
+   */
+  virtual application::BulkUpsertResult
+  upsertUsers(const std::vector<application::CreateUserRequest> &users) = 0;
+
   virtual std::optional<application::UserResponse> getUserById(int id) = 0;
-  virtual std::vector<application::UserResponse> getAllUsers() = 0;
-  virtual bool updateUser(const User &user) = 0;
+  /** @return The user with exactly this email, if any. */
+  virtual std::optional<application::UserResponse>
+  getUserByEmail(const std::string &email) = 0;
+
+  /**
+   * @brief Looks up every id in @p ids in a single round trip.
+   * @return The users found, once each, ordered by id; ids with no user are
+   * left out.
+   */
+  virtual application::UserBatch getUsersByIds(const std::vector<int> &ids) = 0;
+
+  /**
+   * @brief getUserById for callers that must tell a failed read from a
+   * missing user, e.g. to cache the answer.
+   * @throws std::exception if the read failed, where getUserById returns
+   * nullopt. Repositories that never fail, or cannot tell, keep this
+   * default, which calls getUserById.
+   */
+  virtual std::optional<application::UserResponse> findUserById(int id) {
+    return getUserById(id);
+  }
+  /** @brief getUsersByIds, throwing if the read failed; see findUserById. */
+  virtual application::UserBatch findUsersByIds(const std::vector<int> &ids) {
+    return getUsersByIds(ids);
+  }
+  virtual application::UserBatch getAllUsers() = 0;
+
+  /**
+   * @brief Keyset pagination over users ordered by id.
+   * @param after_id Only users with an id greater than this are returned;
+   * pass 0 for the first page and the last id seen for the next one.
+   * @param limit Maximum number of users in the page.
+   */
+  virtual application::UserBatch
+  getUsersPage(int after_id, std::size_t limit) = 0;
+
+  /**
+   * @brief Keyset pagination over the users whose name starts with
+   * @p prefix, ordered by name and then id. Names compare byte by byte
+   * (case-sensitive, code point order for UTF-8).
+   * @param after Only users ordered after it are returned; pass {} for the
+   * first page and the page's last user for the next one.
+   * @param limit Maximum number of users in the page.
+   */
+  virtual application::UserBatch
+  searchUsersByNamePrefix(const std::string &prefix,
+                          const application::NameCursor &after,
+                          std::size_t limit) = 0;
+
+  /**
+   * @brief Streams every user to @p visitor in id order, holding at most one
+   * row in memory at a time.
+   * @return false if the read failed part-way through.
+   */
+  virtual bool forEachUser(const UserVisitor &visitor) = 0;
+  /**
+   * @return The user as stored after the update, or nullopt if no user has
+   * that id or the update failed.
+   */
+  virtual std::optional<application::UserResponse>
+  updateUser(const User &user) = 0;
+  /**
+   * @brief Applies every update in @p users in as few round trips as the
+   * repository allows; of several updates to one id, the last wins.
+   * @return The ids updated, ascending; ids with no user, or whose update
+   * was rejected (e.g. the email is taken), are left out. A failed round
+   * trip leaves out all the ids it carried.
+   */
+  virtual std::vector<int> updateUsers(const std::vector<User> &users) = 0;
+  /** @return true only if a user with @p id existed and was deleted. */
   virtual bool deleteUser(int id) = 0;
+
+  /**
+   * @brief Deletes every id in @p ids in a single round trip.
+   * @return The ids actually deleted, ascending; empty on failure.
+   */
+  virtual std::vector<int> deleteUsers(const std::vector<int> &ids) = 0;
+
+  /**
+   * @brief Opens a unit of work on this repository for the calling thread.
+   * Without one, every call is its own transaction.
+   * @return nullptr if it could not be started, including when the thread
+   * already has one open on this repository.
+   */
+  virtual std::unique_ptr<IUnitOfWork> beginUnitOfWork() = 0;
 };
 
 } // namespace cppcrudbp::domain
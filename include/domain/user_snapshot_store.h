@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace cppcrudbp::domain {
+
+/**
+ * @brief Outcome of saving or loading a snapshot.
+ */
+struct SnapshotInfo {
+  std::string path;
+  std::size_t users = 0;
+  std::size_t bytes = 0; // File size.
+  std::chrono::nanoseconds elapsed{0};
+};
+
+/**
+ * @brief Saves the stored users to a snapshot file, and serves reads from
+ * one, so a restarted process starts warm.
+ */
+class IUserSnapshotStore {
+public:
+  virtual ~IUserSnapshotStore() = default;
+
+  /**
+   * @brief Writes every stored user to @p path, replacing it atomically.
+   * @throws std::runtime_error on failure.
+   */
+  virtual SnapshotInfo saveSnapshot(const std::string &path) = 0;
+  /**
+   * @brief Serves reads from the snapshot at @p path from now on.
+   * @throws std::runtime_error if it is not a valid snapshot.
+   */
+  virtual SnapshotInfo loadSnapshot(const std::string &path) = 0;
+};
+
+} // namespace cppcrudbp::domain
@@ -0,0 +1,59 @@
+#pragma once
+
+namespace cppcrudbp::infrastructure {
+
+/**
+ * @brief Links a unit of work into a per-thread list so the repository that
+ * opened it can find it on later calls, without passing it through the
+ * IUserRepository interface.
+ *
+ * @tparam Derived The unit of work class (CRTP); each class keeps its own
+ * list per thread.
+ */
+template <typename Derived> class ActiveUnitOfWork {
+public:
+  ActiveUnitOfWork(const ActiveUnitOfWork &) = delete;
+  ActiveUnitOfWork &operator=(const ActiveUnitOfWork &) = delete;
+
+  /**
+   * @brief Innermost open unit of work started by @p owner on this thread,
+   * or nullptr.
+   */
+  static Derived *find(const void *owner) {
+    for (ActiveUnitOfWork *unit = head(); unit; unit = unit->next_) {
+      if (unit->owner_ == owner) {
+        return static_cast<Derived *>(unit);
+      }
+    }
+    return nullptr;
+  }
+
+protected:
+  explicit ActiveUnitOfWork(const void *owner)
+      : owner_(owner), next_(head()) {
+    head() = this;
+  }
+  ~ActiveUnitOfWork() { deactivate(); }
+
+  /** @brief Stops routing the owner's calls here; idempotent. */
+  void deactivate() {
+    for (ActiveUnitOfWork **link = &head(); *link; link = &(*link)->next_) {
+      if (*link == this) {
+        *link = next_;
+        break;
+      }
+    }
+    next_ = nullptr;
+  }
+
+private:
+  static ActiveUnitOfWork *&head() {
+    thread_local ActiveUnitOfWork *list = nullptr;
+    return list;
+  }
+
+  const void *owner_;
+  ActiveUnitOfWork *next_;
+};
+
+} // namespace cppcrudbp::infrastructure
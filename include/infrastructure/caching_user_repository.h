@@ -0,0 +1,138 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include "domain/user.h"
+#include "domain/user_repository.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cppcrudbp::infrastructure {
+
+class CachingUnitOfWork;
+
+/**
+ * @brief Sizing of the CachingUserRepository.
+ */
+struct UserCacheOptions {
+  std::size_t capacity = 100000; // Total entries across all shards.
+  std::size_t shards = 16;
+  // How long a "no such user" answer is trusted.
+  std::chrono::milliseconds negative_ttl{5000};
+};
+
+/**
+ * @brief Counter snapshot, see CachingUserRepository::stats().
+ */
+struct UserCacheStats {
+  std::uint64_t hits = 0;
+  std::uint64_t negative_hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t evictions = 0;
+  std::uint64_t invalidations = 0;
+  std::size_t entries = 0;
+};
+
+/**
+ * @brief Read-through cache in front of any IUserRepository.
+ *
+ * getUserById and getUsersByIds are served from a sharded, bounded LRU
+ * keyed by id; getUsersByIds fetches all of its misses with one call to the
+ * wrapped repository. Misses are read with findUserById and findUsersByIds
+ * and cached too, for negative_ttl or until the next create, whichever
+ * comes first; a read that failed is not cached, as far as the wrapped
+ * repository tells it apart (see IUserRepository::findUserById).
+ * updateUser, updateUsers, deleteUser and deleteUsers invalidate the ids;
+ * upsertUsers does not report which ids it renamed, so it empties the
+ * cache. Every other operation goes straight to the wrapped repository.
+ *
+ * Inside a unit of work, reads bypass the cache: they may see writes that
+ * are not committed yet, so they are neither served from nor stored in it.
+ * Ids written in it are invalidated again when it ends, since other
+ * threads may have cached the old row in the meantime.
+ */
+class CachingUserRepository : public cppcrudbp::domain::IUserRepository {
+public:
+  explicit CachingUserRepository(
+      std::shared_ptr<cppcrudbp::domain::IUserRepository> inner,
+      UserCacheOptions options = {});
+
+  std::optional<application::UserResponse>
+  createUser(const application::CreateUserRequest &user) override;
+  application::BulkCreateResult bulkCreateUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  application::BulkUpsertResult upsertUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  std::optional<application::UserResponse> getUserById(int id) override;
+  std::optional<application::UserResponse>
+  getUserByEmail(const std::string &email) override;
+  application::UserBatch getUsersByIds(const std::vector<int> &ids) override;
+  std::optional<application::UserResponse> findUserById(int id) override;
+  application::UserBatch findUsersByIds(const std::vector<int> &ids) override;
+  application::UserBatch getAllUsers() override;
+  application::UserBatch getUsersPage(int after_id, std::size_t limit) override;
+  application::UserBatch
+  searchUsersByNamePrefix(const std::string &prefix,
+                          const application::NameCursor &after,
+                          std::size_t limit) override;
+  bool forEachUser(const domain::UserVisitor &visitor) override;
+  std::optional<application::UserResponse>
+  updateUser(const cppcrudbp::domain::User &user) override;
+  std::vector<int>
+  updateUsers(const std::vector<cppcrudbp::domain::User> &users) override;
+  bool deleteUser(int id) override;
+  std::vector<int> deleteUsers(const std::vector<int> &ids) override;
+  std::unique_ptr<domain::IUnitOfWork> beginUnitOfWork() override;
+
+  [[nodiscard]] UserCacheStats stats() const;
+
+private:
+  friend class CachingUnitOfWork;
+
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    int id;
+    std::optional<application::UserResponse> user; // nullopt: known missing
+    Clock::time_point expires;                      // negatives only
+    std::uint64_t creates_seen;                     // negatives only
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::list<Entry> lru; // Most recently used first.
+    std::unordered_map<int, std::list<Entry>::iterator> index;
+    std::uint64_t epoch = 0; // Bumped on every invalidation.
+  };
+
+  Shard &shardFor(int id);
+  bool lookup(Shard &shard, int id,
+              std::optional<application::UserResponse> &user,
+              std::uint64_t &epoch);
+  void store(Shard &shard, std::uint64_t epoch, std::uint64_t creates_seen,
+             const std::optional<application::UserResponse> &user, int id);
+  void invalidate(int id);
+  void invalidateAll();
+
+  std::shared_ptr<cppcrudbp::domain::IUserRepository> inner_;
+  const UserCacheOptions options_;
+  std::size_t shard_capacity_;
+  std::unique_ptr<Shard[]> shards_;
+
+  std::atomic<std::uint64_t> creates_{0};
+  std::atomic<std::uint64_t> hits_{0};
+  std::atomic<std::uint64_t> negative_hits_{0};
+  std::atomic<std::uint64_t> misses_{0};
+  std::atomic<std::uint64_t> evictions_{0};
+  std::atomic<std::uint64_t> invalidations_{0};
+};
+
+} // namespace cppcrudbp::infrastructure
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include "common/open_addressing_index.h"
+#include "domain/user.h"
+#include "domain/user_repository.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cppcrudbp::infrastructure {
+
+class InMemoryUnitOfWork;
+
+/**
+ * @brief IUserRepository kept entirely in process memory.
+ *
+ * Users are stored in one id-ordered vector. Two open-addressing indexes
+ * point into it: one by id, and one by email that enforces the same UNIQUE
+ * constraint as sql/schema.sql. An ordered (name, id) set serves name-prefix
+ * searches. Ids are assigned like SERIAL, starting at 1.
+ * A shared mutex lets readers run concurrently. Deleted records stay in
+ * place until enough of them pile up to justify a compaction.
+ *
+ * Units of work keep an undo log: writes apply immediately and are visible
+ * to other threads, and rollback reverts them. That gives atomicity but
+ * not isolation, which is enough for a single writer. Undoing a write that
+ * a concurrent writer has since built on can fail; rollback skips it.
+ *
+ * Used where no database is wanted: local runs, tests and benchmark
+ * baselines.
+ */
+class InMemoryUserRepository : public cppcrudbp::domain::IUserRepository {
+public:
+  explicit InMemoryUserRepository(std::size_t expected_users = 0);
+
+  std::optional<application::UserResponse>
+  createUser(const application::CreateUserRequest &user) override;
+  application::BulkCreateResult bulkCreateUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  application::BulkUpsertResult upsertUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  std::optional<application::UserResponse> getUserById(int id) override;
+  std::optional<application::UserResponse>
+  getUserByEmail(const std::string &email) override;
+  application::UserBatch getUsersByIds(const std::vector<int> &ids) override;
+  application::UserBatch getAllUsers() override;
+  application::UserBatch getUsersPage(int after_id, std::size_t limit) override;
+  application::UserBatch
+  searchUsersByNamePrefix(const std::string &prefix,
+                          const application::NameCursor &after,
+                          std::size_t limit) override;
+  bool forEachUser(const domain::UserVisitor &visitor) override;
+  std::optional<application::UserResponse>
+  updateUser(const cppcrudbp::domain::User &user) override;
+  std::vector<int>
+  updateUsers(const std::vector<cppcrudbp::domain::User> &users) override;
+  bool deleteUser(int id) override;
+  std::vector<int> deleteUsers(const std::vector<int> &ids) override;
+  std::unique_ptr<domain::IUnitOfWork> beginUnitOfWork() override;
+
+  [[nodiscard]] std::size_t size() const;
+  /**
+   * @brief Approximate bytes held, including index slots and string heap.
+   */
+  [[nodiscard]] std::size_t memoryBytes() const;
+
+private:
+  friend class InMemoryUnitOfWork;
+
+  struct Record {
+    int id;
+    bool live;
+    std::string name;
+    std::string email;
+  };
+
+  static std::uint64_t hashId(int id);
+  static std::uint64_t hashEmail(std::string_view email);
+
+  std::uint32_t findByIdLocked(int id) const;
+  std::uint32_t findByEmailLocked(std::string_view email) const;
+  std::uint32_t findRecordLocked(int id) const; // Dead records included.
+  bool insertLocked(const application::CreateUserRequest &user);
+  bool updateLocked(std::uint32_t record, const std::string &name,
+                    const std::string &email);
+  void eraseLocked(std::uint32_t record);
+  void compactLocked();
+
+  mutable std::shared_mutex mutex_;
+  std::vector<Record> records_; // Ascending id; may hold dead records.
+  common::OpenAddressingIndex by_id_;
+  common::OpenAddressingIndex by_email_;
+  // Ids survive compaction, unlike record positions.
+  std::set<std::pair<std::string, int>> by_name_;
+  std::size_t live_ = 0;
+  int next_id_ = 1;
+  // Compaction would drop records an open unit of work may revive.
+  std::size_t open_units_ = 0;
+};
+
+} // namespace cppcrudbp::infrastructure
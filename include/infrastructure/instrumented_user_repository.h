@@ -0,0 +1,67 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include "common/metrics.h"
+#include "domain/user.h"
+#include "domain/user_repository.h"
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cppcrudbp::infrastructure {
+
+/**
+ * @brief Records latency, errors and rows of every call to the wrapped
+ * repository in common::Metrics, under the given layer label.
+ *
+ * Wrap the storage engine directly to measure storage alone; the service
+ * layer records its own totals, cache included.
+ */
+class InstrumentedUserRepository : public cppcrudbp::domain::IUserRepository {
+public:
+  explicit InstrumentedUserRepository(
+      std::shared_ptr<cppcrudbp::domain::IUserRepository> inner,
+      const std::string &layer = "repository");
+
+  std::optional<application::UserResponse>
+  createUser(const application::CreateUserRequest &user) override;
+  application::BulkCreateResult bulkCreateUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  application::BulkUpsertResult upsertUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  std::optional<application::UserResponse> getUserById(int id) override;
+  std::optional<application::UserResponse>
+  getUserByEmail(const std::string &email) override;
+  application::UserBatch getUsersByIds(const std::vector<int> &ids) override;
+  std::optional<application::UserResponse> findUserById(int id) override;
+  application::UserBatch findUsersByIds(const std::vector<int> &ids) override;
+  application::UserBatch getAllUsers() override;
+  application::UserBatch getUsersPage(int after_id, std::size_t limit) override;
+  application::UserBatch
+  searchUsersByNamePrefix(const std::string &prefix,
+                          const application::NameCursor &after,
+                          std::size_t limit) override;
+  bool forEachUser(const domain::UserVisitor &visitor) override;
+  std::optional<application::UserResponse>
+  updateUser(const cppcrudbp::domain::User &user) override;
+  std::vector<int>
+  updateUsers(const std::vector<cppcrudbp::domain::User> &users) override;
+  bool deleteUser(int id) override;
+  std::vector<int> deleteUsers(const std::vector<int> &ids) override;
+  /** @brief Also times the unit of work's commit, as "commitUnitOfWork". */
+  std::unique_ptr<domain::IUnitOfWork> beginUnitOfWork() override;
+
+private:
+  struct Ids {
+    common::MetricId create, bulk_create, upsert, get_by_id, get_by_email,
+        get_by_ids, get_all, get_page, search_by_name, for_each, update,
+        update_many, remove, remove_many, begin, commit;
+  };
+
+  std::shared_ptr<cppcrudbp::domain::IUserRepository> inner_;
+  Ids ids_;
+};
+
+} // namespace cppcrudbp::infrastructure
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include "domain/async_user_repository.h"
+#include "domain/user.h"
+#include "infrastructure/user_statements.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cppcrudbp::infrastructure {
+
+struct PipelineOptions {
+  std::size_t connections = 2;
+  std::size_t max_in_flight = 1024; // Per connection.
+  std::chrono::milliseconds reconnect_interval{1000};
+  // How long a reconnect may take before it is abandoned.
+  std::chrono::milliseconds connect_timeout{5000};
+};
+
+/**
+ * @brief IAsyncUserRepository over libpq pipeline mode.
+ *
+ * A single event-loop thread owns a few non-blocking connections. Queries
+ * are sent as they are submitted, without waiting for earlier answers, so
+ * each connection carries up to max_in_flight of them at once; results are
+ * matched back to their futures in order. Every query is followed by its
+ * own sync point, so one failing statement does not abort its neighbours.
+ * Futures are completed on the event-loop thread.
+ *
+ * A lost connection is reopened by the event loop without blocking it:
+ * the handshake is driven by PQconnectPoll as its socket becomes ready,
+ * and the statements are prepared through the pipeline itself, ahead of
+ * the first queries sent on the new connection.
+ */
+class PipelinedUserRepository
+    : public cppcrudbp::domain::IAsyncUserRepository {
+public:
+  /**
+   * @throws std::runtime_error if the initial connections cannot be opened.
+   */
+  explicit PipelinedUserRepository(std::string connection_string,
+                                   PipelineOptions options = {});
+  ~PipelinedUserRepository() override;
+
+  PipelinedUserRepository(const PipelinedUserRepository &) = delete;
+  PipelinedUserRepository &operator=(const PipelinedUserRepository &) = delete;
+
+  std::future<std::optional<application::UserResponse>>
+  createUser(const application::CreateUserRequest &user) override;
+  std::future<std::optional<application::UserResponse>>
+  getUserById(int id) override;
+  std::future<application::UserBatch>
+  getUsersPage(int after_id, std::size_t limit) override;
+  std::future<std::optional<application::UserResponse>>
+  updateUser(const cppcrudbp::domain::User &user) override;
+  std::future<bool> deleteUser(int id) override;
+
+private:
+  struct Operation;
+  struct Connection;
+
+  // Queues @p statement and returns a future fulfilled with decode(result),
+  // where result is null if the query failed.
+  template <typename T, typename Decode>
+  std::future<T> enqueue(const PreparedStatement &statement,
+                         std::vector<std::string> params, const char *context,
+                         Decode decode);
+
+  void eventLoop();
+  void dispatch(std::deque<std::unique_ptr<Operation>> &backlog);
+  bool send(Connection &conn, std::unique_ptr<Operation> &op);
+  bool readResults(Connection &conn);
+  // Sends buffered output; false if the connection failed.
+  bool flush(Connection &conn);
+  void disconnect(Connection &conn);
+  // Starts a non-blocking connect; false if it failed at once.
+  bool startConnect(Connection &conn);
+  // Advances a connect in progress when its socket is ready.
+  void continueConnect(Connection &conn);
+  // Switches an open connection to pipeline mode and queues the prepares.
+  bool startSession(Connection &conn);
+  // Sets the epoll interest of the connection's current socket.
+  void watch(Connection &conn, std::uint32_t events);
+
+  std::string connection_string_;
+  PipelineOptions options_;
+  std::vector<std::unique_ptr<Connection>> connections_;
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+
+  std::mutex mutex_;
+  std::deque<std::unique_ptr<Operation>> submitted_; // Guarded by mutex_.
+  bool stopping_ = false;                            // Guarded by mutex_.
+  std::thread loop_;
+};
+
+} // namespace cppcrudbp::infrastructure
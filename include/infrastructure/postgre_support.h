@@ -0,0 +1,159 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include "common/connection_pool.h"
+#include "common/logger.h"
+#include "domain/unit_of_work.h"
+#include "infrastructure/active_unit_of_work.h"
+#include "infrastructure/row_mapping.h"
+#include "infrastructure/user_statements.h"
+#include <cstddef>
+#include <optional>
+#include <pqxx/pqxx>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Internal to the libpqxx repositories (PostgreUserRepository,
+// ShardedUserRepository, ReplicatedUserRepository); not part of their API.
+
+namespace cppcrudbp::infrastructure::postgre_support {
+
+using Lease = common::ConnectionPool::Lease;
+
+/** @brief Field reader for mapRow over one row; NULL reads as nullopt. */
+inline auto fieldsOf(const pqxx::row &row) {
+  return [&row](std::size_t column) -> std::optional<std::string_view> {
+    const pqxx::field field = row[column];
+    if (field.is_null()) {
+      return std::nullopt;
+    }
+    return field.view();
+  };
+}
+
+inline application::UserResponse rowToUser(const pqxx::row &row) {
+  return mapRow<application::UserResponse>(fieldsOf(row));
+}
+
+/** @brief Decodes without copying: the views point into @p row. */
+inline application::UserView rowToView(const pqxx::row &row) {
+  return mapRow<application::UserView>(fieldsOf(row));
+}
+
+/** @brief Prepares the statement on the leased connection if needed and
+ * runs it. */
+template <typename... Args>
+pqxx::result execPrepared(Lease &conn, pqxx::transaction_base &txn,
+                          const PreparedStatement &statement,
+                          Args &&...args) {
+  conn.prepare(statement.name, statement.sql);
+  return txn.exec_prepared(statement.name, std::forward<Args>(args)...);
+}
+
+/**
+ * @brief One transaction on one leased connection, shared by every call its
+ * thread makes on the repository that opened it until it is committed or
+ * rolled back.
+ */
+class PostgreUnitOfWork final : public domain::IUnitOfWork,
+                                public ActiveUnitOfWork<PostgreUnitOfWork> {
+public:
+  PostgreUnitOfWork(const void *owner, Lease conn)
+      : ActiveUnitOfWork(owner), conn_(std::move(conn)) {
+    txn_.emplace(**conn_);
+  }
+  ~PostgreUnitOfWork() override { rollback(); }
+
+  bool commit() override {
+    if (!txn_ || failed_) {
+      rollback();
+      return false;
+    }
+    try {
+      txn_->commit();
+      finish();
+      return true;
+    } catch (const std::exception &e) {
+      common::logError("postgres", "Error committing unit of work: ", e.what());
+      conn_->invalidate(); // The outcome may be unknown; don't reuse it.
+      finish();
+      return false;
+    }
+  }
+
+  void rollback() override {
+    if (!txn_) {
+      return;
+    }
+    try {
+      txn_->abort();
+    } catch (const std::exception &e) {
+      common::logError("postgres", "Error rolling back unit of work: ",
+                       e.what());
+      conn_->invalidate();
+    }
+    finish();
+  }
+
+  Lease &connection() { return *conn_; }
+  pqxx::work &transaction() { return *txn_; }
+  // The server rejects everything after a failed statement until rollback.
+  void markFailed() { failed_ = true; }
+
+private:
+  void finish() {
+    deactivate();
+    txn_.reset();
+    conn_.reset();
+  }
+
+  std::optional<Lease> conn_;
+  std::optional<pqxx::work> txn_;
+  bool failed_ = false;
+};
+
+/**
+ * @brief Runs body(lease, transaction) in the calling thread's unit of work
+ * on @p owner if one is open. Otherwise runs it in a Txn on a connection
+ * leased from @p pool and commits when it returns.
+ */
+template <typename Txn, typename Body>
+auto inTransaction(common::ConnectionPool &pool, const void *owner,
+                   Body &&body) {
+  if (PostgreUnitOfWork *unit = PostgreUnitOfWork::find(owner)) {
+    try {
+      return body(unit->connection(),
+                  static_cast<pqxx::transaction_base &>(unit->transaction()));
+    } catch (...) {
+      unit->markFailed();
+      throw;
+    }
+  }
+  auto conn = pool.acquire();
+  Txn txn(*conn);
+  auto result = body(conn, static_cast<pqxx::transaction_base &>(txn));
+  txn.commit();
+  return result;
+}
+
+/**
+ * @brief COPYs @p users into the staging table, then runs @p move_sql with
+ * @p params, which moves them into users, in @p txn.
+ */
+template <typename... Params>
+pqxx::result
+importStaged(pqxx::transaction_base &txn,
+             const std::vector<application::CreateUserRequest> &users,
+             const char *move_sql, Params &&...params) {
+  txn.exec(user_statements::kCreateImportStaging);
+  auto stream =
+      pqxx::stream_to::table(txn, {"users_import"}, {"name", "email"});
+  for (const auto &user : users) {
+    stream.write_values(user.name, user.email);
+  }
+  stream.complete();
+  return txn.exec_params(move_sql, std::forward<Params>(params)...);
+}
+
+} // namespace cppcrudbp::infrastructure::postgre_support
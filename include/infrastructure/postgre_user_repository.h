@@ -6,22 +6,55 @@
 #include <memory>
 #include <pqxx/pqxx>
 
-#include "common/db_connection.h"
+#include "common/connection_pool.h"
 
 namespace cppcrudbp::infrastructure {
 
+/**
+ * @brief IUserRepository over PostgreSQL.
+ *
+ * Outside a unit of work every call is a single statement in autocommit
+ * mode, so it costs one round trip and holds no transaction open; only the
+ * bulk import needs an explicit one. Inside a unit of work all calls share
+ * its connection and transaction.
+ */
 class PostgreUserRepository : public cppcrudbp::domain::IUserRepository {
 public:
+  /**
+   * @param pool Pool each operation leases its connection from, so
+   * concurrent callers run on separate connections.
+   */
   explicit PostgreUserRepository(
-      const std::shared_ptr<cppcrudbp::common::DBConnection> &conn);
-  bool createUser(const application::CreateUserRequest &user) override;
+      std::shared_ptr<cppcrudbp::common::ConnectionPool> pool);
+  std::optional<application::UserResponse>
+  createUser(const application::CreateUserRequest &user) override;
+  application::BulkCreateResult bulkCreateUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  application::BulkUpsertResult upsertUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
   std::optional<application::UserResponse> getUserById(int id) override;
-  std::vector<application::UserResponse> getAllUsers() override;
-  bool updateUser(const cppcrudbp::domain::User &user) override;
+  std::optional<application::UserResponse>
+  getUserByEmail(const std::string &email) override;
+  application::UserBatch getUsersByIds(const std::vector<int> &ids) override;
+  std::optional<application::UserResponse> findUserById(int id) override;
+  application::UserBatch findUsersByIds(const std::vector<int> &ids) override;
+  application::UserBatch getAllUsers() override;
+  application::UserBatch getUsersPage(int after_id, std::size_t limit) override;
+  application::UserBatch
+  searchUsersByNamePrefix(const std::string &prefix,
+                          const application::NameCursor &after,
+                          std::size_t limit) override;
+  bool forEachUser(const domain::UserVisitor &visitor) override;
+  std::optional<application::UserResponse>
+  updateUser(const cppcrudbp::domain::User &user) override;
+  std::vector<int>
+  updateUsers(const std::vector<cppcrudbp::domain::User> &users) override;
   bool deleteUser(int id) override;
+  std::vector<int> deleteUsers(const std::vector<int> &ids) override;
+  std::unique_ptr<domain::IUnitOfWork> beginUnitOfWork() override;
 
 private:
-  std::shared_ptr<common::DBConnection> db_connection_;
+  std::shared_ptr<common::ConnectionPool> pool_;
 };
 
 } // namespace cppcrudbp::infrastructure
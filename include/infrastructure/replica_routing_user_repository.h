@@ -0,0 +1,164 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include "common/connection_pool.h"
+#include "domain/user.h"
+#include "domain/user_repository.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cppcrudbp::infrastructure {
+
+/**
+ * @brief Tuning of the ReplicaRoutingUserRepository.
+ */
+struct ReadRoutingOptions {
+  // Replicas further behind the primary than this get no reads.
+  std::chrono::milliseconds max_lag{1000};
+  // How often the primary's and the replicas' WAL positions are read.
+  std::chrono::milliseconds poll_interval{100};
+  // Bound on each position read (statement_timeout) and on opening the
+  // monitor's connections (connect_timeout, in whole seconds, at least 2).
+  std::chrono::milliseconds probe_timeout{1000};
+};
+
+/**
+ * @brief State of one read replica, see
+ * ReplicaRoutingUserRepository::stats().
+ */
+struct ReadReplicaStats {
+  // How far behind the primary it is, or nullopt if it was never seen
+  // current (e.g. unreachable).
+  std::optional<std::chrono::milliseconds> lag;
+  std::uint64_t reads = 0;
+  std::size_t outstanding = 0; // Reads in progress.
+};
+
+/**
+ * @brief Counter snapshot, see ReplicaRoutingUserRepository::stats().
+ */
+struct ReadRoutingStats {
+  std::uint64_t primary_reads = 0;
+  // Primary reads made because no replica was current enough.
+  std::uint64_t lag_fallbacks = 0;
+  std::vector<ReadReplicaStats> replicas;
+};
+
+/**
+ * @brief Sends writes to a primary database and reads to its streaming
+ * replicas.
+ *
+ * A monitor thread reads the primary's WAL position every poll_interval,
+ * and one thread per replica reads its replay position as often; a replica
+ * that has replayed past a sample of the primary is known to hold every
+ * commit made before that sample was taken. The monitors use connections
+ * of their own, outside the pools, bounded by probe_timeout, so neither a
+ * busy pool nor a slow replica holds back the other replicas' readings.
+ * A read goes to the replica with the fewest reads in progress among
+ * those current to within max_lag, and to the primary if there is none.
+ *
+ * Reads see the calling thread's own writes: after a write, that thread's
+ * reads only go to replicas known to hold it, and to the primary until
+ * one does. The HTTP adapter keeps each connection on one worker thread,
+ * so a client sees its writes on its next request over the same
+ * connection. Inside a unit of work, which is always on the primary, every
+ * call goes there.
+ */
+class ReplicaRoutingUserRepository : public cppcrudbp::domain::IUserRepository {
+public:
+  /**
+   * @param primary Pool of the database taking the writes.
+   * @param replicas Pools of its streaming replicas; a database that is
+   * not in recovery is treated as always current.
+   * @throws std::invalid_argument if a pool is null, there is no replica,
+   * or max_lag does not exceed poll_interval.
+   */
+  ReplicaRoutingUserRepository(
+      std::shared_ptr<cppcrudbp::common::ConnectionPool> primary,
+      std::vector<std::shared_ptr<cppcrudbp::common::ConnectionPool>> replicas,
+      ReadRoutingOptions options = {});
+  /** @brief Stops the monitor thread. */
+  ~ReplicaRoutingUserRepository() override;
+
+  ReplicaRoutingUserRepository(const ReplicaRoutingUserRepository &) = delete;
+  ReplicaRoutingUserRepository &
+  operator=(const ReplicaRoutingUserRepository &) = delete;
+
+  std::optional<application::UserResponse>
+  createUser(const application::CreateUserRequest &user) override;
+  application::BulkCreateResult bulkCreateUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  application::BulkUpsertResult upsertUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  std::optional<application::UserResponse> getUserById(int id) override;
+  std::optional<application::UserResponse>
+  getUserByEmail(const std::string &email) override;
+  application::UserBatch getUsersByIds(const std::vector<int> &ids) override;
+  application::UserBatch getAllUsers() override;
+  application::UserBatch getUsersPage(int after_id, std::size_t limit) override;
+  application::UserBatch
+  searchUsersByNamePrefix(const std::string &prefix,
+                          const application::NameCursor &after,
+                          std::size_t limit) override;
+  bool forEachUser(const domain::UserVisitor &visitor) override;
+  std::optional<application::UserResponse>
+  updateUser(const cppcrudbp::domain::User &user) override;
+  std::vector<int>
+  updateUsers(const std::vector<cppcrudbp::domain::User> &users) override;
+  bool deleteUser(int id) override;
+  std::vector<int> deleteUsers(const std::vector<int> &ids) override;
+  std::unique_ptr<domain::IUnitOfWork> beginUnitOfWork() override;
+
+  [[nodiscard]] ReadRoutingStats stats() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+  struct Replica;
+  class ReadLease;
+  friend class RoutingUnitOfWork;
+
+  /** @brief Picks where this thread's next read goes. */
+  ReadLease route();
+  /** @brief Records that this thread wrote, as of now. */
+  void noteWrite();
+
+  /** @brief Waits for the next poll; false once stopping. */
+  bool waitPoll();
+  void samplePrimary();
+  void monitorReplica(std::size_t index);
+  /** @brief Newest primary sample at or below @p position, if any. */
+  std::optional<Clock::time_point> sampleAt(std::int64_t position);
+
+  std::unique_ptr<cppcrudbp::domain::IUserRepository> primary_;
+  std::shared_ptr<cppcrudbp::common::ConnectionPool> primary_pool_;
+  std::vector<std::unique_ptr<Replica>> replicas_;
+  const ReadRoutingOptions options_;
+
+  // Primary WAL positions and when each was read, oldest first.
+  std::mutex samples_mutex_;
+  std::deque<std::pair<Clock::time_point, std::int64_t>>
+      samples_; // samples_mutex_
+  std::atomic<std::size_t> next_replica_{0}; // Tie-break rotation.
+
+  std::atomic<std::uint64_t> primary_reads_{0};
+  std::atomic<std::uint64_t> lag_fallbacks_{0};
+
+  std::mutex state_mutex_;
+  std::condition_variable state_changed_;
+  bool stopping_ = false; // state_mutex_
+
+  std::thread monitor_; // Samples the primary; each Replica has its own.
+};
+
+} // namespace cppcrudbp::infrastructure
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include "domain/user.h"
+#include "domain/user_change_feed.h"
+#include "domain/user_repository.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <pqxx/pqxx>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cppcrudbp::infrastructure {
+
+/**
+ * @brief Tuning of the ReplicatedUserRepository.
+ */
+struct UserReplicaOptions {
+  // Channel the users trigger notifies, see sql/migrations.
+  std::string channel = "users_changes";
+  // How often the listener confirms that it holds every committed change.
+  std::chrono::milliseconds heartbeat{250};
+  // Reads go to the database once the replica has not been confirmed
+  // current for this long, e.g. while the listener reconnects.
+  std::chrono::milliseconds max_staleness{2000};
+  std::chrono::milliseconds reconnect_delay{1000};
+};
+
+/**
+ * @brief Counter snapshot, see ReplicatedUserRepository::stats().
+ */
+struct UserReplicaStats {
+  std::uint64_t local_reads = 0;
+  std::uint64_t fallback_reads = 0; // Replica stale or in a unit of work.
+  std::uint64_t changes = 0;        // Notifications applied.
+  std::uint64_t reloads = 0;        // Full loads of the table.
+  std::size_t users = 0;
+};
+
+/**
+ * @brief Local copy of the users table, kept current through LISTEN/NOTIFY.
+ *
+ * A listener thread LISTENs on its own connection, loads the whole table,
+ * then re-reads the rows named by each notification of the users trigger.
+ * Every heartbeat it makes a round trip on that connection: the server
+ * delivers the notifications of all transactions committed before it
+ * ahead of the reply, so afterwards the replica is known to be current as
+ * of the round trip's start. While that is at most max_staleness ago,
+ * getUserById, getUsersByIds, getAllUsers, getUsersPage and forEachUser are
+ * answered from memory; otherwise they go to the wrapped repository, as do
+ * every other read and all writes.
+ *
+ * Successful single-row writes outside a unit of work are applied locally
+ * at once, so a caller reads its own writes, and a re-read that started
+ * before such a write does not overwrite it: the row is read again the
+ * next round instead. Bulk writes and units of work
+ * show up with their notifications. Reads inside a unit of work bypass the
+ * replica, which holds committed rows only. The same notifications feed
+ * subscribe().
+ */
+class ReplicatedUserRepository : public cppcrudbp::domain::IUserRepository,
+                                 public cppcrudbp::domain::IUserChangeFeed {
+public:
+  /**
+   * @param inner Repository over the same database, e.g. a
+   * PostgreUserRepository.
+   * @param connection_string Database the listener connects to.
+   */
+  ReplicatedUserRepository(
+      std::shared_ptr<cppcrudbp::domain::IUserRepository> inner,
+      std::string connection_string, UserReplicaOptions options = {});
+  /** @brief Stops the listener thread. */
+  ~ReplicatedUserRepository() override;
+
+  ReplicatedUserRepository(const ReplicatedUserRepository &) = delete;
+  ReplicatedUserRepository &
+  operator=(const ReplicatedUserRepository &) = delete;
+
+  std::optional<application::UserResponse>
+  createUser(const application::CreateUserRequest &user) override;
+  application::BulkCreateResult bulkCreateUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  application::BulkUpsertResult upsertUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  std::optional<application::UserResponse> getUserById(int id) override;
+  std::optional<application::UserResponse>
+  getUserByEmail(const std::string &email) override;
+  application::UserBatch getUsersByIds(const std::vector<int> &ids) override;
+  application::UserBatch getAllUsers() override;
+  application::UserBatch getUsersPage(int after_id, std::size_t limit) override;
+  application::UserBatch
+  searchUsersByNamePrefix(const std::string &prefix,
+                          const application::NameCursor &after,
+                          std::size_t limit) override;
+  bool forEachUser(const domain::UserVisitor &visitor) override;
+  std::optional<application::UserResponse>
+  updateUser(const cppcrudbp::domain::User &user) override;
+  std::vector<int>
+  updateUsers(const std::vector<cppcrudbp::domain::User> &users) override;
+  bool deleteUser(int id) override;
+  std::vector<int> deleteUsers(const std::vector<int> &ids) override;
+  std::unique_ptr<domain::IUnitOfWork> beginUnitOfWork() override;
+
+  std::uint64_t subscribe(domain::UserChangeListener listener) override;
+  void unsubscribe(std::uint64_t subscription) override;
+
+  /**
+   * @brief Blocks until the replica is current or @p timeout passes.
+   * @return Whether reads are now served locally.
+   */
+  bool waitUntilCurrent(std::chrono::milliseconds timeout);
+
+  [[nodiscard]] UserReplicaStats stats() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct PendingChange {
+    domain::UserChange::Kind kind;
+    int id;
+  };
+
+  /** @brief Whether the replica was confirmed current recently enough. */
+  bool current() const;
+  /** @brief Whether this thread's reads may be served from memory. */
+  bool servesReads();
+  void markSynced(Clock::time_point as_of);
+  bool stopping();
+
+  void run();
+  /** @brief One connection's lifetime; returns on stop, throws on loss. */
+  void listen();
+  // Both return the ids written locally while they read, to read again.
+  std::vector<int> reload(pqxx::connection &conn);
+  std::vector<int> refresh(pqxx::connection &conn,
+                           const std::vector<int> &ids);
+  /** @brief Forgets local writes at or before @p seq; mutex_ held. */
+  void pruneLocalWrites(std::uint64_t seq);
+  void publish(const std::vector<PendingChange> &changes);
+
+  void store(const application::UserResponse &user);
+  void erase(int id);
+
+  std::shared_ptr<cppcrudbp::domain::IUserRepository> inner_;
+  const std::string connection_string_;
+  const UserReplicaOptions options_;
+
+  mutable std::shared_mutex mutex_;
+  std::map<int, application::UserResponse> users_; // mutex_
+  // Sequence of the last local write of each id, until a read started
+  // after it; mutex_.
+  std::unordered_map<int, std::uint64_t> local_writes_;
+  std::uint64_t write_seq_ = 0; // mutex_
+
+  std::mutex listeners_mutex_;
+  std::map<std::uint64_t, domain::UserChangeListener>
+      listeners_;                          // listeners_mutex_
+  std::uint64_t next_subscription_ = 1;    // listeners_mutex_
+
+  std::mutex state_mutex_;
+  std::condition_variable state_changed_;
+  bool stopping_ = false; // state_mutex_
+  // Clock time as of which the replica is known current; 0 until loaded.
+  std::atomic<Clock::rep> synced_at_{0};
+
+  std::atomic<std::uint64_t> local_reads_{0};
+  std::atomic<std::uint64_t> fallback_reads_{0};
+  std::atomic<std::uint64_t> changes_{0};
+  std::atomic<std::uint64_t> reloads_{0};
+
+  std::thread listener_;
+};
+
+} // namespace cppcrudbp::infrastructure
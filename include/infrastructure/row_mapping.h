@@ -0,0 +1,209 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace cppcrudbp::infrastructure {
+
+/**
+ * @brief One mapped column: its SQL name and the member it fills.
+ */
+template <typename T, typename Member> struct Column {
+  const char *name;
+  Member T::*member;
+};
+
+template <typename T, typename Member>
+constexpr Column<T, Member> column(const char *name, Member T::*member) {
+  return {name, member};
+}
+
+/**
+ * @brief Compile-time description of how a struct is read from a result
+ * row. Specialize it with a constexpr tuple of column() entries, in the
+ * order the columns are selected:
+ *
+ * @code
+ * template <> struct RowMapping<Foo> {
+ *   static constexpr auto columns = std::make_tuple(
+ *       column("id", &Foo::id), column("label", &Foo::label));
+ * };
+ * @endcode
+ *
+ * columnList<Foo>() then yields "id, label" for SELECT and RETURNING
+ * lists, and mapRow<Foo>() decodes rows by position, with no by-name
+ * column lookups. Supported member types: int, long long, bool,
+ * std::string and std::string_view, which points into the row and lives
+ * only as long. Every mapped column must be NOT NULL.
+ */
+template <typename T> struct RowMapping;
+
+namespace row_mapping_detail {
+
+template <typename T>
+constexpr std::size_t kColumnCount =
+    std::tuple_size_v<std::decay_t<decltype(RowMapping<T>::columns)>>;
+
+constexpr std::size_t length(const char *text) {
+  std::size_t n = 0;
+  while (text[n] != '\0') {
+    ++n;
+  }
+  return n;
+}
+
+template <typename T> constexpr std::size_t columnListLength() {
+  static_assert(kColumnCount<T> > 0, "RowMapping needs at least one column");
+  return std::apply(
+             [](const auto &...columns) {
+               return (0 + ... + (length(columns.name) + 2));
+             },
+             RowMapping<T>::columns) -
+         2;
+}
+
+template <typename T> constexpr auto buildColumnList() {
+  std::array<char, columnListLength<T>() + 1> list{};
+  std::size_t out = 0;
+  std::apply(
+      [&list, &out](const auto &...columns) {
+        const auto append = [&list, &out](const char *name) {
+          if (out != 0) {
+            list[out++] = ',';
+            list[out++] = ' ';
+          }
+          for (std::size_t i = 0; name[i] != '\0'; ++i) {
+            list[out++] = name[i];
+          }
+        };
+        (append(columns.name), ...);
+      },
+      RowMapping<T>::columns);
+  return list;
+}
+
+template <typename T>
+inline constexpr auto kColumnList = buildColumnList<T>();
+
+[[noreturn]] inline void badField(const char *name, const char *problem) {
+  throw std::runtime_error(std::string("Column ") + name + " " + problem +
+                           ".");
+}
+
+// Field readers may return the text alone, or std::nullopt for NULL.
+inline std::string_view fieldText(std::string_view text, const char *) {
+  return text;
+}
+inline std::string_view fieldText(const std::optional<std::string_view> &text,
+                                  const char *name) {
+  if (!text) {
+    badField(name, "is NULL");
+  }
+  return *text;
+}
+
+template <typename Integer>
+void parseInteger(std::string_view text, const char *name, Integer &out) {
+  const char *end = text.data() + text.size();
+  const auto [ptr, ec] = std::from_chars(text.data(), end, out);
+  if (ec != std::errc() || ptr != end) {
+    badField(name, "is not an integer");
+  }
+}
+
+// Column values arrive in PostgreSQL's text format.
+inline void parseField(std::string_view text, const char *, std::string &out) {
+  out.assign(text.data(), text.size());
+}
+inline void parseField(std::string_view text, const char *,
+                       std::string_view &out) {
+  out = text;
+}
+inline void parseField(std::string_view text, const char *name, int &out) {
+  parseInteger(text, name, out);
+}
+inline void parseField(std::string_view text, const char *name,
+                       long long &out) {
+  parseInteger(text, name, out);
+}
+inline void parseField(std::string_view text, const char *name, bool &out) {
+  if (text != "t" && text != "f") {
+    badField(name, "is not a boolean");
+  }
+  out = text == "t";
+}
+
+template <std::size_t> using TextField = std::string_view;
+
+template <typename T, typename = std::make_index_sequence<kColumnCount<T>>>
+struct TextRowOf;
+template <typename T, std::size_t... I>
+struct TextRowOf<T, std::index_sequence<I...>> {
+  using type = std::tuple<TextField<I>...>;
+};
+
+} // namespace row_mapping_detail
+
+/**
+ * @brief The mapped column names, comma-separated, e.g. "id, name, email".
+ * Built at compile time.
+ */
+template <typename T> constexpr const char *columnList() {
+  return row_mapping_detail::kColumnList<T>.data();
+}
+
+/**
+ * @brief One std::string_view per mapped column, the row type to request
+ * from a text stream (e.g. pqxx stream_from).
+ */
+template <typename T>
+using TextRow = typename row_mapping_detail::TextRowOf<T>::type;
+
+/**
+ * @brief Overwrites the mapped members of @p value from one row.
+ * @param field Returns the text of the column at a given position, in
+ * columnList<T>() order, as a std::string_view or as a
+ * std::optional<std::string_view> that is empty for NULL. Existing string
+ * capacity is reused.
+ * @throws std::runtime_error if a column is NULL or does not parse.
+ */
+template <typename T, typename Field>
+void mapRowInto(T &value, Field &&field) {
+  std::size_t index = 0;
+  std::apply(
+      [&](const auto &...columns) {
+        (row_mapping_detail::parseField(
+             row_mapping_detail::fieldText(field(index++), columns.name),
+             columns.name, value.*(columns.member)),
+         ...);
+      },
+      RowMapping<T>::columns);
+}
+
+template <typename T, typename Field> T mapRow(Field &&field) {
+  T value{};
+  mapRowInto(value, std::forward<Field>(field));
+  return value;
+}
+
+/** @brief mapRowInto() for a row read as a TextRow<T>. */
+template <typename T>
+void mapTextRowInto(T &value, const TextRow<T> &row) {
+  const auto fields = std::apply(
+      [](auto... text) {
+        return std::array<std::string_view, sizeof...(text)>{text...};
+      },
+      row);
+  mapRowInto(value, [&fields](std::size_t i) { return fields[i]; });
+}
+
+} // namespace cppcrudbp::infrastructure
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include "common/connection_pool.h"
+#include "domain/user.h"
+#include "domain/user_repository.h"
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cppcrudbp::infrastructure {
+
+class PostgreUserRepository;
+
+/**
+ * @brief IUserRepository over several PostgreSQL databases, each holding a
+ * share of the users.
+ *
+ * A user's row lives on shard id % N, N being the number of shards: ids
+ * are not a single SERIAL but nextval of the shard's own sequence times N
+ * plus the shard's number, so every shard generates ids that route back to
+ * it. A new user goes to the shard its email hashes to.
+ *
+ * Emails are unique across shards through claims: the user_emails table
+ * of the email's shard maps it to the user's id (see
+ * sql/migrations/003_users_sharding.sql). Creating a user claims its email
+ * and inserts the row in one statement on one shard; an update that
+ * changes the email claims the new one first and then releases the old,
+ * so an interruption in between leaves a stale claim that blocks that
+ * email, never a duplicate.
+ *
+ * Reads by id go to one shard; getAllUsers, getUsersPage, searches and
+ * batches of ids query every shard involved in parallel and merge the
+ * results. Each shard has its own worker threads for that, as many as its
+ * pool has connections, started with the repository; a call involving a
+ * single shard runs in the calling thread. updateUsers renames users in
+ * one statement per shard; those whose email changes are updated one at a
+ * time, like updateUser. Units of work are not supported:
+ * beginUnitOfWork() returns nullptr.
+ *
+ * The shards must always be passed in the same order: it fixes where
+ * every existing row and claim is found.
+ */
+class ShardedUserRepository : public cppcrudbp::domain::IUserRepository {
+public:
+  /**
+   * @param shards One pool per database, in shard order.
+   * @throws std::invalid_argument if @p shards is empty or has a null pool.
+   */
+  explicit ShardedUserRepository(
+      std::vector<std::shared_ptr<cppcrudbp::common::ConnectionPool>> shards);
+  ~ShardedUserRepository() override;
+
+  std::optional<application::UserResponse>
+  createUser(const application::CreateUserRequest &user) override;
+  application::BulkCreateResult bulkCreateUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  application::BulkUpsertResult upsertUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  std::optional<application::UserResponse> getUserById(int id) override;
+  std::optional<application::UserResponse>
+  getUserByEmail(const std::string &email) override;
+  application::UserBatch getUsersByIds(const std::vector<int> &ids) override;
+  std::optional<application::UserResponse> findUserById(int id) override;
+  application::UserBatch findUsersByIds(const std::vector<int> &ids) override;
+  application::UserBatch getAllUsers() override;
+  application::UserBatch getUsersPage(int after_id, std::size_t limit) override;
+  application::UserBatch
+  searchUsersByNamePrefix(const std::string &prefix,
+                          const application::NameCursor &after,
+                          std::size_t limit) override;
+  bool forEachUser(const domain::UserVisitor &visitor) override;
+  std::optional<application::UserResponse>
+  updateUser(const cppcrudbp::domain::User &user) override;
+  std::vector<int>
+  updateUsers(const std::vector<cppcrudbp::domain::User> &users) override;
+  bool deleteUser(int id) override;
+  std::vector<int> deleteUsers(const std::vector<int> &ids) override;
+  std::unique_ptr<domain::IUnitOfWork> beginUnitOfWork() override;
+
+  [[nodiscard]] std::size_t shardCount() const;
+  /** @brief Shard storing the user with @p id. */
+  [[nodiscard]] std::size_t shardOfId(int id) const;
+  /** @brief Shard holding the claim on @p email, and new users with it. */
+  [[nodiscard]] std::size_t shardOfEmail(std::string_view email) const;
+
+private:
+  struct Shard;
+
+  /**
+   * @brief Runs @p run(shard) at once for every shard, or those marked in
+   * @p involved; results in shard order, default-constructed for the
+   * shards left out.
+   */
+  template <typename Run>
+  auto scatter(Run &&run, const std::vector<bool> &involved = {});
+
+  /**
+   * @brief getUsersByIds or findUsersByIds, as @p read is the one of the
+   * shards' repositories.
+   */
+  application::UserBatch
+  usersByIds(const std::vector<int> &ids,
+             application::UserBatch (PostgreUserRepository::*read)(
+                 const std::vector<int> &));
+
+  /** @brief Drops @p email's claim by @p id; logs, as it cannot undo. */
+  void releaseEmail(const std::string &email, int id);
+
+  std::vector<Shard> shards_;
+};
+
+} // namespace cppcrudbp::infrastructure
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include "domain/user.h"
+#include "domain/user_repository.h"
+#include "domain/user_snapshot_store.h"
+#include "infrastructure/user_snapshot.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cppcrudbp::infrastructure {
+
+/**
+ * @brief Tuning of the SnapshotUserRepository.
+ */
+struct SnapshotOptions {
+  // How often the snapshot is rewritten from the wrapped repository; one
+  // is written at once if the file is missing or invalid.
+  std::chrono::seconds refresh_interval{300};
+  // Check the checksum when mapping a file.
+  bool verify = true;
+};
+
+/**
+ * @brief Counter snapshot, see SnapshotUserRepository::stats().
+ */
+struct SnapshotStats {
+  std::uint64_t snapshot_reads = 0;
+  std::uint64_t fallback_reads = 0; // No snapshot, written since, or in a
+                                    // unit of work.
+  std::uint64_t refreshes = 0;
+  std::size_t users = 0; // In the snapshot served.
+};
+
+/**
+ * @brief Serves reads from a mapped UserSnapshot file, so a process starts
+ * with the whole table at hand instead of a cold cache.
+ *
+ * The file is mapped at construction and a background thread rewrites it
+ * from the wrapped repository every refresh_interval, swapping the new
+ * mapping in; readers of the old one keep it until they finish.
+ *
+ * Users written through this repository since the snapshot was taken are
+ * read from the wrapped repository: getUserById and getUsersByIds for
+ * those ids, and getAllUsers, getUsersPage and forEachUser altogether,
+ * until the next refresh. Writes by other processes show up with the next
+ * refresh only. getUserByEmail, searches, writes and reads inside a unit
+ * of work always go to the wrapped repository.
+ */
+class SnapshotUserRepository : public cppcrudbp::domain::IUserRepository,
+                               public cppcrudbp::domain::IUserSnapshotStore {
+public:
+  /**
+   * @param path Snapshot file, mapped if valid and rewritten on refresh.
+   */
+  SnapshotUserRepository(
+      std::shared_ptr<cppcrudbp::domain::IUserRepository> inner,
+      std::string path, SnapshotOptions options = {});
+  /** @brief Stops the refresh thread; a refresh in progress completes. */
+  ~SnapshotUserRepository() override;
+
+  SnapshotUserRepository(const SnapshotUserRepository &) = delete;
+  SnapshotUserRepository &operator=(const SnapshotUserRepository &) = delete;
+
+  std::optional<application::UserResponse>
+  createUser(const application::CreateUserRequest &user) override;
+  application::BulkCreateResult bulkCreateUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  application::BulkUpsertResult upsertUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  std::optional<application::UserResponse> getUserById(int id) override;
+  std::optional<application::UserResponse>
+  getUserByEmail(const std::string &email) override;
+  application::UserBatch getUsersByIds(const std::vector<int> &ids) override;
+  application::UserBatch getAllUsers() override;
+  application::UserBatch getUsersPage(int after_id, std::size_t limit) override;
+  application::UserBatch
+  searchUsersByNamePrefix(const std::string &prefix,
+                          const application::NameCursor &after,
+                          std::size_t limit) override;
+  bool forEachUser(const domain::UserVisitor &visitor) override;
+  std::optional<application::UserResponse>
+  updateUser(const cppcrudbp::domain::User &user) override;
+  std::vector<int>
+  updateUsers(const std::vector<cppcrudbp::domain::User> &users) override;
+  bool deleteUser(int id) override;
+  std::vector<int> deleteUsers(const std::vector<int> &ids) override;
+  std::unique_ptr<domain::IUnitOfWork> beginUnitOfWork() override;
+
+  /**
+   * @brief Writes the wrapped repository's users to @p path; the snapshot
+   * served is unchanged.
+   */
+  domain::SnapshotInfo saveSnapshot(const std::string &path) override;
+  /**
+   * @brief Maps @p path and serves reads from it until the next refresh,
+   * which rewrites the configured file.
+   */
+  domain::SnapshotInfo loadSnapshot(const std::string &path) override;
+
+  /**
+   * @brief Rewrites the configured file and serves it.
+   * @throws std::runtime_error on failure; the old snapshot stays.
+   */
+  domain::SnapshotInfo refresh();
+
+  [[nodiscard]] SnapshotStats stats() const;
+
+private:
+  friend class SnapshotUnitOfWork;
+
+  /**
+   * @brief The snapshot, if this thread's read of @p id, or of the whole
+   * table without one, may use it; counts the read either way.
+   */
+  std::shared_ptr<const UserSnapshot> readable(std::optional<int> id = {});
+  /**
+   * @brief Records writes to @p ids, or to any user if @p all; inside a
+   * unit of work, once it ends.
+   */
+  void noteWrites(const std::vector<int> &ids, bool all = false);
+  void markWritten(const std::vector<int> &ids, bool all);
+  /** @brief Serves @p snapshot; forgets writes numbered up to @p seen. */
+  void install(std::shared_ptr<const UserSnapshot> snapshot,
+               std::uint64_t seen);
+
+  void run();
+
+  std::shared_ptr<cppcrudbp::domain::IUserRepository> inner_;
+  const std::string path_;
+  const SnapshotOptions options_;
+
+  // Guards the snapshot pointer and what was written since it was taken.
+  mutable std::shared_mutex mutex_;
+  std::shared_ptr<const UserSnapshot> snapshot_; // mutex_
+  // Number of the last write to each id, and to all ids, since the
+  // snapshot; numbers come from writes_.
+  std::unordered_map<int, std::uint64_t> dirty_; // mutex_
+  std::uint64_t all_dirty_ = 0;                  // mutex_
+  std::uint64_t writes_ = 0;                     // mutex_
+
+  std::mutex refresh_mutex_; // One refresh or save at a time.
+
+  std::mutex state_mutex_;
+  std::condition_variable state_changed_;
+  bool stopping_ = false; // state_mutex_
+
+  std::atomic<std::uint64_t> snapshot_reads_{0};
+  std::atomic<std::uint64_t> fallback_reads_{0};
+  std::atomic<std::uint64_t> refreshes_{0};
+
+  std::thread refresher_;
+};
+
+} // namespace cppcrudbp::infrastructure
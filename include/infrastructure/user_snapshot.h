@@ -0,0 +1,88 @@
+#pragma once
+
+#include "application/user_batch.h"
+#include "domain/user_repository.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace cppcrudbp::infrastructure {
+
+/**
+ * @brief A users table mapped read-only from a snapshot file.
+ *
+ * The file is used in place: open() maps it and checks its header, and
+ * lookups read the mapping directly, so nothing is parsed or copied and
+ * the page cache is shared between processes. Layout, in native byte
+ * order, each section starting on an 8-byte boundary:
+ *
+ *   header   magic, version, counts, section offsets, checksum
+ *   records  per user, ascending id: int32 id, uint32 heap offset,
+ *            uint16 name length, uint16 email length
+ *   index    open-addressing id index of uint32 record numbers, at most
+ *            half full, UINT32_MAX for an empty slot
+ *   heap     each user's name and email, back to back
+ *
+ * The checksum covers every byte after the header. A file of another
+ * version, or written with the other byte order, is rejected.
+ */
+class UserSnapshot {
+public:
+  static constexpr std::uint32_t kVersion = 1;
+
+  /**
+   * @param verify Recompute the checksum, reading the whole file once;
+   * without it a corrupt file can yield garbage, and at() and find() throw
+   * std::runtime_error on entries pointing outside their section.
+   * @throws std::runtime_error if @p path is missing or not a valid
+   * snapshot.
+   */
+  static std::shared_ptr<const UserSnapshot> open(const std::string &path,
+                                                  bool verify = true);
+
+  /**
+   * @brief Writes every user of @p source to @p path through a temporary
+   * file renamed over it, so readers see the old file or the new one.
+   * Mappings of the old file stay valid.
+   * @return The number of users written.
+   * @throws std::runtime_error if reading @p source or writing fails, or
+   * a name or email is over 65535 bytes.
+   */
+  static std::size_t write(const std::string &path,
+                           domain::IUserRepository &source);
+
+  ~UserSnapshot();
+  UserSnapshot(const UserSnapshot &) = delete;
+  UserSnapshot &operator=(const UserSnapshot &) = delete;
+
+  [[nodiscard]] std::size_t size() const;
+  /** @brief Size of the mapped file. */
+  [[nodiscard]] std::size_t bytes() const { return bytes_; }
+  /** @brief Total length of every name and email. */
+  [[nodiscard]] std::size_t textBytes() const;
+  /** @brief When it was written, in milliseconds since the Unix epoch. */
+  [[nodiscard]] std::int64_t createdAtMs() const;
+
+  /** @brief Entry @p i, in ascending id order; points into the mapping. */
+  [[nodiscard]] application::UserView at(std::size_t i) const;
+  [[nodiscard]] std::optional<application::UserView> find(int id) const;
+  /** @brief Position of the first user with an id above @p id. */
+  [[nodiscard]] std::size_t upperBound(int id) const;
+
+private:
+  struct Header;
+  struct Record;
+
+  UserSnapshot() = default;
+
+  const char *data_ = nullptr;
+  std::size_t bytes_ = 0;
+  const Header *header_ = nullptr;
+  const Record *records_ = nullptr;
+  const std::uint32_t *index_ = nullptr;
+  const char *heap_ = nullptr;
+};
+
+} // namespace cppcrudbp::infrastructure
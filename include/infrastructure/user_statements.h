@@ -0,0 +1,340 @@
+#pragma once
+
+#include "application/user_batch.h"
+#include "application/user_dto.h"
+#include "domain/user.h"
+#include "infrastructure/row_mapping.h"
+#include <algorithm>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace cppcrudbp::infrastructure {
+
+template <> struct RowMapping<application::UserResponse> {
+  static constexpr auto columns =
+      std::make_tuple(column("id", &application::UserResponse::id),
+                      column("name", &application::UserResponse::name),
+                      column("email", &application::UserResponse::email));
+};
+
+// Decodes without copying: the views point into the result row.
+template <> struct RowMapping<application::UserView> {
+  static constexpr auto columns =
+      std::make_tuple(column("id", &application::UserView::id),
+                      column("name", &application::UserView::name),
+                      column("email", &application::UserView::email));
+};
+static_assert(std::string_view(columnList<application::UserView>()) ==
+                  columnList<application::UserResponse>(),
+              "UserView rows must decode from the UserResponse columns");
+
+/**
+ * @brief A named SQL statement prepared once per pooled connection.
+ */
+struct PreparedStatement {
+  std::string name;
+  std::string sql;
+};
+
+// Formats ids as an int[] literal, e.g. "{1,2,3}", bound as one parameter.
+inline std::string toIntArray(const std::vector<int> &ids) {
+  std::string array;
+  array.reserve(ids.size() * 8 + 2);
+  array += '{';
+  char digits[16];
+  for (const int id : ids) {
+    if (array.size() > 1) {
+      array += ',';
+    }
+    const auto end = std::to_chars(digits, digits + sizeof(digits), id).ptr;
+    array.append(digits, end);
+  }
+  array += '}';
+  return array;
+}
+
+// Formats @p values as a text[] literal, each element quoted, e.g.
+// {"a","b \"c\""}.
+inline std::string toTextArray(const std::vector<std::string> &values) {
+  std::string array;
+  array += '{';
+  for (const auto &value : values) {
+    if (array.size() > 1) {
+      array += ',';
+    }
+    array += '"';
+    for (const char c : value) {
+      if (c == '"' || c == '\\') {
+        array += '\\';
+      }
+      array += c;
+    }
+    array += '"';
+  }
+  array += '}';
+  return array;
+}
+
+// The last update of each id in @p users, ordered by id: a multi-row
+// UPDATE must not meet an id twice, and a fixed order keeps concurrent
+// batches from deadlocking on each other's row locks.
+inline std::vector<domain::User>
+lastUpdatePerId(const std::vector<domain::User> &users) {
+  std::vector<domain::User> sorted(users);
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const domain::User &a, const domain::User &b) {
+                     return a.id < b.id;
+                   });
+  std::vector<domain::User> last;
+  last.reserve(sorted.size());
+  for (auto &user : sorted) {
+    if (!last.empty() && last.back().id == user.id) {
+      last.back() = std::move(user);
+    } else {
+      last.push_back(std::move(user));
+    }
+  }
+  return last;
+}
+
+// The id, name and email arrays of kUpdateMany and kShardUpdateMany.
+inline std::tuple<std::string, std::string, std::string>
+toUpdateArrays(const std::vector<domain::User> &users) {
+  std::vector<int> ids;
+  std::vector<std::string> names;
+  std::vector<std::string> emails;
+  ids.reserve(users.size());
+  names.reserve(users.size());
+  emails.reserve(users.size());
+  for (const auto &user : users) {
+    ids.push_back(user.id);
+    names.push_back(user.name);
+    emails.push_back(user.email);
+  }
+  return {toIntArray(ids), toTextArray(names), toTextArray(emails)};
+}
+
+/**
+ * @brief Registry of every statement PostgreUserRepository and
+ * ShardedUserRepository execute.
+ *
+ * Statements are invoked by name through exec_prepared, so the server parses
+ * and plans each one once per connection instead of once per call. Every
+ * statement returning users selects RowMapping<UserResponse>'s columns, in
+ * its order, so rows decode by position.
+ */
+namespace user_statements {
+
+// "SELECT <user columns> FROM users" followed by @p rest.
+inline std::string selectUsers(const char *rest) {
+  return std::string("SELECT ") +
+         columnList<application::UserResponse>() + " FROM users" + rest;
+}
+
+inline std::string returningUser() {
+  return std::string(" RETURNING ") +
+         columnList<application::UserResponse>();
+}
+
+// Writes return the stored row, so callers need no follow-up read.
+inline const PreparedStatement kCreate{
+    "users_create",
+    "INSERT INTO users (name, email) VALUES ($1, $2)" + returningUser()};
+inline const PreparedStatement kGetById{"users_get_by_id",
+                                        selectUsers(" WHERE id = $1")};
+// Served by the UNIQUE (email) index.
+inline const PreparedStatement kGetByEmail{"users_get_by_email",
+                                           selectUsers(" WHERE email = $1")};
+// Name-prefix pages: $1/$2 is the keyset cursor, already raised to the
+// start of the prefix, and $3 the first name past the prefix. Comparing in
+// the "C" collation makes both bounds ranges of users_name_c_id_idx (see
+// sql/migrations), so a page reads only the rows it returns. The plan does
+// not depend on the values, which keeps the generic plan as good as a
+// custom one.
+inline const PreparedStatement kSearchByNamePrefix{
+    "users_search_by_name_prefix",
+    selectUsers(" WHERE (name COLLATE \"C\", id) > ($1, $2)"
+                " AND name COLLATE \"C\" < $3"
+                " ORDER BY name COLLATE \"C\", id LIMIT $4")};
+// The same for prefixes with no upper bound, such as "".
+inline const PreparedStatement kSearchFromName{
+    "users_search_from_name",
+    selectUsers(" WHERE (name COLLATE \"C\", id) > ($1, $2)"
+                " ORDER BY name COLLATE \"C\", id LIMIT $3")};
+// The ids travel as one int[] parameter, so the statement text and plan are
+// the same however many are sent.
+inline const PreparedStatement kGetByIds{
+    "users_get_by_ids",
+    selectUsers(" WHERE id = ANY($1::int[]) ORDER BY id")};
+inline const PreparedStatement kGetAll{"users_get_all", selectUsers("")};
+inline const PreparedStatement kGetPage{
+    "users_get_page", selectUsers(" WHERE id > $1 ORDER BY id LIMIT $2")};
+inline const PreparedStatement kUpdate{
+    "users_update",
+    "UPDATE users SET name = $1, email = $2 WHERE id = $3" + returningUser()};
+// $1 ids, $2 names, $3 emails, as parallel arrays; one UPDATE for all.
+inline const PreparedStatement kUpdateMany{
+    "users_update_many",
+    "UPDATE users AS u SET name = v.name, email = v.email "
+    "FROM unnest($1::int[], $2::text[], $3::text[]) AS v(id, name, email) "
+    "WHERE u.id = v.id RETURNING u.id"};
+inline const PreparedStatement kDelete{"users_delete",
+                                       "DELETE FROM users WHERE id = $1"};
+inline const PreparedStatement kDeleteByIds{
+    "users_delete_by_ids",
+    "DELETE FROM users WHERE id = ANY($1::int[]) RETURNING id"};
+
+// The trigger feeding ReplicatedUserRepository, see sql/migrations.
+inline constexpr const char *kFindChangeTrigger =
+    "SELECT 1 FROM pg_trigger WHERE tgrelid = 'users'::regclass"
+    " AND tgname = 'users_notify_change'";
+
+// Streamed through COPY, which cannot run a prepared statement.
+inline const std::string kStreamAll = selectUsers(" ORDER BY id");
+
+// Bulk import: rows are COPYed into a session-local staging table, then
+// moved into users keeping the first row per email and skipping emails that
+// already exist. The move empties the staging table, so a second import in
+// the same unit of work starts clean. RETURNING tells the caller which rows
+// went in.
+inline constexpr const char *kCreateImportStaging =
+    "CREATE TEMP TABLE IF NOT EXISTS users_import ("
+    "seq BIGSERIAL, name TEXT NOT NULL, email TEXT NOT NULL"
+    ") ON COMMIT DELETE ROWS";
+inline constexpr const char *kInsertFromImport =
+    "WITH staged AS (DELETE FROM users_import RETURNING seq, name, email) "
+    "INSERT INTO users (name, email) "
+    "SELECT name, email FROM ("
+    "SELECT DISTINCT ON (email) seq, name, email FROM staged "
+    "ORDER BY email, seq) AS firsts ORDER BY seq "
+    "ON CONFLICT (email) DO NOTHING RETURNING email";
+// Upsert from the same staging table: the last row per email wins, and
+// rows that would not change anything are skipped rather than rewritten.
+// xmax is 0 only on freshly inserted rows.
+inline constexpr const char *kUpsertFromImport =
+    "WITH staged AS (DELETE FROM users_import RETURNING seq, name, email) "
+    "INSERT INTO users (name, email) "
+    "SELECT name, email FROM ("
+    "SELECT DISTINCT ON (email) seq, name, email FROM staged "
+    "ORDER BY email, seq DESC) AS lasts ORDER BY seq "
+    "ON CONFLICT (email) DO UPDATE SET name = EXCLUDED.name "
+    "WHERE users.name IS DISTINCT FROM EXCLUDED.name "
+    "RETURNING (xmax = 0) AS inserted";
+
+// --- ShardedUserRepository, see sql/migrations/003_users_sharding.sql ---
+//
+// A shard's ids are nextval('users_id_seq') * shards + shard, so that
+// id % shards names the shard storing the row.
+
+// $1 name, $2 email, $3 shards, $4 this shard. Claims the email and
+// inserts the user in one statement; a taken email fails it.
+inline const PreparedStatement kShardCreate{
+    "users_shard_create",
+    "WITH claim AS (INSERT INTO user_emails (email, user_id) "
+    "VALUES ($2::varchar, nextval('users_id_seq') * $3::bigint + $4::bigint) "
+    "RETURNING user_id) "
+    "INSERT INTO users (id, name, email) "
+    "SELECT user_id, $1::varchar, $2::varchar FROM claim" +
+        returningUser()};
+// Claims $1 for user $2, or confirms it already has it; returns no row if
+// another user holds it. "claimed" is true for a new claim.
+inline const PreparedStatement kShardClaimEmail{
+    "users_shard_claim_email",
+    "INSERT INTO user_emails (email, user_id) VALUES ($1, $2) "
+    "ON CONFLICT (email) DO UPDATE SET user_id = EXCLUDED.user_id "
+    "WHERE user_emails.user_id = EXCLUDED.user_id "
+    "RETURNING (xmax = 0) AS claimed"};
+inline const PreparedStatement kShardReleaseEmail{
+    "users_shard_release_email",
+    "DELETE FROM user_emails WHERE email = $1 AND user_id = $2"};
+inline const PreparedStatement kShardReleaseEmailsOf{
+    "users_shard_release_emails_of",
+    "DELETE FROM user_emails WHERE user_id = ANY($1::int[])"};
+// The user's claim, joined to its row when the row is on the same shard.
+inline const PreparedStatement kShardFindEmail{
+    "users_shard_find_email",
+    "SELECT c.user_id, u.name, u.email FROM user_emails AS c "
+    "LEFT JOIN users AS u ON u.id = c.user_id WHERE c.email = $1"};
+// Like kUpdate, also returning the email replaced, whose claim is then
+// released.
+inline const PreparedStatement kShardUpdate{
+    "users_shard_update",
+    "UPDATE users AS u SET name = $1, email = $2 "
+    "FROM (SELECT id, email FROM users WHERE id = $3 FOR UPDATE) AS old "
+    "WHERE u.id = old.id RETURNING u.id, u.name, u.email, old.email"};
+// updateUsers on one shard: $1 ids, $2 names, $3 emails. Renames, in one
+// statement, the users whose email stays the same, and returns a row per
+// user found here; "renamed" is false where the email changes, which
+// needs kShardUpdate and its claims.
+inline const PreparedStatement kShardUpdateMany{
+    "users_shard_update_many",
+    "WITH v AS (SELECT * FROM unnest($1::int[], $2::text[], $3::text[]) "
+    "AS t(id, name, email)), "
+    "renamed AS (UPDATE users AS u SET name = v.name FROM v "
+    "WHERE u.id = v.id AND u.email = v.email RETURNING u.id) "
+    "SELECT u.id, r.id IS NOT NULL AS renamed FROM v "
+    "JOIN users AS u ON u.id = v.id LEFT JOIN renamed AS r ON r.id = u.id"};
+// Renames one user of an upsert whose row is not on its email's shard.
+inline const PreparedStatement kShardRename{
+    "users_shard_rename",
+    "UPDATE users SET name = $1 WHERE id = $2 AND email = $3 "
+    "AND name IS DISTINCT FROM $1"};
+inline const PreparedStatement kShardDelete{
+    "users_shard_delete", "DELETE FROM users WHERE id = $1 RETURNING email"};
+inline const PreparedStatement kShardDeleteByIds{
+    "users_shard_delete_by_ids",
+    "DELETE FROM users WHERE id = ANY($1::int[]) RETURNING id, email"};
+
+// Bulk import into one shard from the users_import staging table, with $1
+// shards and $2 this shard: like kInsertFromImport, claiming each email
+// first, and returning the emails inserted.
+inline constexpr const char *kShardInsertFromImport =
+    "WITH staged AS (DELETE FROM users_import RETURNING seq, name, email), "
+    "firsts AS (SELECT DISTINCT ON (email) seq, name, email FROM staged "
+    "ORDER BY email, seq), "
+    "claimed AS (INSERT INTO user_emails (email, user_id) "
+    "SELECT email, nextval('users_id_seq') * $1::bigint + $2::bigint "
+    "FROM firsts ORDER BY seq ON CONFLICT (email) DO NOTHING "
+    "RETURNING email, user_id) "
+    "INSERT INTO users (id, name, email) "
+    "SELECT c.user_id, f.name, f.email FROM claimed AS c "
+    "JOIN firsts AS f USING (email) ORDER BY f.seq RETURNING email";
+// Upsert into one shard, the last row per email winning. One row per
+// user: kind 'i' inserted, 'r' renamed here, or 'f' held by a user whose
+// row is on another shard, to be renamed there by kShardRename. Every
+// part reads the table as it was before the statement.
+inline constexpr const char *kShardUpsertFromImport =
+    "WITH staged AS (DELETE FROM users_import RETURNING seq, name, email), "
+    "lasts AS (SELECT DISTINCT ON (email) seq, name, email FROM staged "
+    "ORDER BY email, seq DESC), "
+    "claimed AS (INSERT INTO user_emails (email, user_id) "
+    "SELECT email, nextval('users_id_seq') * $1::bigint + $2::bigint "
+    "FROM lasts ORDER BY seq ON CONFLICT (email) DO NOTHING "
+    "RETURNING email, user_id), "
+    "inserted AS (INSERT INTO users (id, name, email) "
+    "SELECT c.user_id, l.name, l.email FROM claimed AS c "
+    "JOIN lasts AS l USING (email) ORDER BY l.seq RETURNING id), "
+    "renamed AS (UPDATE users AS u SET name = l.name FROM lasts AS l "
+    "WHERE u.email = l.email AND u.name IS DISTINCT FROM l.name "
+    "RETURNING u.id) "
+    "SELECT 'i' AS kind, id, NULL AS name, NULL AS email FROM inserted "
+    "UNION ALL SELECT 'r', id, NULL, NULL FROM renamed "
+    "UNION ALL SELECT 'f', c.user_id, l.name, l.email FROM lasts AS l "
+    "JOIN user_emails AS c USING (email) "
+    "WHERE c.user_id % $1::bigint <> $2::bigint";
+
+// --- ReplicaRoutingUserRepository: WAL positions as byte offsets ---
+
+inline constexpr const char *kPrimaryWalPosition =
+    "SELECT (pg_current_wal_lsn() - '0/0'::pg_lsn)::bigint";
+// NULL on a database that is not a standby.
+inline constexpr const char *kReplicaReplayPosition =
+    "SELECT CASE WHEN pg_is_in_recovery() "
+    "THEN (pg_last_wal_replay_lsn() - '0/0'::pg_lsn)::bigint END";
+
+} // namespace user_statements
+
+} // namespace cppcrudbp::infrastructure
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include "common/metrics.h"
+#include "domain/user.h"
+#include "domain/user_repository.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace cppcrudbp::infrastructure {
+
+/**
+ * @brief Tuning of the WriteBehindUserRepository.
+ */
+struct WriteBehindOptions {
+  // Queued ids that trigger a flush.
+  std::size_t flush_batch = 500;
+  // Longest an update waits in the queue.
+  std::chrono::milliseconds max_delay{50};
+  // Bound of the queue: an update to a new id past it flushes first, in
+  // the calling thread.
+  std::size_t max_pending = 10000;
+  // Writes of one update, retried in later flushes, before it is dropped.
+  unsigned max_attempts = 3;
+};
+
+/**
+ * @brief Counter snapshot, see WriteBehindUserRepository::stats().
+ */
+struct WriteBehindStats {
+  std::uint64_t updates = 0;   // updateUser calls queued.
+  std::uint64_t direct = 0;    // updateUser calls changing the email.
+  std::uint64_t coalesced = 0; // Of the queued, superseded before written.
+  std::uint64_t dropped = 0;   // Of the queued, deleted before written.
+  std::uint64_t flushes = 0;
+  std::uint64_t rows_flushed = 0; // Updates sent to the wrapped repository.
+  std::uint64_t retried = 0;      // Of those, queued again after failing.
+  std::uint64_t failed = 0;       // Of those, dropped after max_attempts.
+  std::size_t pending = 0;
+  std::chrono::nanoseconds flush_time{0}; // Summed over every flush.
+  std::chrono::nanoseconds max_flush_time{0};
+
+  /** @brief Queued updateUser calls per row written, 1 without
+   * coalescing. */
+  [[nodiscard]] double coalescingRatio() const {
+    // The counters are read one by one: the subtraction may not fit.
+    if (updates <= coalesced + dropped) {
+      return 1.0;
+    }
+    return static_cast<double>(updates) /
+           static_cast<double>(updates - coalesced - dropped);
+  }
+};
+
+/**
+ * @brief Queues updateUser calls in front of any IUserRepository and
+ * writes them in batches, keeping only the last update of each id.
+ *
+ * A flusher thread hands the queue to the wrapped repository's
+ * updateUsers, in call order, once it holds flush_batch ids or its oldest
+ * update is max_delay old; flush() does the same on demand, and the
+ * destructor drains the queue before it returns. If a batch is not applied
+ * in full, the ids left out are retried one at a time in call order, and
+ * those failing again go back in the queue, unless a newer update of the
+ * id is there, for up to max_attempts writes.
+ *
+ * Only updates keeping the user's email are queued, so a batch can
+ * conflict with nothing and be applied in any order. One changing the
+ * email is a barrier: the queue is written first, then the update itself,
+ * in the calling thread, and updateUser returns its outcome.
+ *
+ * updateUser returns nullopt for an id that does not exist, looked up in
+ * the wrapped repository unless it has a queued update; otherwise a queued
+ * update returns the user as queued, before anything is written, and one
+ * rejected when flushed is only logged and counted. Reads by id see
+ * queued updates; every other read, every other write and beginUnitOfWork
+ * flush first, so they observe the updates made before them. Inside a
+ * unit of work, calls go straight to the wrapped repository.
+ *
+ * Flushes are recorded as the "write-behind" / "flush" operation of the
+ * process metrics, and queued updates as "write-behind" / "updateUser"
+ * with one row per id newly queued, so the stats command shows the
+ * coalescing ratio as calls per row.
+ */
+class WriteBehindUserRepository : public cppcrudbp::domain::IUserRepository {
+public:
+  /**
+   * @throws std::invalid_argument if @p inner is null or a bound is zero.
+   */
+  explicit WriteBehindUserRepository(
+      std::shared_ptr<cppcrudbp::domain::IUserRepository> inner,
+      WriteBehindOptions options = {});
+  /** @brief Writes the queued updates, then stops the flusher. */
+  ~WriteBehindUserRepository() override;
+
+  WriteBehindUserRepository(const WriteBehindUserRepository &) = delete;
+  WriteBehindUserRepository &
+  operator=(const WriteBehindUserRepository &) = delete;
+
+  std::optional<application::UserResponse>
+  createUser(const application::CreateUserRequest &user) override;
+  application::BulkCreateResult bulkCreateUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  application::BulkUpsertResult upsertUsers(
+      const std::vector<application::CreateUserRequest> &users) override;
+  std::optional<application::UserResponse> getUserById(int id) override;
+  std::optional<application::UserResponse>
+  getUserByEmail(const std::string &email) override;
+  application::UserBatch getUsersByIds(const std::vector<int> &ids) override;
+  application::UserBatch getAllUsers() override;
+  application::UserBatch getUsersPage(int after_id, std::size_t limit) override;
+  application::UserBatch
+  searchUsersByNamePrefix(const std::string &prefix,
+                          const application::NameCursor &after,
+                          std::size_t limit) override;
+  bool forEachUser(const domain::UserVisitor &visitor) override;
+  /** @brief Queues the update; see the class comment. */
+  std::optional<application::UserResponse>
+  updateUser(const cppcrudbp::domain::User &user) override;
+  std::vector<int>
+  updateUsers(const std::vector<cppcrudbp::domain::User> &users) override;
+  bool deleteUser(int id) override;
+  std::vector<int> deleteUsers(const std::vector<int> &ids) override;
+  std::unique_ptr<domain::IUnitOfWork> beginUnitOfWork() override;
+
+  /**
+   * @brief Writes every update queued so far, returning once they are
+   * applied or have failed.
+   */
+  void flush();
+
+  [[nodiscard]] WriteBehindStats stats() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+  struct Pending {
+    cppcrudbp::domain::User user;
+    std::uint64_t seq = 0; // Call order.
+    unsigned attempts = 0; // Failed writes so far.
+  };
+  using Queue = std::unordered_map<int, Pending>;
+  using Updates = std::unordered_map<int, cppcrudbp::domain::User>;
+
+  void run();
+  /** @brief Writes the queue out; one flush at a time, in queue order. */
+  void flushQueued();
+  /** @brief flushQueued's body; the caller holds flush_mutex_. */
+  void writeQueued();
+  /** @brief Flushes unless nothing is queued or being written. */
+  void flushIfQueued();
+  /** @brief The newest queued or in-flight update of each of @p ids. */
+  Updates queuedUpdates(const std::vector<int> &ids) const;
+  /**
+   * @brief Drops the queued updates of @p ids, about to be deleted; waits
+   * for the flush writing any of them.
+   */
+  void dropQueued(const std::vector<int> &ids);
+
+  std::shared_ptr<cppcrudbp::domain::IUserRepository> inner_;
+  const WriteBehindOptions options_;
+  common::MetricId queue_metric_;
+  common::MetricId flush_metric_;
+
+  // Orders flushes, and email changes with them: a batch is written only
+  // after the one before it.
+  std::mutex flush_mutex_;
+
+  mutable std::mutex state_mutex_;
+  std::condition_variable state_changed_;
+  Queue queued_;                // state_mutex_
+  Queue flushing_;              // state_mutex_; the batch being written.
+  Clock::time_point oldest_{};  // state_mutex_; first update in queued_.
+  std::uint64_t next_seq_ = 0;  // state_mutex_
+  bool stopping_ = false;       // state_mutex_
+
+  std::atomic<std::uint64_t> updates_{0};
+  std::atomic<std::uint64_t> direct_{0};
+  std::atomic<std::uint64_t> coalesced_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+  std::atomic<std::uint64_t> flushes_{0};
+  std::atomic<std::uint64_t> rows_flushed_{0};
+  std::atomic<std::uint64_t> retried_{0};
+  std::atomic<std::uint64_t> failed_{0};
+  std::atomic<std::int64_t> flush_ns_{0};
+  std::atomic<std::int64_t> max_flush_ns_{0};
+
+  std::thread flusher_;
+};
+
+} // namespace cppcrudbp::infrastructure
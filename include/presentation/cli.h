@@ -2,6 +2,13 @@
 
 #include "application/user_dto.h"
 #include "application/user_service.h"
+#include "domain/unit_of_work.h"
+#include "domain/user_change_feed.h"
+#include "domain/user_snapshot_store.h"
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -20,9 +27,15 @@ public:
    * @brief Constructor for CliAdapter.
    * @param userService A unique_ptr to a UserService instance.
    * This demonstrates dependency injection.
+   * @param changes Feed behind the 'watch' command; optional.
+   * @param snapshots Store behind the 'snapshot-save' and 'snapshot-load'
+   * commands; optional.
    */
   explicit CliAdapter(
-      std::shared_ptr<cppcrudbp::application::UserService> userService);
+      std::shared_ptr<cppcrudbp::application::UserService> userService,
+      std::shared_ptr<cppcrudbp::domain::IUserChangeFeed> changes = nullptr,
+      std::shared_ptr<cppcrudbp::domain::IUserSnapshotStore> snapshots =
+          nullptr);
 
   /**
    * @brief Starts the CLI application loop.
@@ -30,8 +43,24 @@ public:
    */
   void run();
 
+  /**
+   * @brief Runs commands from @p input without prompts or help output.
+   *
+   * Up to @p groupSize consecutive create commands are sent to the service
+   * as one bulk insert. Output is buffered and ends with a summary of
+   * succeeded/failed commands and throughput.
+   */
+  void runBatch(std::istream &input, std::size_t groupSize);
+
 private:
   std::shared_ptr<cppcrudbp::application::UserService> userService_;
+  std::shared_ptr<cppcrudbp::domain::IUserChangeFeed> changes_;
+  std::shared_ptr<cppcrudbp::domain::IUserSnapshotStore> snapshots_;
+  bool interactive_ = false; // Inside run(), reading commands from stdin.
+  std::ostream *out_ = &std::cout;
+  std::ostream *err_ = &std::cerr;
+  // Open between the 'begin' and 'commit'/'rollback' commands.
+  std::unique_ptr<cppcrudbp::domain::IUnitOfWork> unitOfWork_;
 
   /**
    * @brief Displays the available commands to the user.
@@ -41,25 +70,55 @@ private:
   /**
    * @brief Processes a single command entered by the user.
    * @param commandLine The full command line string entered by the user.
+   * @return false if the command was unknown or failed.
    */
-  void processCommand(const std::string &commandLine);
+  bool processCommand(const std::string &commandLine);
 
   // --- Command Handlers ---
   void handleCreateUser(const std::vector<std::string> &args);
+  void handleImportUsers(const std::vector<std::string> &args);
+  void handleSyncUsers(const std::vector<std::string> &args);
   void handleGetUserById(const std::vector<std::string> &args);
+  void handleGetUserByEmail(const std::vector<std::string> &args);
+  void handleGetUsersByIds(const std::vector<std::string> &args);
   void handleGetAllUsers();
+  void handleGetUsersPage(const std::vector<std::string> &args);
+  void handleSearchUsers(const std::vector<std::string> &args);
   void handleUpdateUser(const std::vector<std::string> &args);
   void handleDeleteUser(const std::vector<std::string> &args);
+  void handleDeleteUsers(const std::vector<std::string> &args);
+  void handleStats(const std::vector<std::string> &args);
+  void handleWatch(const std::vector<std::string> &args);
+  void handleSnapshot(const std::string &command,
+                      const std::vector<std::string> &args);
+  void handleBegin();
+  void handleCommit();
+  void handleRollback();
+  void rollbackOpenUnitOfWork();
+
+  /**
+   * @brief Lists the ids in @p requested that are not in @p present
+   * (ascending), or prints nothing if all are.
+   */
+  void reportMissingIds(std::vector<int> requested,
+                        const std::vector<int> &present);
+
+  /**
+   * @brief Reads users from a JSONL or name,email CSV file and passes them
+   * to @p onBatch in fixed-size batches. Invalid lines are reported to the
+   * error stream and skipped.
+   * @return The number of invalid lines.
+   */
+  std::size_t readUserFile(
+      const std::string &path,
+      const std::function<void(
+          const std::vector<cppcrudbp::application::CreateUserRequest> &)>
+          &onBatch);
 
-  // --- Helper for JSON simulation (same as in HttpUserController) ---
-  // In a real CLI, you might prompt for fields or use a proper JSON parser.
+  // --- JSON request helpers ---
   cppcrudbp::application::CreateUserRequest
   parseCreateUserRequest(const std::string &json);
   cppcrudbp::application::UpdateUserRequest
   parseUpdateUserRequest(const std::string &json, int id);
-  std::string serializeUserResponse(
-      const std::optional<application::UserResponse> &response);
-  std::string serializeUserResponses(
-      const std::vector<cppcrudbp::application::UserResponse> &responses);
 };
 } // namespace cppcrudbp::cli
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "application/user_service.h"
+#include "common/metrics.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace cppcrudbp::http {
+
+/**
+ * @brief Listener and threading settings for HttpAdapter.
+ */
+struct HttpOptions {
+  std::string address = "0.0.0.0";
+  std::uint16_t port = 8081; // 0 picks a free port, see port().
+  std::size_t workers = 0;   // 0: one per hardware thread.
+  std::size_t max_request_bytes = 1 << 20;
+};
+
+/**
+ * @brief A parsed request; views point into the connection's read buffer.
+ */
+struct HttpRequest {
+  std::string_view method;
+  std::string_view path;
+  std::string_view query;
+  std::string_view body;
+  bool keep_alive = true;
+};
+
+struct HttpResponse {
+  int status = 200;
+  std::string body; // Empty for 204.
+  const char *content_type = "application/json";
+};
+
+/**
+ * @brief HTTP/1.1 adapter exposing UserService as a REST resource.
+ *
+ * Routes: POST /users, GET /users[?after_id=&limit=], GET /users/{id},
+ * PUT /users/{id} and DELETE /users/{id}, with JSON bodies. GET /users
+ * returns one page, of 100 users unless limit says otherwise (at most
+ * 1000). GET /metrics serves common::Metrics in the Prometheus text
+ * format.
+ *
+ * A fixed set of worker threads each run their own epoll loop over
+ * non-blocking, edge-triggered sockets. The listening socket is shared with
+ * EPOLLEXCLUSIVE, so each new connection wakes a single worker, which keeps
+ * it for the connection's lifetime. Keep-alive and pipelined requests are
+ * supported; chunked request bodies are not. Service calls run on the
+ * worker thread, so size the repository's connection pool to match.
+ */
+class HttpAdapter {
+public:
+  explicit HttpAdapter(
+      std::shared_ptr<cppcrudbp::application::UserService> userService,
+      HttpOptions options = {});
+  ~HttpAdapter();
+
+  HttpAdapter(const HttpAdapter &) = delete;
+  HttpAdapter &operator=(const HttpAdapter &) = delete;
+
+  /**
+   * @brief Binds the listener and starts the workers; returns immediately.
+   * @throws std::runtime_error if the socket cannot be set up.
+   */
+  void start();
+
+  /** @brief Blocks until the workers exit (after stop()). */
+  void wait();
+
+  /** @brief Asks all workers to exit; safe from any thread. */
+  void stop();
+
+  /** @brief The bound port, valid after start(). */
+  [[nodiscard]] std::uint16_t port() const { return bound_port_; }
+
+  /**
+   * @brief Maps one request onto the UserService, recording its latency
+   * and response size under the "http" metrics layer.
+   */
+  HttpResponse handle(const HttpRequest &request);
+
+private:
+  struct RouteMetrics {
+    common::MetricId create, get, list, update, remove, metrics, other;
+  };
+
+  struct Connection;
+  struct Worker;
+
+  void workerLoop();
+  void acceptConnections(Worker &worker);
+  void closeConnection(Worker &worker, Connection &conn);
+  // Both return false once the connection should be closed.
+  bool readRequests(Connection &conn);
+  bool writeResponses(Connection &conn);
+
+  HttpResponse route(const HttpRequest &request, common::MetricId &metric);
+  HttpResponse listUsers(std::string_view query);
+  HttpResponse createUser(std::string_view body);
+  HttpResponse getUser(int id);
+  HttpResponse updateUser(int id, std::string_view body);
+  HttpResponse deleteUser(int id);
+
+  std::shared_ptr<cppcrudbp::application::UserService> userService_;
+  HttpOptions options_;
+  RouteMetrics metrics_;
+  int listen_fd_ = -1;
+  int stop_fd_ = -1;
+  std::uint16_t bound_port_ = 0;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace cppcrudbp::http
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "application/user_dto.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace cppcrudbp::presentation {
+
+/**
+ * @brief Single-pass JSON reader over a borrowed buffer.
+ *
+ * Strings are decoded (escapes, \uXXXX and surrogate pairs to UTF-8)
+ * straight into the caller's std::string; nothing else is allocated.
+ * Values read or skipped are checked against the JSON grammar (RFC 8259):
+ * malformed input, e.g. a leading zero, a raw control character in a
+ * string or key, or a number like 1-2e+, throws std::invalid_argument.
+ */
+class JsonReader {
+public:
+  explicit JsonReader(std::string_view input) : input_(input) {}
+
+  /**
+   * @brief Reads an object, calling @p onMember(key, *this) for each member.
+   * The callback must consume the value, e.g. with readString() or
+   * skipValue(). @p key is only valid during the call.
+   */
+  template <typename OnMember> void readObject(OnMember &&onMember) {
+    skipWhitespace();
+    expect('{');
+    skipWhitespace();
+    if (peek() == '}') {
+      ++pos_;
+      return;
+    }
+    while (true) {
+      const std::string_view key = readKey();
+      skipWhitespace();
+      expect(':');
+      skipWhitespace();
+      onMember(key, *this);
+      skipWhitespace();
+      if (peek() == ',') {
+        ++pos_;
+        skipWhitespace();
+        continue;
+      }
+      expect('}');
+      return;
+    }
+  }
+
+  /**
+   * @brief Decodes a JSON string value into @p out, replacing its contents.
+   */
+  void readString(std::string &out);
+
+  /**
+   * @brief Reads an integer number that fits in an int.
+   */
+  int readInt();
+
+  /**
+   * @brief Skips any JSON value, including nested objects and arrays.
+   */
+  void skipValue();
+
+  /**
+   * @brief Fails unless only whitespace remains.
+   */
+  void expectEnd();
+
+private:
+  char peek() const { return pos_ < input_.size() ? input_[pos_] : '\0'; }
+  void skipWhitespace();
+  void expect(char c);
+  std::string_view readKey();
+  void decodeEscape(std::string &out);
+  void skipString();
+  void skipNumber();
+  void skipDigits(); // One or more.
+  unsigned readHex4();
+  [[noreturn]] void fail(const std::string &what) const;
+
+  std::string_view input_;
+  std::size_t pos_ = 0;
+  std::string key_scratch_; // Only used for keys containing escapes.
+};
+
+/**
+ * @brief Decodes {"name": ..., "email": ...} into @p request. Other members
+ * are skipped; absent ones leave the field empty.
+ */
+void parseCreateUserJson(std::string_view json,
+                         application::CreateUserRequest &request);
+
+/**
+ * @brief Same as parseCreateUserJson, for the update DTO (id not touched).
+ */
+void parseUpdateUserJson(std::string_view json,
+                         application::UpdateUserRequest &request);
+
+/**
+ * @brief Decodes a {"name": ..., "id": ...} search cursor into @p cursor.
+ * Other members are skipped; absent ones keep their current value.
+ */
+void parseNameCursorJson(std::string_view json,
+                         application::NameCursor &cursor);
+
+} // namespace cppcrudbp::presentation
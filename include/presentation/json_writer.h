@@ -0,0 +1,77 @@
+#pragma once
+
+#include "application/user_batch.h"
+#include "application/user_dto.h"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cppcrudbp::presentation {
+
+/**
+ * @brief Appends JSON straight into one growable buffer.
+ *
+ * Values are escaped on the way in, so the buffer is always valid JSON
+ * text. With a sink, the buffer is written out in chunks once it passes
+ * @p flush_threshold bytes, so arbitrarily long listings use bounded
+ * memory. Without one, the caller takes the finished text with buffer().
+ * Shared by the presentation adapters.
+ */
+class JsonWriter {
+public:
+  explicit JsonWriter(std::ostream *sink = nullptr,
+                      std::size_t flush_threshold = 64 * 1024);
+  ~JsonWriter();
+
+  JsonWriter(const JsonWriter &) = delete;
+  JsonWriter &operator=(const JsonWriter &) = delete;
+
+  /** @brief Appends text verbatim (not escaped). */
+  JsonWriter &raw(std::string_view text);
+  /** @brief Appends a quoted, escaped JSON string. */
+  JsonWriter &string(std::string_view value);
+  JsonWriter &number(long long value);
+
+  /** @brief Appends {"id":..,"name":..,"email":..}. */
+  JsonWriter &user(const application::UserView &user);
+  JsonWriter &user(const application::UserResponse &user) {
+    return this->user(application::UserView{user.id, user.name, user.email});
+  }
+  /** @brief Appends a JSON array of users. */
+  JsonWriter &users(const std::vector<application::UserResponse> &users);
+  JsonWriter &users(const application::UserBatch &users);
+
+  /** @brief Writes buffered text to the sink, if any. */
+  void flush();
+
+  [[nodiscard]] const std::string &buffer() const { return buffer_; }
+  void clear() { buffer_.clear(); }
+  /** @brief Moves the buffered text out, leaving the writer empty. */
+  [[nodiscard]] std::string take() {
+    std::string text = std::move(buffer_);
+    buffer_.clear();
+    return text;
+  }
+
+  /** @brief Total bytes produced, flushed or not. */
+  [[nodiscard]] std::size_t bytesWritten() const {
+    return flushed_ + buffer_.size();
+  }
+
+private:
+  void maybeFlush() {
+    if (sink_ && buffer_.size() >= flush_threshold_) {
+      flush();
+    }
+  }
+
+  std::ostream *sink_;
+  std::size_t flush_threshold_;
+  std::string buffer_;
+  std::size_t flushed_ = 0;
+};
+
+} // namespace cppcrudbp::presentation
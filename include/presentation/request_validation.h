@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+namespace cppcrudbp::presentation {
+
+/**
+ * @brief Checks the fields every create/update request must carry.
+ * @param operation Used in the error message, e.g. "user creation".
+ * @throws std::invalid_argument if a field is missing or the email is not
+ * well formed.
+ */
+void validateUserFields(const std::string &name, const std::string &email,
+                        const std::string &operation);
+
+} // namespace cppcrudbp::presentation
@@ -0,0 +1,13 @@
+-- Index behind searchUsersByNamePrefix, for databases created before it
+-- was added to schema.sql.
+--
+-- In the "C" collation names sort byte by byte, so a name prefix and the
+-- (name, id) keyset cursor are both plain ranges of this index and a page
+-- reads only the rows it returns. Unlike text_pattern_ops, the same index
+-- also serves the ORDER BY. Email lookups need nothing new: the UNIQUE
+-- (email) constraint already has its index.
+--
+-- CONCURRENTLY keeps the table writable while the index builds; run this
+-- file outside a transaction block (psql -f does).
+CREATE INDEX CONCURRENTLY IF NOT EXISTS users_name_c_id_idx
+    ON users (name COLLATE "C", id);
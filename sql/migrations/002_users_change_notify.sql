@@ -0,0 +1,32 @@
+-- Change notifications behind ReplicatedUserRepository (--replica). Not
+-- part of schema.sql: every changed row costs a pg_notify, queued until
+-- commit, so apply this only to a database a replica listens to.
+--
+-- Every committed insert, update and delete on users sends its kind and id
+-- on the users_changes channel ("I:42", "U:42", "D:42"); a TRUNCATE sends
+-- "T". Rows are not in the payload: the listener re-reads them, which keeps
+-- payloads far below the 8000-byte limit and always yields the latest row.
+-- Notifications are delivered only on commit, in commit order.
+CREATE OR REPLACE FUNCTION users_notify_change() RETURNS trigger
+LANGUAGE plpgsql AS $$
+BEGIN
+    IF TG_OP = 'TRUNCATE' THEN
+        PERFORM pg_notify('users_changes', 'T');
+    ELSIF TG_OP = 'DELETE' THEN
+        PERFORM pg_notify('users_changes', 'D:' || OLD.id);
+    ELSE
+        PERFORM pg_notify('users_changes', left(TG_OP, 1) || ':' || NEW.id);
+    END IF;
+    RETURN NULL;
+END
+$$;
+
+DROP TRIGGER IF EXISTS users_notify_change ON users;
+CREATE TRIGGER users_notify_change
+    AFTER INSERT OR UPDATE OR DELETE ON users
+    FOR EACH ROW EXECUTE FUNCTION users_notify_change();
+
+DROP TRIGGER IF EXISTS users_notify_truncate ON users;
+CREATE TRIGGER users_notify_truncate
+    AFTER TRUNCATE ON users
+    FOR EACH STATEMENT EXECUTE FUNCTION users_notify_change();
@@ -0,0 +1,21 @@
+-- Email claims behind ShardedUserRepository (--shards); apply to every
+-- shard, and to databases created before it was added to schema.sql.
+--
+-- users.email is UNIQUE only within one shard. Across shards, each email
+-- is claimed in the user_emails table of the shard it hashes to, which
+-- maps it to the id of the user holding it; that user's row may live on
+-- another shard after its email changed. The index serves the release of
+-- claims by user id when users are deleted in bulk.
+CREATE TABLE IF NOT EXISTS user_emails (
+    email VARCHAR(255) PRIMARY KEY,
+    user_id INTEGER NOT NULL
+);
+
+CREATE INDEX IF NOT EXISTS user_emails_user_id_idx
+    ON user_emails (user_id);
+
+-- A single database is a valid one-shard setup: claim the emails already
+-- there. Splitting existing users across several shards is not covered.
+INSERT INTO user_emails (email, user_id)
+SELECT email, id FROM users
+ON CONFLICT (email) DO NOTHING;
@@ -4,3 +4,19 @@ CREATE TABLE IF NOT EXISTS users (
     email VARCHAR(255) UNIQUE NOT NULL
 );
 
+-- Name-prefix search; see sql/migrations/001_users_name_search_index.sql.
+CREATE INDEX IF NOT EXISTS users_name_c_id_idx
+    ON users (name COLLATE "C", id);
+
+-- Change notifications for --replica are opt-in, as they cost a
+-- pg_notify per changed row: apply sql/migrations/002_users_change_notify.sql
+-- to the database the replica listens to.
+
+-- Email claims for --shards; see sql/migrations/003_users_sharding.sql.
+CREATE TABLE IF NOT EXISTS user_emails (
+    email VARCHAR(255) PRIMARY KEY,
+    user_id INTEGER NOT NULL
+);
+
+CREATE INDEX IF NOT EXISTS user_emails_user_id_idx
+    ON user_emails (user_id);
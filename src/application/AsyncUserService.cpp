@@ -0,0 +1,38 @@
+#include "application/async_user_service.h"
+#include <stdexcept>
+
+namespace cppcrudbp::application {
+
+AsyncUserService::AsyncUserService(
+    std::shared_ptr<cppcrudbp::domain::IAsyncUserRepository> repository)
+    : repository_(std::move(repository)) {
+  if (!repository_) {
+    throw std::invalid_argument("IAsyncUserRepository cannot be null.");
+  }
+}
+
+std::future<std::optional<application::UserResponse>>
+AsyncUserService::createUser(const application::CreateUserRequest &user) {
+  return repository_->createUser(user);
+}
+
+std::future<std::optional<application::UserResponse>>
+AsyncUserService::getUserById(int id) {
+  return repository_->getUserById(id);
+}
+
+std::future<application::UserBatch>
+AsyncUserService::getUsersPage(int after_id, std::size_t limit) {
+  return repository_->getUsersPage(after_id, limit);
+}
+
+std::future<std::optional<application::UserResponse>>
+AsyncUserService::updateUser(const application::UpdateUserRequest &user) {
+  return repository_->updateUser(domain::User{user.id, user.name, user.email});
+}
+
+std::future<bool> AsyncUserService::deleteUser(int id) {
+  return repository_->deleteUser(id);
+}
+
+} // namespace cppcrudbp::application
@@ -0,0 +1,43 @@
+#include "application/user_batch.h"
+#include <limits>
+#include <stdexcept>
+
+namespace cppcrudbp::application {
+
+void UserBatch::reserve(std::size_t users, std::size_t text_bytes) {
+  ids_.reserve(users);
+  offsets_.reserve(2 * users + 1);
+  text_.reserve(text_bytes);
+}
+
+void UserBatch::push_back(int id, std::string_view name,
+                          std::string_view email) {
+  if (text_.size() + name.size() + email.size() >
+      std::numeric_limits<std::uint32_t>::max()) {
+    throw std::length_error("UserBatch: text buffer full.");
+  }
+  ids_.push_back(id);
+  text_.append(name);
+  offsets_.push_back(static_cast<std::uint32_t>(text_.size()));
+  text_.append(email);
+  offsets_.push_back(static_cast<std::uint32_t>(text_.size()));
+}
+
+void UserBatch::clear() {
+  ids_.clear();
+  offsets_.resize(1);
+  text_.clear();
+}
+
+UserResponse UserBatch::user(std::size_t i) const {
+  const UserView view = (*this)[i];
+  return UserResponse{view.id, std::string(view.name),
+                      std::string(view.email)};
+}
+
+std::size_t UserBatch::memoryBytes() const {
+  return sizeof(*this) + ids_.capacity() * sizeof(int) +
+         offsets_.capacity() * sizeof(std::uint32_t) + text_.capacity();
+}
+
+} // namespace cppcrudbp::application
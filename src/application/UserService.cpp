@@ -1,32 +1,148 @@
 #include "application/user_dto.h"
 #include "application/user_service.h"
+#include "common/metrics.h"
 
 namespace cppcrudbp::application {
 
+namespace {
+
+common::MetricId serviceMetric(const char *operation) {
+  return common::Metrics::global().registerOperation("service", operation);
+}
+
+const common::MetricId kCreateUser = serviceMetric("createUser");
+const common::MetricId kBulkCreateUsers = serviceMetric("bulkCreateUsers");
+const common::MetricId kUpsertUsers = serviceMetric("upsertUsers");
+const common::MetricId kGetUserById = serviceMetric("getUserById");
+const common::MetricId kGetUserByEmail = serviceMetric("getUserByEmail");
+const common::MetricId kGetUsersByIds = serviceMetric("getUsersByIds");
+const common::MetricId kGetAllUsers = serviceMetric("getAllUsers");
+const common::MetricId kGetUsersPage = serviceMetric("getUsersPage");
+const common::MetricId kSearchUsersByNamePrefix =
+    serviceMetric("searchUsersByNamePrefix");
+const common::MetricId kForEachUser = serviceMetric("forEachUser");
+const common::MetricId kUpdateUser = serviceMetric("updateUser");
+const common::MetricId kDeleteUser = serviceMetric("deleteUser");
+const common::MetricId kDeleteUsers = serviceMetric("deleteUsers");
+
+} // namespace
+
 UserService::UserService(
     std::shared_ptr<cppcrudbp::domain::IUserRepository> repository)
     : repository_(std::move(repository)) {}
 
-bool UserService::createUser(const application::CreateUserRequest &user) {
-  return repository_->createUser(user);
+std::optional<application::UserResponse>
+UserService::createUser(const application::CreateUserRequest &user) {
+  common::OperationTimer timer(kCreateUser);
+  auto created = repository_->createUser(user);
+  timer.check(created.has_value());
+  return created;
+}
+
+application::BulkCreateResult UserService::bulkCreateUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  common::OperationTimer timer(kBulkCreateUsers);
+  auto result = repository_->bulkCreateUsers(users);
+  timer.check(result.failed == 0);
+  timer.addRows(result.inserted);
+  return result;
+}
+
+application::BulkUpsertResult UserService::upsertUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  common::OperationTimer timer(kUpsertUsers);
+  auto result = repository_->upsertUsers(users);
+  timer.check(result.failed == 0);
+  timer.addRows(result.inserted + result.updated);
+  return result;
 }
 
 std::optional<application::UserResponse> UserService::getUserById(int id) {
-  return repository_->getUserById(id);
+  common::OperationTimer timer(kGetUserById);
+  auto user = repository_->getUserById(id);
+  timer.addRows(user ? 1 : 0);
+  return user;
+}
+
+std::optional<application::UserResponse>
+UserService::getUserByEmail(const std::string &email) {
+  common::OperationTimer timer(kGetUserByEmail);
+  auto user = repository_->getUserByEmail(email);
+  timer.addRows(user ? 1 : 0);
+  return user;
+}
+
+application::UserBatch UserService::getUsersByIds(const std::vector<int> &ids) {
+  common::OperationTimer timer(kGetUsersByIds);
+  auto users = repository_->getUsersByIds(ids);
+  timer.addRows(users.size());
+  return users;
+}
+
+application::UserBatch UserService::getAllUsers() {
+  common::OperationTimer timer(kGetAllUsers);
+  auto users = repository_->getAllUsers();
+  timer.addRows(users.size());
+  return users;
+}
+
+application::UserBatch
+UserService::getUsersPage(int after_id, std::size_t limit) {
+  common::OperationTimer timer(kGetUsersPage);
+  auto users = repository_->getUsersPage(after_id, limit);
+  timer.addRows(users.size());
+  return users;
+}
+
+application::UserBatch
+UserService::searchUsersByNamePrefix(const std::string &prefix,
+                                     const application::NameCursor &after,
+                                     std::size_t limit) {
+  common::OperationTimer timer(kSearchUsersByNamePrefix);
+  auto users = repository_->searchUsersByNamePrefix(prefix, after, limit);
+  timer.addRows(users.size());
+  return users;
 }
 
-std::vector<application::UserResponse> UserService::getAllUsers() {
-  return repository_->getAllUsers();
+bool UserService::forEachUser(const domain::UserVisitor &visitor) {
+  // Includes the visitor's own time, e.g. serializing each row.
+  common::OperationTimer timer(kForEachUser);
+  std::uint64_t rows = 0;
+  const bool completed = repository_->forEachUser(
+      [&visitor, &rows](const application::UserResponse &user) {
+        ++rows;
+        visitor(user);
+      });
+  timer.addRows(rows);
+  return timer.check(completed);
 }
 
-bool UserService::updateUser(const application::UpdateUserRequest &user) {
+std::optional<application::UserResponse>
+UserService::updateUser(const application::UpdateUserRequest &user) {
+  common::OperationTimer timer(kUpdateUser);
   domain::User usr_;
   usr_.id = user.id;
   usr_.email = user.email;
   usr_.name = user.name;
-  return repository_->updateUser(usr_);
+  auto updated = repository_->updateUser(usr_);
+  timer.check(updated.has_value());
+  return updated;
+}
+
+bool UserService::deleteUser(int id) {
+  common::OperationTimer timer(kDeleteUser);
+  return timer.check(repository_->deleteUser(id));
 }
 
-bool UserService::deleteUser(int id) { return repository_->deleteUser(id); }
+std::vector<int> UserService::deleteUsers(const std::vector<int> &ids) {
+  common::OperationTimer timer(kDeleteUsers);
+  auto deleted = repository_->deleteUsers(ids);
+  timer.addRows(deleted.size());
+  return deleted;
+}
+
+std::unique_ptr<domain::IUnitOfWork> UserService::beginUnitOfWork() {
+  return repository_->beginUnitOfWork();
+}
 
 } // namespace cppcrudbp::application
@@ -0,0 +1,193 @@
+#include "common/connection_pool.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+namespace cppcrudbp::common {
+
+struct ConnectionPool::Slot {
+  std::unique_ptr<pqxx::connection> conn;
+  Clock::time_point last_used;
+  std::unordered_set<std::string> prepared;
+};
+
+// --- Lease ---
+
+ConnectionPool::Lease::Lease(ConnectionPool *pool, std::unique_ptr<Slot> slot)
+    : pool_(pool), slot_(std::move(slot)) {}
+
+ConnectionPool::Lease::Lease(Lease &&other) noexcept
+    : pool_(other.pool_), slot_(std::move(other.slot_)),
+      broken_(other.broken_) {
+  other.pool_ = nullptr;
+}
+
+ConnectionPool::Lease &
+ConnectionPool::Lease::operator=(Lease &&other) noexcept {
+  if (this != &other) {
+    release();
+    pool_ = other.pool_;
+    slot_ = std::move(other.slot_);
+    broken_ = other.broken_;
+    other.pool_ = nullptr;
+  }
+  return *this;
+}
+
+ConnectionPool::Lease::~Lease() { release(); }
+
+pqxx::connection &ConnectionPool::Lease::operator*() const {
+  return *slot_->conn;
+}
+
+pqxx::connection *ConnectionPool::Lease::operator->() const {
+  return slot_->conn.get();
+}
+
+void ConnectionPool::Lease::prepare(const std::string &name,
+                                    const std::string &sql) {
+  if (slot_->prepared.count(name) != 0) {
+    return;
+  }
+  slot_->conn->prepare(name, sql);
+  slot_->prepared.insert(name);
+}
+
+void ConnectionPool::Lease::release() noexcept {
+  if (pool_ && slot_) {
+    pool_->release(std::move(slot_), broken_);
+  }
+  pool_ = nullptr;
+}
+
+// --- ConnectionPool ---
+
+ConnectionPool::ConnectionPool(std::string connection_string,
+                               ConnectionPoolOptions options)
+    : connection_string_(std::move(connection_string)), options_(options) {
+  if (options_.max_size == 0 || options_.min_size > options_.max_size) {
+    throw std::invalid_argument(
+        "ConnectionPool: require 0 < max_size and min_size <= max_size.");
+  }
+  idle_.reserve(options_.max_size);
+  for (std::size_t i = 0; i < options_.min_size; ++i) {
+    idle_.push_back(connect());
+    ++open_;
+  }
+}
+
+ConnectionPool::~ConnectionPool() = default;
+
+std::unique_ptr<ConnectionPool::Slot> ConnectionPool::connect() {
+  auto slot = std::make_unique<Slot>();
+  try {
+    slot->conn = std::make_unique<pqxx::connection>(connection_string_);
+    if (!slot->conn->is_open()) {
+      throw std::runtime_error("Failed to open database connection.");
+    }
+  } catch (const std::exception &e) {
+    throw std::runtime_error(std::string("ConnectionPool error: ") + e.what());
+  }
+  slot->last_used = Clock::now();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++counters_.connections_opened;
+  }
+  return slot;
+}
+
+void ConnectionPool::ensureHealthy(Slot &slot) {
+  const bool stale =
+      Clock::now() - slot.last_used >= options_.health_check_after;
+  if (slot.conn->is_open() && !stale) {
+    return;
+  }
+  if (slot.conn->is_open()) {
+    try {
+      pqxx::nontransaction ping(*slot.conn);
+      ping.exec("SELECT 1");
+      return;
+    } catch (const pqxx::broken_connection &) {
+      // Fall through and reconnect.
+    }
+  }
+  auto fresh = connect();
+  slot.conn = std::move(fresh->conn);
+  slot.prepared.clear(); // Statements died with the old session.
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++counters_.reconnects;
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+  const auto start = Clock::now();
+  const auto deadline = start + options_.acquire_timeout;
+  std::unique_ptr<Slot> slot;
+  bool must_connect = false;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto can_proceed = [this] {
+      return !idle_.empty() || open_ < options_.max_size;
+    };
+    if (!available_.wait_until(lock, deadline, can_proceed)) {
+      ++counters_.timeouts;
+      throw std::runtime_error(
+          "ConnectionPool error: timed out waiting for a free connection.");
+    }
+    if (!idle_.empty()) {
+      slot = std::move(idle_.back());
+      idle_.pop_back();
+    } else {
+      ++open_;
+      must_connect = true;
+    }
+    ++in_use_;
+    const auto waited = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                              start)
+            .count());
+    ++counters_.acquisitions;
+    counters_.total_wait_us += waited;
+    counters_.max_wait_us = std::max(counters_.max_wait_us, waited);
+  }
+
+  try {
+    if (must_connect) {
+      slot = connect();
+    } else {
+      ensureHealthy(*slot);
+    }
+  } catch (...) {
+    release(nullptr, true);
+    throw;
+  }
+  return Lease(this, std::move(slot));
+}
+
+void ConnectionPool::release(std::unique_ptr<Slot> slot, bool broken) noexcept {
+  std::unique_ptr<Slot> dropped; // Closed outside the lock.
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --in_use_;
+    if (!slot || broken || !slot->conn || !slot->conn->is_open()) {
+      --open_; // Replaced on demand by the next acquire().
+      dropped = std::move(slot);
+    } else {
+      slot->last_used = Clock::now();
+      idle_.push_back(std::move(slot));
+    }
+  }
+  available_.notify_one();
+}
+
+ConnectionPoolStats ConnectionPool::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ConnectionPoolStats snapshot = counters_;
+  snapshot.open = open_;
+  snapshot.idle = idle_.size();
+  snapshot.in_use = in_use_;
+  return snapshot;
+}
+
+} // namespace cppcrudbp::common
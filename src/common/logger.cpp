@@ -0,0 +1,367 @@
+#include "common/logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+namespace cppcrudbp::common {
+
+namespace {
+
+constexpr std::size_t kRateBuckets = 256;
+constexpr std::size_t kMaxDrainBatch = 256;
+constexpr std::chrono::milliseconds kIdleWait{100};
+constexpr std::chrono::seconds kLossReportInterval{1};
+
+std::size_t roundUpToPowerOfTwo(std::size_t value) {
+  std::size_t result = 2;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+// FNV-1a over the component pointer, the level and the site text.
+std::uint64_t siteHash(LogLevel level, const char *component,
+                       std::string_view text) {
+  std::uint64_t hash = 14695981039346656037ull;
+  const auto mix = [&hash](std::uint64_t byte) {
+    hash = (hash ^ byte) * 1099511628211ull;
+  };
+  const auto pointer = reinterpret_cast<std::uintptr_t>(component);
+  for (std::size_t i = 0; i < sizeof(pointer); ++i) {
+    mix((pointer >> (8 * i)) & 0xFF);
+  }
+  mix(static_cast<std::uint64_t>(level));
+  for (const char c : text) {
+    mix(static_cast<unsigned char>(c));
+  }
+  return hash;
+}
+
+void appendTimestamp(std::string &out,
+                     std::chrono::system_clock::time_point time) {
+  const auto since_epoch = time.time_since_epoch();
+  const auto seconds =
+      std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+  const auto millis =
+      std::chrono::duration_cast<std::chrono::milliseconds>(since_epoch -
+                                                            seconds);
+  const std::time_t t = static_cast<std::time_t>(seconds.count());
+  std::tm utc{};
+  gmtime_r(&t, &utc);
+  char buffer[32];
+  const int n = std::snprintf(
+      buffer, sizeof(buffer), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+      utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour,
+      utc.tm_min, utc.tm_sec, static_cast<int>(millis.count()));
+  out.append(buffer, static_cast<std::size_t>(n));
+}
+
+// One logfmt line; the message is quoted and kept on a single line.
+void appendLine(std::string &out, std::chrono::system_clock::time_point time,
+                LogLevel level, const char *component, std::string_view msg) {
+  while (!msg.empty() && (msg.back() == '\n' || msg.back() == ' ')) {
+    msg.remove_suffix(1);
+  }
+  out += "ts=";
+  appendTimestamp(out, time);
+  out += " level=";
+  out += toString(level);
+  out += " component=";
+  out += component;
+  out += " msg=\"";
+  for (const char c : msg) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    default:
+      out += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+    }
+  }
+  out += "\"\n";
+}
+
+} // namespace
+
+std::string_view toString(LogLevel level) {
+  switch (level) {
+  case LogLevel::kDebug:
+    return "debug";
+  case LogLevel::kInfo:
+    return "info";
+  case LogLevel::kWarning:
+    return "warning";
+  case LogLevel::kError:
+    return "error";
+  }
+  return "unknown";
+}
+
+std::optional<LogLevel> parseLogLevel(std::string_view name) {
+  for (const LogLevel level : {LogLevel::kDebug, LogLevel::kInfo,
+                               LogLevel::kWarning, LogLevel::kError}) {
+    if (toString(level) == name) {
+      return level;
+    }
+  }
+  return std::nullopt;
+}
+
+/**
+ * @brief One ring entry. Its sequence equals the enqueue position that may
+ * claim it while free, and that position + 1 once the record is published.
+ */
+struct alignas(64) Logger::Slot {
+  std::atomic<std::size_t> sequence{0};
+  std::chrono::system_clock::time_point time;
+  const char *component = nullptr;
+  LogLevel level = LogLevel::kInfo;
+  std::uint16_t length = 0;
+  char text[kMaxMessage];
+};
+
+Logger &Logger::global() {
+  // Never destroyed, so threads may log during static destruction; the
+  // writer is stopped, queue drained, when exit() runs its handlers.
+  static Logger *const logger = [] {
+    auto *created = new Logger();
+    std::atexit([] { Logger::global().stop(); });
+    return created;
+  }();
+  return *logger;
+}
+
+Logger::Logger(LoggerOptions options)
+    : options_(options), sink_(options.sink ? *options.sink : std::cerr),
+      min_level_(options.min_level),
+      mask_(roundUpToPowerOfTwo(options.capacity) - 1),
+      slots_(new Slot[mask_ + 1]),
+      rate_buckets_(new std::atomic<std::uint64_t>[kRateBuckets]),
+      last_report_(std::chrono::steady_clock::now()) {
+  for (std::size_t i = 0; i <= mask_; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  for (std::size_t i = 0; i < kRateBuckets; ++i) {
+    rate_buckets_[i].store(0, std::memory_order_relaxed);
+  }
+  writer_ = std::thread([this] { run(); });
+}
+
+Logger::~Logger() { stop(); }
+
+void Logger::write(LogLevel level, const char *component,
+                   std::initializer_list<std::string_view> parts) {
+  const std::string_view site = parts.size() ? *parts.begin() : "";
+  if (!allow(siteHash(level, component, site),
+             std::chrono::steady_clock::now())) {
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const auto now = std::chrono::system_clock::now();
+
+  if (stopped_.load(std::memory_order_acquire)) {
+    std::string message;
+    for (const std::string_view part : parts) {
+      message.append(part);
+    }
+    std::string line;
+    appendLine(line, now, level, component, message);
+    writeOut(line);
+    written_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Slot *slot;
+  for (;;) {
+    slot = &slots_[pos & mask_];
+    const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const auto diff = static_cast<std::ptrdiff_t>(sequence) -
+                      static_cast<std::ptrdiff_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The writer has not freed this slot yet: the ring is full.
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  std::size_t length = 0;
+  for (const std::string_view part : parts) {
+    const std::size_t n = std::min(part.size(), kMaxMessage - length);
+    std::memcpy(slot->text + length, part.data(), n);
+    length += n;
+  }
+  slot->time = now;
+  slot->component = component;
+  slot->level = level;
+  slot->length = static_cast<std::uint16_t>(length);
+  slot->sequence.store(pos + 1, std::memory_order_release);
+
+  if (idle_.load(std::memory_order_acquire)) {
+    wake_.notify_one();
+  }
+}
+
+bool Logger::allow(std::uint64_t site,
+                   std::chrono::steady_clock::time_point now) {
+  if (options_.rate_burst == 0 || options_.rate_window.count() <= 0) {
+    return true;
+  }
+  // Layout: 32-bit site | 16-bit window number | 16-bit count.
+  const auto window = static_cast<std::uint64_t>(
+      now.time_since_epoch() / options_.rate_window);
+  const std::uint64_t tag = ((site & 0xFFFFFFFF) << 16) | (window & 0xFFFF);
+  const std::uint64_t burst =
+      std::min<std::uint64_t>(options_.rate_burst, 0xFFFF);
+  std::atomic<std::uint64_t> &bucket = rate_buckets_[site % kRateBuckets];
+  std::uint64_t current = bucket.load(std::memory_order_relaxed);
+  for (;;) {
+    std::uint64_t next = (tag << 16) | 1;
+    if ((current >> 16) == tag) {
+      if ((current & 0xFFFF) >= burst) {
+        return false;
+      }
+      next = current + 1;
+    }
+    if (bucket.compare_exchange_weak(current, next,
+                                     std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+}
+
+bool Logger::hasRecord() const {
+  return slots_[dequeue_pos_ & mask_].sequence.load(
+             std::memory_order_acquire) == dequeue_pos_ + 1;
+}
+
+bool Logger::popInto(std::string &out) {
+  if (!hasRecord()) {
+    return false;
+  }
+  Slot &slot = slots_[dequeue_pos_ & mask_];
+  appendLine(out, slot.time, slot.level, slot.component,
+             std::string_view(slot.text, slot.length));
+  slot.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+  ++dequeue_pos_;
+  return true;
+}
+
+void Logger::reportLosses(std::string &out) {
+  const auto now = std::chrono::steady_clock::now();
+  if (now - last_report_ < kLossReportInterval) {
+    return;
+  }
+  last_report_ = now;
+  const std::uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+  const std::uint64_t suppressed = suppressed_.load(std::memory_order_relaxed);
+  if (dropped == reported_dropped_ && suppressed == reported_suppressed_) {
+    return;
+  }
+  const std::string message =
+      "dropped " + std::to_string(dropped - reported_dropped_) +
+      " records on a full queue and suppressed " +
+      std::to_string(suppressed - reported_suppressed_) +
+      " repeated ones since the last report";
+  reported_dropped_ = dropped;
+  reported_suppressed_ = suppressed;
+  appendLine(out, std::chrono::system_clock::now(), LogLevel::kWarning,
+             "logger", message);
+}
+
+void Logger::writeOut(const std::string &text) {
+  const std::lock_guard<std::mutex> lock(sink_mutex_);
+  sink_ << text;
+  sink_.flush();
+}
+
+void Logger::run() {
+  std::string batch;
+  for (;;) {
+    std::size_t records = 0;
+    while (records < kMaxDrainBatch && popInto(batch)) {
+      ++records;
+    }
+    reportLosses(batch);
+    if (!batch.empty()) {
+      writeOut(batch);
+      batch.clear();
+      written_.fetch_add(records, std::memory_order_relaxed);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushed_pos_ = dequeue_pos_;
+    drained_.notify_all();
+    if (records != 0) {
+      continue;
+    }
+    if (stopping_ && !hasRecord()) {
+      break;
+    }
+    idle_.store(true, std::memory_order_seq_cst);
+    // Producers notify without the lock, so a wakeup can be missed; the
+    // timeout bounds how long a record then waits.
+    wake_.wait_for(lock, kIdleWait,
+                   [this] { return stopping_ || hasRecord(); });
+    idle_.store(false, std::memory_order_relaxed);
+  }
+
+  // Report what the last interval lost before going synchronous.
+  last_report_ -= kLossReportInterval;
+  reportLosses(batch);
+  if (!batch.empty()) {
+    writeOut(batch);
+  }
+}
+
+void Logger::flush() {
+  if (stopped_.load(std::memory_order_acquire)) {
+    return;
+  }
+  const std::size_t target = enqueue_pos_.load(std::memory_order_acquire);
+  std::unique_lock<std::mutex> lock(mutex_);
+  wake_.notify_one();
+  drained_.wait(lock,
+                [this, target] { return stopping_ || flushed_pos_ >= target; });
+}
+
+void Logger::stop() {
+  if (stopped_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+}
+
+LoggerStats Logger::stats() const {
+  LoggerStats stats;
+  stats.written = written_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  stats.suppressed = suppressed_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace cppcrudbp::common
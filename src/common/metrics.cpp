@@ -0,0 +1,254 @@
+#include "common/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+
+namespace cppcrudbp::common {
+
+namespace {
+
+int highestBit(std::uint64_t value) { return 63 - __builtin_clzll(value); }
+
+// Single-writer increment: only the owning thread stores to its shard, so
+// no read-modify-write instruction is needed.
+void bump(std::atomic<std::uint64_t> &counter, std::uint64_t by = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + by,
+                std::memory_order_relaxed);
+}
+
+// Histogram buckets exported to Prometheus, in seconds.
+constexpr double kPrometheusBuckets[] = {1e-6, 5e-6, 1e-5, 5e-5, 1e-4,
+                                         5e-4, 1e-3, 5e-3, 1e-2, 5e-2,
+                                         0.1,  0.5,  1.0,  5.0};
+
+} // namespace
+
+// --- LatencyBuckets ---
+
+std::size_t LatencyBuckets::indexOf(std::uint64_t ns) {
+  if (ns < kSubBuckets) {
+    return static_cast<std::size_t>(ns);
+  }
+  const int msb = highestBit(ns);
+  const std::size_t index =
+      static_cast<std::size_t>(msb - 3) * kSubBuckets +
+      static_cast<std::size_t>((ns >> (msb - 4)) - kSubBuckets);
+  return std::min(index, kCount - 1);
+}
+
+std::uint64_t LatencyBuckets::upperBound(std::size_t index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  const int shift = static_cast<int>(index / kSubBuckets) - 1;
+  const std::uint64_t sub = index % kSubBuckets;
+  return ((kSubBuckets + sub + 1) << shift) - 1;
+}
+
+std::uint64_t LatencySnapshot::quantileNs(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  // Nearest rank: the smallest value with at least q * count values <= it.
+  const auto rank = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(
+             std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count))));
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return std::min(LatencyBuckets::upperBound(i), max_ns);
+    }
+  }
+  return max_ns;
+}
+
+// --- Metrics ---
+
+struct Metrics::Counters {
+  std::atomic<std::uint64_t> calls;
+  std::atomic<std::uint64_t> errors;
+  std::atomic<std::uint64_t> rows;
+  std::atomic<std::uint64_t> bytes;
+  std::atomic<std::uint64_t> sum_ns;
+  std::atomic<std::uint64_t> max_ns;
+  std::array<std::atomic<std::uint64_t>, LatencyBuckets::kCount> buckets;
+};
+
+struct Metrics::Shard {
+  // Allocated by the owning thread on its first call of each operation.
+  std::array<std::atomic<Counters *>, kMaxOperations> operations{};
+  std::atomic<bool> in_use{true};
+
+  ~Shard() {
+    for (auto &counters : operations) {
+      delete counters.load();
+    }
+  }
+};
+
+// Hands a shard to the calling thread and frees it again at thread exit.
+struct ShardLease {
+  Metrics::Shard *shard = nullptr;
+  ~ShardLease() {
+    if (shard) {
+      shard->in_use.store(false, std::memory_order_release);
+    }
+  }
+};
+
+Metrics &Metrics::global() {
+  // Never destroyed: threads may still record during static destruction.
+  static Metrics *const metrics = new Metrics();
+  return *metrics;
+}
+
+Metrics::~Metrics() = default;
+
+MetricId Metrics::registerOperation(const std::string &layer,
+                                    const std::string &operation) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::size_t i = 0; i < operations_.size(); ++i) {
+    if (operations_[i].first == layer && operations_[i].second == operation) {
+      return i;
+    }
+  }
+  if (operations_.size() == kMaxOperations) {
+    throw std::length_error("Metrics: too many operations registered.");
+  }
+  operations_.emplace_back(layer, operation);
+  return operations_.size() - 1;
+}
+
+Metrics::Shard &Metrics::localShard() {
+  thread_local ShardLease lease;
+  if (lease.shard) {
+    return *lease.shard;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &shard : shards_) {
+    bool expected = false;
+    if (shard->in_use.compare_exchange_strong(expected, true,
+                                              std::memory_order_acquire)) {
+      lease.shard = shard.get();
+      return *lease.shard;
+    }
+  }
+  shards_.push_back(std::make_unique<Shard>());
+  lease.shard = shards_.back().get();
+  return *lease.shard;
+}
+
+void Metrics::record(MetricId id, std::chrono::nanoseconds latency,
+                     bool failed, std::uint64_t rows, std::uint64_t bytes) {
+  if (id >= kMaxOperations) {
+    return;
+  }
+  Shard &shard = localShard();
+  Counters *counters =
+      shard.operations[id].load(std::memory_order_relaxed);
+  if (!counters) {
+    counters = new Counters();
+    shard.operations[id].store(counters, std::memory_order_release);
+  }
+  const auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(
+      0, static_cast<std::int64_t>(latency.count())));
+  bump(counters->calls);
+  if (failed) {
+    bump(counters->errors);
+  }
+  bump(counters->rows, rows);
+  bump(counters->bytes, bytes);
+  bump(counters->sum_ns, ns);
+  if (ns > counters->max_ns.load(std::memory_order_relaxed)) {
+    counters->max_ns.store(ns, std::memory_order_relaxed);
+  }
+  bump(counters->buckets[LatencyBuckets::indexOf(ns)]);
+}
+
+std::vector<OperationStats> Metrics::snapshot() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<OperationStats> stats(operations_.size());
+  for (std::size_t id = 0; id < operations_.size(); ++id) {
+    OperationStats &op = stats[id];
+    op.layer = operations_[id].first;
+    op.operation = operations_[id].second;
+    for (const auto &shard : shards_) {
+      const Counters *counters =
+          shard->operations[id].load(std::memory_order_acquire);
+      if (!counters) {
+        continue;
+      }
+      const auto read = [](const std::atomic<std::uint64_t> &value) {
+        return value.load(std::memory_order_relaxed);
+      };
+      op.calls += read(counters->calls);
+      op.errors += read(counters->errors);
+      op.rows += read(counters->rows);
+      op.bytes += read(counters->bytes);
+      op.latency.sum_ns += read(counters->sum_ns);
+      op.latency.max_ns = std::max(op.latency.max_ns, read(counters->max_ns));
+      for (std::size_t b = 0; b < LatencyBuckets::kCount; ++b) {
+        const std::uint64_t n = read(counters->buckets[b]);
+        op.latency.buckets[b] += n;
+        op.latency.count += n;
+      }
+    }
+  }
+  return stats;
+}
+
+// --- Prometheus ---
+
+void writePrometheus(const std::vector<OperationStats> &stats,
+                     std::ostream &out) {
+  const auto labels = [](const OperationStats &op) {
+    return "layer=\"" + op.layer + "\",operation=\"" + op.operation + "\"";
+  };
+  char number[32];
+
+  out << "# HELP cppcrudbp_operation_duration_seconds Latency per "
+         "operation.\n"
+      << "# TYPE cppcrudbp_operation_duration_seconds histogram\n";
+  for (const auto &op : stats) {
+    const std::string label = labels(op);
+    std::size_t bucket = 0;
+    std::uint64_t cumulative = 0;
+    for (const double le : kPrometheusBuckets) {
+      // A bucket counts toward "le" once all its values are <= le.
+      const auto le_ns = static_cast<std::uint64_t>(le * 1e9);
+      while (bucket < LatencyBuckets::kCount &&
+             LatencyBuckets::upperBound(bucket) <= le_ns) {
+        cumulative += op.latency.buckets[bucket++];
+      }
+      std::snprintf(number, sizeof(number), "%g", le);
+      out << "cppcrudbp_operation_duration_seconds_bucket{" << label
+          << ",le=\"" << number << "\"} " << cumulative << '\n';
+    }
+    std::snprintf(number, sizeof(number), "%.9f",
+                  static_cast<double>(op.latency.sum_ns) / 1e9);
+    out << "cppcrudbp_operation_duration_seconds_bucket{" << label
+        << ",le=\"+Inf\"} " << op.latency.count << '\n'
+        << "cppcrudbp_operation_duration_seconds_sum{" << label << "} "
+        << number << '\n'
+        << "cppcrudbp_operation_duration_seconds_count{" << label << "} "
+        << op.latency.count << '\n';
+  }
+
+  const std::pair<const char *, std::uint64_t OperationStats::*> counters[] =
+      {{"calls", &OperationStats::calls},
+       {"errors", &OperationStats::errors},
+       {"rows", &OperationStats::rows},
+       {"bytes", &OperationStats::bytes}};
+  for (const auto &[name, member] : counters) {
+    out << "# TYPE cppcrudbp_operation_" << name << "_total counter\n";
+    for (const auto &op : stats) {
+      out << "cppcrudbp_operation_" << name << "_total{" << labels(op)
+          << "} " << op.*member << '\n';
+    }
+  }
+}
+
+} // namespace cppcrudbp::common
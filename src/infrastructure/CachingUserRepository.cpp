@@ -0,0 +1,388 @@
+#include "infrastructure/caching_user_repository.h"
+#include "common/logger.h"
+#include "infrastructure/active_unit_of_work.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace cppcrudbp::infrastructure {
+
+// Tracks the writes made in the wrapped unit of work so the cache can be
+// corrected once their outcome is known.
+class CachingUnitOfWork final : public domain::IUnitOfWork,
+                                public ActiveUnitOfWork<CachingUnitOfWork> {
+public:
+  CachingUnitOfWork(CachingUserRepository &owner,
+                    std::unique_ptr<domain::IUnitOfWork> inner)
+      : ActiveUnitOfWork(&owner), owner_(owner), inner_(std::move(inner)) {}
+  ~CachingUnitOfWork() override { rollback(); }
+
+  bool commit() override {
+    if (!inner_) {
+      return false;
+    }
+    const bool committed = inner_->commit();
+    finish();
+    return committed;
+  }
+
+  void rollback() override {
+    if (!inner_) {
+      return;
+    }
+    inner_->rollback();
+    finish();
+  }
+
+  void wrote(int id) { written_.push_back(id); }
+  void created() { created_ = true; }
+  void wroteUnknown() { wrote_unknown_ = true; }
+
+private:
+  void finish() {
+    deactivate();
+    inner_.reset();
+    if (wrote_unknown_) {
+      owner_.invalidateAll();
+    }
+    for (const int id : written_) {
+      owner_.invalidate(id);
+    }
+    if (created_) {
+      owner_.creates_.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  CachingUserRepository &owner_;
+  std::unique_ptr<domain::IUnitOfWork> inner_;
+  std::vector<int> written_;
+  bool created_ = false;
+  bool wrote_unknown_ = false;
+};
+
+CachingUserRepository::CachingUserRepository(
+    std::shared_ptr<cppcrudbp::domain::IUserRepository> inner,
+    UserCacheOptions options)
+    : inner_(std::move(inner)), options_(options) {
+  if (!inner_) {
+    throw std::invalid_argument("Wrapped repository cannot be null.");
+  }
+  if (options_.shards == 0 || options_.capacity == 0) {
+    throw std::invalid_argument("Cache shards and capacity must be positive.");
+  }
+  shard_capacity_ =
+      std::max<std::size_t>(1, options_.capacity / options_.shards);
+  shards_ = std::make_unique<Shard[]>(options_.shards);
+}
+
+CachingUserRepository::Shard &CachingUserRepository::shardFor(int id) {
+  const auto key = static_cast<std::uint32_t>(id) * 0x9E3779B1u;
+  return shards_[key % options_.shards];
+}
+
+void CachingUserRepository::store(
+    Shard &shard, std::uint64_t epoch, std::uint64_t creates_seen,
+    const std::optional<application::UserResponse> &user, int id) {
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (shard.epoch != epoch) {
+    return; // Invalidated while we were reading; the value may be stale.
+  }
+  if (const auto it = shard.index.find(id); it != shard.index.end()) {
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+  }
+  shard.lru.push_front(
+      Entry{id, user, Clock::now() + options_.negative_ttl, creates_seen});
+  shard.index.emplace(id, shard.lru.begin());
+  if (shard.lru.size() > shard_capacity_) {
+    shard.index.erase(shard.lru.back().id);
+    shard.lru.pop_back();
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void CachingUserRepository::invalidate(int id) {
+  Shard &shard = shardFor(id);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  ++shard.epoch;
+  if (const auto it = shard.index.find(id); it != shard.index.end()) {
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+  }
+  invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CachingUserRepository::invalidateAll() {
+  for (std::size_t i = 0; i < options_.shards; ++i) {
+    Shard &shard = shards_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ++shard.epoch;
+    invalidations_.fetch_add(shard.lru.size(), std::memory_order_relaxed);
+    shard.index.clear();
+    shard.lru.clear();
+  }
+}
+
+std::optional<application::UserResponse>
+CachingUserRepository::createUser(const application::CreateUserRequest &user) {
+  auto created = inner_->createUser(user);
+  // The new id may have been cached as missing; retire all negatives.
+  creates_.fetch_add(1, std::memory_order_release);
+  if (auto *unit = CachingUnitOfWork::find(this)) {
+    unit->created(); // And again once it is visible to everyone.
+  }
+  return created;
+}
+
+application::BulkCreateResult CachingUserRepository::bulkCreateUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  auto result = inner_->bulkCreateUsers(users);
+  creates_.fetch_add(1, std::memory_order_release);
+  if (auto *unit = CachingUnitOfWork::find(this)) {
+    unit->created();
+  }
+  return result;
+}
+
+// Serves @p id into @p user if the shard holds a fresh entry for it. On a
+// miss returns false, with @p epoch set for the store() that follows the
+// read.
+bool CachingUserRepository::lookup(
+    Shard &shard, int id, std::optional<application::UserResponse> &user,
+    std::uint64_t &epoch) {
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (const auto it = shard.index.find(id); it != shard.index.end()) {
+    Entry &entry = *it->second;
+    const bool fresh =
+        entry.user ||
+        (Clock::now() < entry.expires &&
+         entry.creates_seen == creates_.load(std::memory_order_acquire));
+    if (fresh) {
+      shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+      (entry.user ? hits_ : negative_hits_)
+          .fetch_add(1, std::memory_order_relaxed);
+      user = entry.user;
+      return true;
+    }
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+  }
+  epoch = shard.epoch;
+  return false;
+}
+
+application::BulkUpsertResult CachingUserRepository::upsertUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  invalidateAll();
+  auto result = inner_->upsertUsers(users);
+  invalidateAll();
+  creates_.fetch_add(1, std::memory_order_release);
+  if (auto *unit = CachingUnitOfWork::find(this)) {
+    unit->created();
+    unit->wroteUnknown();
+  }
+  return result;
+}
+
+std::optional<application::UserResponse>
+CachingUserRepository::getUserById(int id) {
+  try {
+    return findUserById(id);
+  } catch (const std::exception &e) {
+    common::logError("cache", "Error fetching user: ", e.what());
+    return std::nullopt;
+  }
+}
+
+std::optional<application::UserResponse>
+CachingUserRepository::findUserById(int id) {
+  if (CachingUnitOfWork::find(this)) {
+    return inner_->findUserById(id);
+  }
+  Shard &shard = shardFor(id);
+  std::optional<application::UserResponse> user;
+  std::uint64_t epoch;
+  if (lookup(shard, id, user, epoch)) {
+    return user;
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  // Sampled before the read so a create racing with it retires the entry.
+  const std::uint64_t creates_seen = creates_.load(std::memory_order_acquire);
+  // A failed read throws past store(): it is no proof the user is missing.
+  user = inner_->findUserById(id);
+  store(shard, epoch, creates_seen, user, id);
+  return user;
+}
+
+std::optional<application::UserResponse>
+CachingUserRepository::getUserByEmail(const std::string &email) {
+  return inner_->getUserByEmail(email);
+}
+
+application::UserBatch
+CachingUserRepository::getUsersByIds(const std::vector<int> &ids) {
+  try {
+    return findUsersByIds(ids);
+  } catch (const std::exception &e) {
+    common::logError("cache", "Error fetching users by id: ", e.what());
+    return {};
+  }
+}
+
+application::UserBatch
+CachingUserRepository::findUsersByIds(const std::vector<int> &ids) {
+  if (CachingUnitOfWork::find(this)) {
+    return inner_->findUsersByIds(ids);
+  }
+  std::vector<int> sorted(ids);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  std::vector<application::UserResponse> hits;
+  std::vector<int> missing;
+  std::vector<std::uint64_t> epochs;
+  for (const int id : sorted) {
+    std::optional<application::UserResponse> user;
+    std::uint64_t epoch;
+    if (!lookup(shardFor(id), id, user, epoch)) {
+      missing.push_back(id);
+      epochs.push_back(epoch);
+    } else if (user) {
+      hits.push_back(std::move(*user));
+    }
+  }
+
+  application::UserBatch fetched;
+  if (!missing.empty()) {
+    misses_.fetch_add(missing.size(), std::memory_order_relaxed);
+    const std::uint64_t creates_seen =
+        creates_.load(std::memory_order_acquire);
+    fetched = inner_->findUsersByIds(missing);
+    // Both are ordered by id; ids absent from fetched are cached as missing.
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < missing.size(); ++i) {
+      std::optional<application::UserResponse> user;
+      if (found < fetched.size() && fetched.ids()[found] == missing[i]) {
+        user = fetched.user(found++);
+      }
+      store(shardFor(missing[i]), epochs[i], creates_seen, user, missing[i]);
+    }
+    if (hits.empty()) {
+      return fetched;
+    }
+  }
+
+  // Merge the hits and the fetched users back into id order.
+  application::UserBatch users;
+  users.reserve(hits.size() + fetched.size());
+  std::size_t next = 0;
+  for (const auto &hit : hits) {
+    for (; next < fetched.size() && fetched.ids()[next] < hit.id; ++next) {
+      users.push_back(fetched[next]);
+    }
+    users.push_back(hit.id, hit.name, hit.email);
+  }
+  for (; next < fetched.size(); ++next) {
+    users.push_back(fetched[next]);
+  }
+  return users;
+}
+
+application::UserBatch CachingUserRepository::getAllUsers() {
+  return inner_->getAllUsers();
+}
+
+application::UserBatch
+CachingUserRepository::getUsersPage(int after_id, std::size_t limit) {
+  return inner_->getUsersPage(after_id, limit);
+}
+
+application::UserBatch CachingUserRepository::searchUsersByNamePrefix(
+    const std::string &prefix, const application::NameCursor &after,
+    std::size_t limit) {
+  return inner_->searchUsersByNamePrefix(prefix, after, limit);
+}
+
+bool CachingUserRepository::forEachUser(const domain::UserVisitor &visitor) {
+  return inner_->forEachUser(visitor);
+}
+
+std::optional<application::UserResponse>
+CachingUserRepository::updateUser(const cppcrudbp::domain::User &user) {
+  invalidate(user.id);
+  auto updated = inner_->updateUser(user);
+  invalidate(user.id); // Drop anything read back during the write.
+  if (auto *unit = CachingUnitOfWork::find(this)) {
+    unit->wrote(user.id);
+  }
+  return updated;
+}
+
+std::vector<int> CachingUserRepository::updateUsers(
+    const std::vector<cppcrudbp::domain::User> &users) {
+  for (const auto &user : users) {
+    invalidate(user.id);
+  }
+  auto updated = inner_->updateUsers(users);
+  auto *unit = CachingUnitOfWork::find(this);
+  for (const auto &user : users) {
+    invalidate(user.id);
+    if (unit) {
+      unit->wrote(user.id);
+    }
+  }
+  return updated;
+}
+
+bool CachingUserRepository::deleteUser(int id) {
+  invalidate(id);
+  const bool deleted = inner_->deleteUser(id);
+  invalidate(id);
+  if (auto *unit = CachingUnitOfWork::find(this)) {
+    unit->wrote(id);
+  }
+  return deleted;
+}
+
+std::vector<int>
+CachingUserRepository::deleteUsers(const std::vector<int> &ids) {
+  for (const int id : ids) {
+    invalidate(id);
+  }
+  auto deleted = inner_->deleteUsers(ids);
+  auto *unit = CachingUnitOfWork::find(this);
+  for (const int id : ids) {
+    invalidate(id);
+    if (unit) {
+      unit->wrote(id);
+    }
+  }
+  return deleted;
+}
+
+std::unique_ptr<domain::IUnitOfWork> CachingUserRepository::beginUnitOfWork() {
+  if (CachingUnitOfWork::find(this)) {
+    return nullptr;
+  }
+  auto inner = inner_->beginUnitOfWork();
+  if (!inner) {
+    return nullptr;
+  }
+  return std::make_unique<CachingUnitOfWork>(*this, std::move(inner));
+}
+
+UserCacheStats CachingUserRepository::stats() const {
+  UserCacheStats snapshot;
+  snapshot.hits = hits_.load(std::memory_order_relaxed);
+  snapshot.negative_hits = negative_hits_.load(std::memory_order_relaxed);
+  snapshot.misses = misses_.load(std::memory_order_relaxed);
+  snapshot.evictions = evictions_.load(std::memory_order_relaxed);
+  snapshot.invalidations = invalidations_.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < options_.shards; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mutex);
+    snapshot.entries += shards_[i].lru.size();
+  }
+  return snapshot;
+}
+
+} // namespace cppcrudbp::infrastructure
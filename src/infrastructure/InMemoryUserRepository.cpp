@@ -0,0 +1,520 @@
+#include "infrastructure/in_memory_user_repository.h"
+#include "infrastructure/active_unit_of_work.h"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace cppcrudbp::infrastructure {
+
+namespace {
+// Records handed to a visitor per lock acquisition in forEachUser.
+constexpr std::size_t kVisitChunk = 256;
+// Dead records tolerated before compaction is considered.
+constexpr std::size_t kMinDeadToCompact = 1024;
+constexpr std::uint32_t kNoRecord = common::OpenAddressingIndex::kNoRecord;
+} // namespace
+
+// Undo log of the writes made by one thread since beginUnitOfWork().
+class InMemoryUnitOfWork final
+    : public domain::IUnitOfWork,
+      public ActiveUnitOfWork<InMemoryUnitOfWork> {
+public:
+  enum class Kind { kCreated, kUpdated, kDeleted };
+
+  // Called with the repository's writer lock held.
+  explicit InMemoryUnitOfWork(InMemoryUserRepository &owner)
+      : ActiveUnitOfWork(&owner), owner_(owner) {
+    ++owner_.open_units_;
+  }
+  ~InMemoryUnitOfWork() override { rollback(); }
+
+  bool commit() override {
+    if (!open_) {
+      return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(owner_.mutex_);
+    undo_.clear();
+    finishLocked();
+    return true;
+  }
+
+  void rollback() override {
+    if (!open_) {
+      return;
+    }
+    std::unique_lock<std::shared_mutex> lock(owner_.mutex_);
+    for (auto it = undo_.rbegin(); it != undo_.rend(); ++it) {
+      const std::uint32_t record = owner_.findRecordLocked(it->id);
+      if (record == kNoRecord) {
+        continue;
+      }
+      auto &r = owner_.records_[record];
+      switch (it->kind) {
+      case Kind::kCreated:
+        if (r.live) {
+          owner_.eraseLocked(record);
+        }
+        break;
+      case Kind::kUpdated:
+        if (r.live) {
+          owner_.updateLocked(record, it->name, it->email);
+        }
+        break;
+      case Kind::kDeleted:
+        if (!r.live && owner_.findByEmailLocked(it->email) == kNoRecord) {
+          r.live = true;
+          r.name = std::move(it->name);
+          r.email = std::move(it->email);
+          owner_.by_id_.insert(InMemoryUserRepository::hashId(r.id), record);
+          owner_.by_email_.insert(InMemoryUserRepository::hashEmail(r.email),
+                                  record);
+          owner_.by_name_.emplace(r.name, r.id);
+          ++owner_.live_;
+        }
+        break;
+      }
+    }
+    undo_.clear();
+    finishLocked();
+  }
+
+  // Called with the repository's writer lock held.
+  void record(Kind kind, int id, std::string name = {},
+              std::string email = {}) {
+    undo_.push_back(Undo{kind, id, std::move(name), std::move(email)});
+  }
+
+private:
+  struct Undo {
+    Kind kind;
+    int id;
+    std::string name; // Previous values, for kUpdated and kDeleted.
+    std::string email;
+  };
+
+  void finishLocked() {
+    deactivate();
+    open_ = false;
+    --owner_.open_units_;
+    owner_.compactLocked();
+  }
+
+  InMemoryUserRepository &owner_;
+  std::vector<Undo> undo_;
+  bool open_ = true;
+};
+
+InMemoryUserRepository::InMemoryUserRepository(std::size_t expected_users)
+    : by_id_(expected_users), by_email_(expected_users) {
+  records_.reserve(expected_users);
+}
+
+std::uint64_t InMemoryUserRepository::hashId(int id) {
+  return static_cast<std::uint64_t>(static_cast<std::uint32_t>(id)) *
+         0x9E3779B97F4A7C15ull;
+}
+
+std::uint64_t InMemoryUserRepository::hashEmail(std::string_view email) {
+  return std::hash<std::string_view>{}(email);
+}
+
+std::uint32_t InMemoryUserRepository::findByIdLocked(int id) const {
+  return by_id_.find(hashId(id), [&](std::uint32_t record) {
+    return records_[record].id == id;
+  });
+}
+
+std::uint32_t
+InMemoryUserRepository::findByEmailLocked(std::string_view email) const {
+  return by_email_.find(hashEmail(email), [&](std::uint32_t record) {
+    return records_[record].email == email;
+  });
+}
+
+std::uint32_t InMemoryUserRepository::findRecordLocked(int id) const {
+  const auto it = std::lower_bound(
+      records_.begin(), records_.end(), id,
+      [](const Record &r, int id) { return r.id < id; });
+  if (it == records_.end() || it->id != id) {
+    return kNoRecord;
+  }
+  return static_cast<std::uint32_t>(it - records_.begin());
+}
+
+bool InMemoryUserRepository::insertLocked(
+    const application::CreateUserRequest &user) {
+  if (findByEmailLocked(user.email) != kNoRecord) {
+    return false; // UNIQUE (email)
+  }
+  const auto record = static_cast<std::uint32_t>(records_.size());
+  const int id = next_id_++;
+  records_.push_back(Record{id, true, user.name, user.email});
+  by_id_.insert(hashId(id), record);
+  by_email_.insert(hashEmail(user.email), record);
+  by_name_.emplace(user.name, id);
+  ++live_;
+  if (auto *unit = InMemoryUnitOfWork::find(this)) {
+    unit->record(InMemoryUnitOfWork::Kind::kCreated, id);
+  }
+  return true;
+}
+
+bool InMemoryUserRepository::updateLocked(std::uint32_t record,
+                                          const std::string &name,
+                                          const std::string &email) {
+  Record &r = records_[record];
+  if (r.email != email) {
+    if (findByEmailLocked(email) != kNoRecord) {
+      return false; // UNIQUE (email)
+    }
+    by_email_.erase(hashEmail(r.email), [&](std::uint32_t candidate) {
+      return candidate == record;
+    });
+    r.email = email;
+    by_email_.insert(hashEmail(r.email), record);
+  }
+  if (r.name != name) {
+    by_name_.erase({r.name, r.id});
+    r.name = name;
+    by_name_.emplace(r.name, r.id);
+  }
+  return true;
+}
+
+void InMemoryUserRepository::eraseLocked(std::uint32_t record) {
+  Record &r = records_[record];
+  const auto is_record = [&](std::uint32_t candidate) {
+    return candidate == record;
+  };
+  by_id_.erase(hashId(r.id), is_record);
+  by_email_.erase(hashEmail(r.email), is_record);
+  by_name_.erase({r.name, r.id});
+  r.live = false;
+  std::string().swap(r.name);
+  std::string().swap(r.email);
+  --live_;
+}
+
+void InMemoryUserRepository::compactLocked() {
+  const std::size_t dead = records_.size() - live_;
+  if (open_units_ > 0 || dead < kMinDeadToCompact || dead < live_) {
+    return;
+  }
+  records_.erase(std::remove_if(records_.begin(), records_.end(),
+                                [](const Record &r) { return !r.live; }),
+                 records_.end());
+  by_id_.clear();
+  by_email_.clear();
+  for (std::uint32_t i = 0; i < records_.size(); ++i) {
+    by_id_.insert(hashId(records_[i].id), i);
+    by_email_.insert(hashEmail(records_[i].email), i);
+  }
+}
+
+std::optional<application::UserResponse>
+InMemoryUserRepository::createUser(const application::CreateUserRequest &user) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  if (!insertLocked(user)) {
+    return std::nullopt;
+  }
+  const Record &r = records_.back();
+  return application::UserResponse{r.id, r.name, r.email};
+}
+
+application::BulkCreateResult InMemoryUserRepository::bulkCreateUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  application::BulkCreateResult result;
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  records_.reserve(records_.size() + users.size());
+  by_id_.reserve(live_ + users.size());
+  by_email_.reserve(live_ + users.size());
+  for (const auto &user : users) {
+    if (insertLocked(user)) {
+      ++result.inserted;
+    } else {
+      result.rejected_emails.push_back(user.email);
+    }
+  }
+  return result;
+}
+
+application::BulkUpsertResult InMemoryUserRepository::upsertUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  // Last row per email wins, applied in the order of those last rows.
+  std::unordered_map<std::string_view, std::size_t> last;
+  last.reserve(users.size());
+  for (std::size_t i = 0; i < users.size(); ++i) {
+    last[users[i].email] = i;
+  }
+
+  application::BulkUpsertResult result;
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  auto *unit = InMemoryUnitOfWork::find(this);
+  for (std::size_t i = 0; i < users.size(); ++i) {
+    const auto &user = users[i];
+    if (last[user.email] != i) {
+      continue;
+    }
+    const std::uint32_t record = findByEmailLocked(user.email);
+    if (record == kNoRecord) {
+      insertLocked(user);
+      ++result.inserted;
+      continue;
+    }
+    Record &r = records_[record];
+    if (r.name == user.name) {
+      ++result.unchanged;
+      continue;
+    }
+    if (unit) {
+      unit->record(InMemoryUnitOfWork::Kind::kUpdated, r.id, r.name, r.email);
+    }
+    updateLocked(record, user.name, r.email);
+    ++result.updated;
+  }
+  return result;
+}
+
+std::optional<application::UserResponse>
+InMemoryUserRepository::getUserById(int id) {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  const std::uint32_t record = findByIdLocked(id);
+  if (record == kNoRecord) {
+    return std::nullopt;
+  }
+  const Record &r = records_[record];
+  return application::UserResponse{r.id, r.name, r.email};
+}
+
+std::optional<application::UserResponse>
+InMemoryUserRepository::getUserByEmail(const std::string &email) {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  const std::uint32_t record = findByEmailLocked(email);
+  if (record == kNoRecord) {
+    return std::nullopt;
+  }
+  const Record &r = records_[record];
+  return application::UserResponse{r.id, r.name, r.email};
+}
+
+application::UserBatch
+InMemoryUserRepository::getUsersByIds(const std::vector<int> &ids) {
+  std::vector<int> sorted(ids);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  application::UserBatch users;
+  users.reserve(std::min(sorted.size(), live_));
+  for (const int id : sorted) {
+    const std::uint32_t record = findByIdLocked(id);
+    if (record != kNoRecord) {
+      const Record &r = records_[record];
+      users.push_back(r.id, r.name, r.email);
+    }
+  }
+  return users;
+}
+
+application::UserBatch InMemoryUserRepository::getAllUsers() {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  std::size_t text_bytes = 0;
+  for (const Record &r : records_) {
+    text_bytes += r.name.size() + r.email.size(); // Empty once dead.
+  }
+  application::UserBatch users;
+  users.reserve(live_, text_bytes);
+  for (const Record &r : records_) {
+    if (r.live) {
+      users.push_back(r.id, r.name, r.email);
+    }
+  }
+  return users;
+}
+
+application::UserBatch
+InMemoryUserRepository::getUsersPage(int after_id, std::size_t limit) {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  application::UserBatch users;
+  auto it = std::upper_bound(
+      records_.begin(), records_.end(), after_id,
+      [](int id, const Record &r) { return id < r.id; });
+  for (; it != records_.end() && users.size() < limit; ++it) {
+    if (it->live) {
+      users.push_back(it->id, it->name, it->email);
+    }
+  }
+  return users;
+}
+
+application::UserBatch InMemoryUserRepository::searchUsersByNamePrefix(
+    const std::string &prefix, const application::NameCursor &after,
+    std::size_t limit) {
+  // Start at the later of the cursor and the first name with the prefix.
+  const bool before_prefix = after.name < prefix;
+  const std::pair<std::string, int> from{before_prefix ? prefix : after.name,
+                                         before_prefix ? 0 : after.id};
+
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  application::UserBatch users;
+  for (auto it = by_name_.upper_bound(from);
+       it != by_name_.end() && users.size() < limit &&
+       it->first.compare(0, prefix.size(), prefix) == 0;
+       ++it) {
+    const Record &r = records_[findByIdLocked(it->second)];
+    users.push_back(r.id, r.name, r.email);
+  }
+  return users;
+}
+
+bool InMemoryUserRepository::forEachUser(const domain::UserVisitor &visitor) {
+  // Copy small chunks under the lock and visit them without it, so a slow
+  // or re-entrant visitor never blocks writers.
+  int after_id = 0;
+  application::UserResponse user;
+  while (true) {
+    const application::UserBatch chunk = getUsersPage(after_id, kVisitChunk);
+    for (const application::UserView view : chunk) {
+      user.id = view.id; // Reuses the strings' capacity.
+      user.name.assign(view.name);
+      user.email.assign(view.email);
+      visitor(user);
+    }
+    if (chunk.size() < kVisitChunk) {
+      return true;
+    }
+    after_id = chunk.back().id;
+  }
+}
+
+std::optional<application::UserResponse>
+InMemoryUserRepository::updateUser(const cppcrudbp::domain::User &user) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  const std::uint32_t record = findByIdLocked(user.id);
+  if (record == kNoRecord) {
+    return std::nullopt;
+  }
+  auto *unit = InMemoryUnitOfWork::find(this);
+  Record previous = unit ? records_[record] : Record{};
+  if (!updateLocked(record, user.name, user.email)) {
+    return std::nullopt;
+  }
+  if (unit) {
+    unit->record(InMemoryUnitOfWork::Kind::kUpdated, user.id,
+                 std::move(previous.name), std::move(previous.email));
+  }
+  const Record &r = records_[record];
+  return application::UserResponse{r.id, r.name, r.email};
+}
+
+std::vector<int> InMemoryUserRepository::updateUsers(
+    const std::vector<cppcrudbp::domain::User> &users) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  auto *unit = InMemoryUnitOfWork::find(this);
+  std::vector<int> updated;
+  updated.reserve(users.size());
+  // Backwards, applying only the last update of each id.
+  std::unordered_set<int> seen;
+  for (auto it = users.rbegin(); it != users.rend(); ++it) {
+    const auto &user = *it;
+    if (!seen.insert(user.id).second) {
+      continue;
+    }
+    const std::uint32_t record = findByIdLocked(user.id);
+    if (record == kNoRecord) {
+      continue;
+    }
+    Record previous = unit ? records_[record] : Record{};
+    if (!updateLocked(record, user.name, user.email)) {
+      continue;
+    }
+    if (unit) {
+      unit->record(InMemoryUnitOfWork::Kind::kUpdated, user.id,
+                   std::move(previous.name), std::move(previous.email));
+    }
+    updated.push_back(user.id);
+  }
+  std::sort(updated.begin(), updated.end());
+  return updated;
+}
+
+bool InMemoryUserRepository::deleteUser(int id) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  const std::uint32_t record = findByIdLocked(id);
+  if (record == kNoRecord) {
+    return false;
+  }
+  if (auto *unit = InMemoryUnitOfWork::find(this)) {
+    unit->record(InMemoryUnitOfWork::Kind::kDeleted, id, records_[record].name,
+                 records_[record].email);
+  }
+  eraseLocked(record);
+  compactLocked();
+  return true;
+}
+
+std::vector<int>
+InMemoryUserRepository::deleteUsers(const std::vector<int> &ids) {
+  std::vector<int> sorted(ids);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  auto *unit = InMemoryUnitOfWork::find(this);
+  std::vector<int> deleted;
+  deleted.reserve(sorted.size());
+  for (const int id : sorted) {
+    const std::uint32_t record = findByIdLocked(id);
+    if (record == kNoRecord) {
+      continue;
+    }
+    if (unit) {
+      unit->record(InMemoryUnitOfWork::Kind::kDeleted, id,
+                   records_[record].name, records_[record].email);
+    }
+    eraseLocked(record);
+    deleted.push_back(id);
+  }
+  compactLocked(); // Once for the whole batch; it renumbers records.
+  return deleted;
+}
+
+std::unique_ptr<domain::IUnitOfWork>
+InMemoryUserRepository::beginUnitOfWork() {
+  if (InMemoryUnitOfWork::find(this)) {
+    return nullptr;
+  }
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return std::make_unique<InMemoryUnitOfWork>(*this);
+}
+
+std::size_t InMemoryUserRepository::size() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return live_;
+}
+
+std::size_t InMemoryUserRepository::memoryBytes() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  // A set node holds its key plus three pointers and a color.
+  constexpr std::size_t kNameNodeBytes =
+      sizeof(std::pair<std::string, int>) + 4 * sizeof(void *);
+  std::size_t bytes = records_.capacity() * sizeof(Record) +
+                      by_id_.memoryBytes() + by_email_.memoryBytes() +
+                      by_name_.size() * kNameNodeBytes;
+  for (const Record &r : records_) {
+    // Short strings live inside the Record itself (SSO); the name is held
+    // twice, once more by by_name_.
+    if (r.name.capacity() > 15) {
+      bytes += 2 * (r.name.capacity() + 1);
+    }
+    if (r.email.capacity() > 15) {
+      bytes += r.email.capacity() + 1;
+    }
+  }
+  return bytes;
+}
+
+} // namespace cppcrudbp::infrastructure
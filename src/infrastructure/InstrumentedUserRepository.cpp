@@ -0,0 +1,200 @@
+#include "infrastructure/instrumented_user_repository.h"
+#include <stdexcept>
+#include <utility>
+
+namespace cppcrudbp::infrastructure {
+
+namespace {
+
+class InstrumentedUnitOfWork final : public domain::IUnitOfWork {
+public:
+  InstrumentedUnitOfWork(std::unique_ptr<domain::IUnitOfWork> inner,
+                         common::MetricId commit)
+      : inner_(std::move(inner)), commit_(commit) {}
+
+  bool commit() override {
+    common::OperationTimer timer(commit_);
+    return timer.check(inner_->commit());
+  }
+  void rollback() override { inner_->rollback(); }
+
+private:
+  std::unique_ptr<domain::IUnitOfWork> inner_;
+  common::MetricId commit_;
+};
+
+} // namespace
+
+InstrumentedUserRepository::InstrumentedUserRepository(
+    std::shared_ptr<cppcrudbp::domain::IUserRepository> inner,
+    const std::string &layer)
+    : inner_(std::move(inner)) {
+  if (!inner_) {
+    throw std::invalid_argument("Wrapped repository cannot be null.");
+  }
+  auto &metrics = common::Metrics::global();
+  ids_.create = metrics.registerOperation(layer, "createUser");
+  ids_.bulk_create = metrics.registerOperation(layer, "bulkCreateUsers");
+  ids_.upsert = metrics.registerOperation(layer, "upsertUsers");
+  ids_.get_by_id = metrics.registerOperation(layer, "getUserById");
+  ids_.get_by_email = metrics.registerOperation(layer, "getUserByEmail");
+  ids_.get_by_ids = metrics.registerOperation(layer, "getUsersByIds");
+  ids_.get_all = metrics.registerOperation(layer, "getAllUsers");
+  ids_.get_page = metrics.registerOperation(layer, "getUsersPage");
+  ids_.search_by_name =
+      metrics.registerOperation(layer, "searchUsersByNamePrefix");
+  ids_.for_each = metrics.registerOperation(layer, "forEachUser");
+  ids_.update = metrics.registerOperation(layer, "updateUser");
+  ids_.update_many = metrics.registerOperation(layer, "updateUsers");
+  ids_.remove = metrics.registerOperation(layer, "deleteUser");
+  ids_.remove_many = metrics.registerOperation(layer, "deleteUsers");
+  ids_.begin = metrics.registerOperation(layer, "beginUnitOfWork");
+  ids_.commit = metrics.registerOperation(layer, "commitUnitOfWork");
+}
+
+std::optional<application::UserResponse>
+InstrumentedUserRepository::createUser(
+    const application::CreateUserRequest &user) {
+  common::OperationTimer timer(ids_.create);
+  auto created = inner_->createUser(user);
+  timer.check(created.has_value());
+  return created;
+}
+
+application::BulkCreateResult InstrumentedUserRepository::bulkCreateUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  common::OperationTimer timer(ids_.bulk_create);
+  auto result = inner_->bulkCreateUsers(users);
+  timer.check(result.failed == 0);
+  timer.addRows(result.inserted);
+  return result;
+}
+
+application::BulkUpsertResult InstrumentedUserRepository::upsertUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  common::OperationTimer timer(ids_.upsert);
+  auto result = inner_->upsertUsers(users);
+  timer.check(result.failed == 0);
+  timer.addRows(result.inserted + result.updated);
+  return result;
+}
+
+std::optional<application::UserResponse>
+InstrumentedUserRepository::getUserById(int id) {
+  common::OperationTimer timer(ids_.get_by_id);
+  auto user = inner_->getUserById(id);
+  timer.addRows(user ? 1 : 0);
+  return user;
+}
+
+std::optional<application::UserResponse>
+InstrumentedUserRepository::getUserByEmail(const std::string &email) {
+  common::OperationTimer timer(ids_.get_by_email);
+  auto user = inner_->getUserByEmail(email);
+  timer.addRows(user ? 1 : 0);
+  return user;
+}
+
+application::UserBatch
+InstrumentedUserRepository::getUsersByIds(const std::vector<int> &ids) {
+  common::OperationTimer timer(ids_.get_by_ids);
+  auto users = inner_->getUsersByIds(ids);
+  timer.addRows(users.size());
+  return users;
+}
+
+std::optional<application::UserResponse>
+InstrumentedUserRepository::findUserById(int id) {
+  common::OperationTimer timer(ids_.get_by_id); // A throw counts as failed.
+  auto user = inner_->findUserById(id);
+  timer.addRows(user ? 1 : 0);
+  return user;
+}
+
+application::UserBatch
+InstrumentedUserRepository::findUsersByIds(const std::vector<int> &ids) {
+  common::OperationTimer timer(ids_.get_by_ids);
+  auto users = inner_->findUsersByIds(ids);
+  timer.addRows(users.size());
+  return users;
+}
+
+application::UserBatch InstrumentedUserRepository::getAllUsers() {
+  common::OperationTimer timer(ids_.get_all);
+  auto users = inner_->getAllUsers();
+  timer.addRows(users.size());
+  return users;
+}
+
+application::UserBatch
+InstrumentedUserRepository::getUsersPage(int after_id, std::size_t limit) {
+  common::OperationTimer timer(ids_.get_page);
+  auto users = inner_->getUsersPage(after_id, limit);
+  timer.addRows(users.size());
+  return users;
+}
+
+application::UserBatch
+InstrumentedUserRepository::searchUsersByNamePrefix(
+    const std::string &prefix, const application::NameCursor &after,
+    std::size_t limit) {
+  common::OperationTimer timer(ids_.search_by_name);
+  auto users = inner_->searchUsersByNamePrefix(prefix, after, limit);
+  timer.addRows(users.size());
+  return users;
+}
+
+bool InstrumentedUserRepository::forEachUser(
+    const domain::UserVisitor &visitor) {
+  common::OperationTimer timer(ids_.for_each);
+  std::uint64_t rows = 0;
+  const bool completed = inner_->forEachUser(
+      [&visitor, &rows](const application::UserResponse &user) {
+        ++rows;
+        visitor(user);
+      });
+  timer.addRows(rows);
+  return timer.check(completed);
+}
+
+std::optional<application::UserResponse>
+InstrumentedUserRepository::updateUser(const domain::User &user) {
+  common::OperationTimer timer(ids_.update);
+  auto updated = inner_->updateUser(user);
+  timer.check(updated.has_value());
+  return updated;
+}
+
+std::vector<int> InstrumentedUserRepository::updateUsers(
+    const std::vector<cppcrudbp::domain::User> &users) {
+  common::OperationTimer timer(ids_.update_many);
+  auto updated = inner_->updateUsers(users);
+  timer.addRows(updated.size());
+  return updated;
+}
+
+bool InstrumentedUserRepository::deleteUser(int id) {
+  common::OperationTimer timer(ids_.remove);
+  return timer.check(inner_->deleteUser(id));
+}
+
+std::vector<int>
+InstrumentedUserRepository::deleteUsers(const std::vector<int> &ids) {
+  common::OperationTimer timer(ids_.remove_many);
+  auto deleted = inner_->deleteUsers(ids);
+  timer.addRows(deleted.size());
+  return deleted;
+}
+
+std::unique_ptr<domain::IUnitOfWork>
+InstrumentedUserRepository::beginUnitOfWork() {
+  common::OperationTimer timer(ids_.begin);
+  auto unit = inner_->beginUnitOfWork();
+  if (!timer.check(unit != nullptr)) {
+    return nullptr;
+  }
+  return std::make_unique<InstrumentedUnitOfWork>(std::move(unit),
+                                                  ids_.commit);
+}
+
+} // namespace cppcrudbp::infrastructure
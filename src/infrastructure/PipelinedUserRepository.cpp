@@ -0,0 +1,533 @@
+#include "infrastructure/pipelined_user_repository.h"
+#include "common/logger.h"
+#include "infrastructure/row_mapping.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <libpq-fe.h>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utility>
+
+namespace cppcrudbp::infrastructure {
+
+namespace {
+
+constexpr std::uint64_t kWakeToken = ~std::uint64_t{0};
+constexpr int kMaxEvents = 64;
+
+// Every statement the repository pipelines, prepared once per connection.
+const PreparedStatement *const kStatements[] = {
+    &user_statements::kCreate, &user_statements::kGetById,
+    &user_statements::kGetPage, &user_statements::kUpdate,
+    &user_statements::kDelete};
+
+// Field reader for mapRow over one row of a libpq result; NULL reads as
+// std::nullopt.
+auto fieldsOf(const PGresult *res, int row) {
+  return [res, row](std::size_t column) -> std::optional<std::string_view> {
+    const int c = static_cast<int>(column);
+    if (PQgetisnull(res, row, c)) {
+      return std::nullopt;
+    }
+    return std::string_view(PQgetvalue(res, row, c),
+                            static_cast<std::size_t>(PQgetlength(res, row, c)));
+  };
+}
+
+application::UserResponse rowToUser(const PGresult *res, int row) {
+  return mapRow<application::UserResponse>(fieldsOf(res, row));
+}
+
+application::UserView rowToView(const PGresult *res, int row) {
+  return mapRow<application::UserView>(fieldsOf(res, row));
+}
+
+// True if the command succeeded and affected at least one row.
+bool matchedAnyRow(const PGresult *res) {
+  // PQcmdTuples only reads the result despite its non-const parameter.
+  return res && std::strcmp(PQcmdTuples(const_cast<PGresult *>(res)), "0") != 0;
+}
+
+// Decodes a single-row result; nullopt if the query failed or matched
+// nothing.
+std::optional<application::UserResponse> singleUser(const PGresult *res) {
+  if (!res || PQntuples(res) == 0) {
+    return std::nullopt;
+  }
+  return rowToUser(res, 0);
+}
+
+} // namespace
+
+struct PipelinedUserRepository::Operation {
+  const PreparedStatement *statement;
+  std::vector<std::string> params;
+  const char *context; // Prefix for the error log line.
+  bool prepare = false; // Prepares the statement instead of executing it.
+  // Receives the query's result, or nullptr if it failed.
+  std::function<void(const PGresult *)> complete;
+  bool done = false;
+
+  void finish(const PGresult *res) {
+    if (!done) {
+      done = true;
+      complete(res);
+    }
+  }
+};
+
+struct PipelinedUserRepository::Connection {
+  std::size_t index;
+  PGconn *pg = nullptr;
+  int socket = -1;
+  std::uint32_t watched = 0; // Epoll events registered for socket.
+  bool want_write = false;
+  bool connecting = false; // Handshake in progress, driven by PQconnectPoll.
+  bool broken = false;     // A prepare failed; reconnect.
+  std::chrono::steady_clock::time_point next_retry{};
+  std::chrono::steady_clock::time_point connect_deadline{};
+  std::deque<std::unique_ptr<Operation>> in_flight;
+};
+
+PipelinedUserRepository::PipelinedUserRepository(std::string connection_string,
+                                                 PipelineOptions options)
+    : connection_string_(std::move(connection_string)), options_(options) {
+  if (options_.connections == 0 || options_.max_in_flight == 0) {
+    throw std::invalid_argument(
+        "PipelinedUserRepository: connections and max_in_flight must be "
+        "positive.");
+  }
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epoll_fd_ < 0 || wake_fd_ < 0) {
+    throw std::runtime_error(std::string("PipelinedUserRepository: ") +
+                             std::strerror(errno));
+  }
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.u64 = kWakeToken;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+  for (std::size_t i = 0; i < options_.connections; ++i) {
+    auto conn = std::make_unique<Connection>();
+    conn->index = i;
+    // The loop is not running yet, so the first connect may block.
+    conn->pg = PQconnectdb(connection_string_.c_str());
+    if (PQstatus(conn->pg) != CONNECTION_OK || !startSession(*conn)) {
+      common::logError("pipelined", "Pipelined connection failed: ",
+                       PQerrorMessage(conn->pg));
+      disconnect(*conn);
+      for (auto &open : connections_) {
+        disconnect(*open);
+      }
+      close(wake_fd_);
+      close(epoll_fd_);
+      throw std::runtime_error(
+          "PipelinedUserRepository: cannot connect to the database.");
+    }
+    connections_.push_back(std::move(conn));
+  }
+  loop_ = std::thread(&PipelinedUserRepository::eventLoop, this);
+}
+
+PipelinedUserRepository::~PipelinedUserRepository() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const auto written = write(wake_fd_, &one, sizeof(one));
+  loop_.join();
+  for (auto &conn : connections_) {
+    disconnect(*conn);
+  }
+  close(wake_fd_);
+  close(epoll_fd_);
+}
+
+template <typename T, typename Decode>
+std::future<T> PipelinedUserRepository::enqueue(
+    const PreparedStatement &statement, std::vector<std::string> params,
+    const char *context, Decode decode) {
+  auto promise = std::make_shared<std::promise<T>>();
+  std::future<T> future = promise->get_future();
+  auto op = std::make_unique<Operation>();
+  op->statement = &statement;
+  op->params = std::move(params);
+  op->context = context;
+  op->complete = [promise, decode](const PGresult *res) {
+    promise->set_value(decode(res));
+  };
+
+  bool stopping;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping = stopping_;
+    if (!stopping) {
+      submitted_.push_back(std::move(op));
+    }
+  }
+  if (stopping) {
+    op->finish(nullptr);
+    return future;
+  }
+  // Wake the loop; the eventfd counter coalesces concurrent wake-ups.
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const auto written = write(wake_fd_, &one, sizeof(one));
+  return future;
+}
+
+std::future<std::optional<application::UserResponse>>
+PipelinedUserRepository::createUser(
+    const application::CreateUserRequest &user) {
+  return enqueue<std::optional<application::UserResponse>>(
+      user_statements::kCreate, {user.name, user.email},
+      "Error creating user", singleUser);
+}
+
+std::future<std::optional<application::UserResponse>>
+PipelinedUserRepository::getUserById(int id) {
+  return enqueue<std::optional<application::UserResponse>>(
+      user_statements::kGetById, {std::to_string(id)}, "Error fetching user",
+      singleUser);
+}
+
+std::future<application::UserBatch>
+PipelinedUserRepository::getUsersPage(int after_id, std::size_t limit) {
+  return enqueue<application::UserBatch>(
+      user_statements::kGetPage,
+      {std::to_string(after_id), std::to_string(limit)},
+      "Error retrieving users page", [](const PGresult *res) {
+        application::UserBatch users;
+        if (res) {
+          const int rows = PQntuples(res);
+          std::size_t text_bytes = 0;
+          for (int row = 0; row < rows; ++row) {
+            const application::UserView user = rowToView(res, row);
+            text_bytes += user.name.size() + user.email.size();
+          }
+          users.reserve(static_cast<std::size_t>(rows), text_bytes);
+          for (int row = 0; row < rows; ++row) {
+            users.push_back(rowToView(res, row));
+          }
+        }
+        return users;
+      });
+}
+
+std::future<std::optional<application::UserResponse>>
+PipelinedUserRepository::updateUser(const cppcrudbp::domain::User &user) {
+  return enqueue<std::optional<application::UserResponse>>(
+      user_statements::kUpdate,
+      {user.name, user.email, std::to_string(user.id)}, "Error updating user",
+      singleUser);
+}
+
+std::future<bool> PipelinedUserRepository::deleteUser(int id) {
+  return enqueue<bool>(user_statements::kDelete, {std::to_string(id)},
+                       "Error deleting user", matchedAnyRow);
+}
+
+void PipelinedUserRepository::eventLoop() {
+  std::deque<std::unique_ptr<Operation>> backlog;
+  epoll_event events[kMaxEvents];
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) {
+        break;
+      }
+      std::move(submitted_.begin(), submitted_.end(),
+                std::back_inserter(backlog));
+      submitted_.clear();
+    }
+    dispatch(backlog);
+
+    const int ready = epoll_wait(epoll_fd_, events, kMaxEvents,
+                                 backlog.empty() ? -1 : 100);
+    for (int i = 0; i < ready; ++i) {
+      if (events[i].data.u64 == kWakeToken) {
+        std::uint64_t count;
+        [[maybe_unused]] const auto n = read(wake_fd_, &count, sizeof(count));
+        continue;
+      }
+      Connection &conn = *connections_[events[i].data.u64];
+      if (!conn.pg) {
+        continue;
+      }
+      if (conn.connecting) {
+        continueConnect(conn);
+        continue;
+      }
+      bool healthy = (events[i].events & (EPOLLERR | EPOLLHUP)) == 0;
+      if (healthy && (events[i].events & EPOLLIN)) {
+        healthy = readResults(conn) && !conn.broken;
+      }
+      if (!healthy || !flush(conn)) {
+        common::logError("pipelined", "Pipelined connection lost: ",
+                         PQerrorMessage(conn.pg));
+        disconnect(conn);
+      }
+    }
+  }
+
+  // Shutting down: nothing more will be answered.
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::move(submitted_.begin(), submitted_.end(),
+              std::back_inserter(backlog));
+    submitted_.clear();
+  }
+  for (auto &op : backlog) {
+    op->finish(nullptr);
+  }
+  for (auto &conn : connections_) {
+    for (auto &op : conn->in_flight) {
+      op->finish(nullptr);
+    }
+    conn->in_flight.clear();
+  }
+}
+
+void PipelinedUserRepository::dispatch(
+    std::deque<std::unique_ptr<Operation>> &backlog) {
+  if (backlog.empty()) {
+    return;
+  }
+  const auto now = std::chrono::steady_clock::now();
+  bool any_live = false;
+  for (auto &conn : connections_) {
+    if (conn->connecting && now >= conn->connect_deadline) {
+      common::logError("pipelined", "Pipelined connection timed out.");
+      disconnect(*conn);
+    }
+    if (!conn->pg && now >= conn->next_retry && !startConnect(*conn)) {
+      conn->next_retry = now + options_.reconnect_interval;
+    }
+    // A connect in progress keeps the backlog waiting for it.
+    any_live = any_live || conn->pg != nullptr;
+  }
+  if (!any_live) {
+    for (auto &op : backlog) {
+      common::logError("pipelined", op->context, ": no database connection");
+      op->finish(nullptr);
+    }
+    backlog.clear();
+    return;
+  }
+
+  // Least-loaded connection first; stop when every pipeline is full.
+  while (!backlog.empty()) {
+    Connection *target = nullptr;
+    for (auto &conn : connections_) {
+      if (conn->pg && !conn->connecting &&
+          conn->in_flight.size() < options_.max_in_flight &&
+          (!target || conn->in_flight.size() < target->in_flight.size())) {
+        target = conn.get();
+      }
+    }
+    if (!target) {
+      break;
+    }
+    if (!send(*target, backlog.front())) {
+      backlog.front()->finish(nullptr);
+    }
+    backlog.pop_front();
+  }
+  for (auto &conn : connections_) {
+    if (conn->pg && !conn->connecting && !flush(*conn)) {
+      disconnect(*conn);
+    }
+  }
+}
+
+bool PipelinedUserRepository::send(Connection &conn,
+                                   std::unique_ptr<Operation> &op) {
+  // Sized by the operation: no statement's parameter count is assumed.
+  std::vector<const char *> values;
+  values.reserve(op->params.size());
+  for (const auto &param : op->params) {
+    values.push_back(param.c_str());
+  }
+  const int count = static_cast<int>(values.size());
+  const int sent =
+      op->prepare
+          ? PQsendPrepare(conn.pg, op->statement->name.c_str(),
+                          op->statement->sql.c_str(), 0, nullptr)
+          : PQsendQueryPrepared(conn.pg, op->statement->name.c_str(), count,
+                                values.data(), nullptr, nullptr, 0);
+  if (!sent || !PQpipelineSync(conn.pg)) {
+    common::logError("pipelined", op->context, ": ", PQerrorMessage(conn.pg));
+    return false;
+  }
+  conn.in_flight.push_back(std::move(op));
+  return true;
+}
+
+bool PipelinedUserRepository::readResults(Connection &conn) {
+  if (!PQconsumeInput(conn.pg)) {
+    return false;
+  }
+  // Each query yields its result, a null separator, then its sync marker.
+  bool idle = false;
+  while (!conn.in_flight.empty() && !PQisBusy(conn.pg)) {
+    PGresult *res = PQgetResult(conn.pg);
+    if (!res) {
+      if (idle) {
+        break; // Two nulls in a row: nothing more is buffered.
+      }
+      idle = true;
+      continue;
+    }
+    idle = false;
+    Operation &op = *conn.in_flight.front();
+    const ExecStatusType status = PQresultStatus(res);
+    if (status == PGRES_PIPELINE_SYNC) {
+      op.finish(nullptr); // No-op unless the result went missing.
+      conn.in_flight.pop_front();
+    } else if (status == PGRES_TUPLES_OK || status == PGRES_COMMAND_OK) {
+      op.finish(res);
+    } else {
+      common::logError("pipelined", op.context, ": ",
+                       PQresultErrorMessage(res));
+      op.finish(nullptr);
+    }
+    PQclear(res);
+  }
+  return true;
+}
+
+bool PipelinedUserRepository::flush(Connection &conn) {
+  const int pending = PQflush(conn.pg);
+  if (pending < 0) {
+    return false;
+  }
+  // Only ask for EPOLLOUT while libpq still holds unsent data.
+  const bool want_write = pending == 1;
+  if (want_write == conn.want_write) {
+    return true;
+  }
+  conn.want_write = want_write;
+  watch(conn, EPOLLIN | (want_write ? EPOLLOUT : 0u));
+  return true;
+}
+
+void PipelinedUserRepository::disconnect(Connection &conn) {
+  for (auto &op : conn.in_flight) {
+    op->finish(nullptr);
+  }
+  conn.in_flight.clear();
+  if (conn.pg) {
+    if (conn.socket >= 0) {
+      epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.socket, nullptr);
+    }
+    PQfinish(conn.pg);
+    conn.pg = nullptr;
+  }
+  conn.socket = -1;
+  conn.watched = 0;
+  conn.want_write = false;
+  conn.connecting = false;
+}
+
+bool PipelinedUserRepository::startConnect(Connection &conn) {
+  disconnect(conn);
+  conn.pg = PQconnectStart(connection_string_.c_str());
+  if (!conn.pg || PQstatus(conn.pg) == CONNECTION_BAD) {
+    common::logError("pipelined", "Pipelined connection failed: ",
+                     conn.pg ? PQerrorMessage(conn.pg) : "out of memory");
+    disconnect(conn);
+    return false;
+  }
+  conn.connecting = true;
+  conn.connect_deadline =
+      std::chrono::steady_clock::now() + options_.connect_timeout;
+  // As if PQconnectPoll had answered PGRES_POLLING_WRITING.
+  watch(conn, EPOLLOUT);
+  return true;
+}
+
+void PipelinedUserRepository::continueConnect(Connection &conn) {
+  switch (PQconnectPoll(conn.pg)) {
+  case PGRES_POLLING_READING:
+    watch(conn, EPOLLIN);
+    return;
+  case PGRES_POLLING_WRITING:
+    watch(conn, EPOLLOUT);
+    return;
+  case PGRES_POLLING_OK:
+    if (startSession(conn)) {
+      return;
+    }
+    break;
+  default:
+    common::logError("pipelined", "Pipelined connection failed: ",
+                     PQerrorMessage(conn.pg));
+    break;
+  }
+  disconnect(conn);
+  conn.next_retry =
+      std::chrono::steady_clock::now() + options_.reconnect_interval;
+}
+
+bool PipelinedUserRepository::startSession(Connection &conn) {
+  conn.connecting = false;
+  conn.broken = false;
+  if (PQsetnonblocking(conn.pg, 1) != 0 || PQenterPipelineMode(conn.pg) != 1) {
+    common::logError("pipelined", "Cannot enter pipeline mode: ",
+                     PQerrorMessage(conn.pg));
+    return false;
+  }
+  watch(conn, EPOLLIN);
+  // The prepares go first down the pipeline, so queries sent behind them
+  // find their statements; if one fails, the connection is reopened.
+  for (const PreparedStatement *statement : kStatements) {
+    auto op = std::make_unique<Operation>();
+    op->statement = statement;
+    op->prepare = true;
+    op->context = "Error preparing statements";
+    op->complete = [&conn](const PGresult *res) {
+      if (!res) {
+        conn.broken = true;
+      }
+    };
+    if (!send(conn, op)) {
+      return false;
+    }
+  }
+  return flush(conn);
+}
+
+void PipelinedUserRepository::watch(Connection &conn, std::uint32_t events) {
+  // libpq may move to a new socket while connecting (another host, or a
+  // retry without SSL).
+  const int socket = PQsocket(conn.pg);
+  if (socket != conn.socket && conn.socket >= 0) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.socket, nullptr);
+    conn.watched = 0;
+  }
+  conn.socket = socket;
+  if (socket < 0 || (events == conn.watched && conn.watched != 0)) {
+    return;
+  }
+  epoll_event event{};
+  event.events = events;
+  event.data.u64 = conn.index;
+  // A socket closed and reopened under the same number left the set.
+  if (conn.watched == 0 ||
+      (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket, &event) != 0 &&
+       errno == ENOENT)) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket, &event);
+  }
+  conn.watched = events;
+}
+
+} // namespace cppcrudbp::infrastructure
@@ -1,99 +1,434 @@
 #include "application/user_dto.h"
 #include "domain/user.h"
+#include "common/logger.h"
 #include "infrastructure/postgre_user_repository.h"
-#include <iostream>
+#include "infrastructure/postgre_support.h"
+#include "infrastructure/row_mapping.h"
+#include "infrastructure/user_statements.h"
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
-#include "common/db_connection.h"
+#include "common/connection_pool.h"
 
 namespace cppcrudbp::infrastructure {
+
+namespace {
+
+using postgre_support::execPrepared;
+using postgre_support::importStaged;
+using postgre_support::inTransaction;
+using postgre_support::Lease;
+using postgre_support::PostgreUnitOfWork;
+using postgre_support::rowToUser;
+using postgre_support::rowToView;
+
+// The least string greater than every string starting with @p prefix: its
+// last code point incremented, after dropping trailing U+10FFFF. Byte order
+// is code point order in UTF-8, so the result stays valid UTF-8. nullopt
+// if there is no such string, e.g. for "".
+std::optional<std::string> prefixSuccessor(std::string prefix) {
+  while (!prefix.empty()) {
+    std::size_t start = prefix.size() - 1;
+    while (start > 0 && (static_cast<unsigned char>(prefix[start]) & 0xC0) ==
+                            0x80) {
+      --start;
+    }
+    const auto lead = static_cast<unsigned char>(prefix[start]);
+    const std::size_t length = prefix.size() - start;
+    char32_t code = length == 1 ? lead : lead & (0x7F >> length);
+    for (std::size_t i = start + 1; i < prefix.size(); ++i) {
+      code = (code << 6) | (static_cast<unsigned char>(prefix[i]) & 0x3F);
+    }
+    prefix.resize(start);
+    if (code >= 0x10FFFF) {
+      continue;
+    }
+    code = code == 0xD7FF ? 0xE000 : code + 1; // Skip the surrogates.
+    if (code < 0x80) {
+      prefix += static_cast<char>(code);
+    } else if (code < 0x800) {
+      prefix += static_cast<char>(0xC0 | (code >> 6));
+      prefix += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+      prefix += static_cast<char>(0xE0 | (code >> 12));
+      prefix += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      prefix += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+      prefix += static_cast<char>(0xF0 | (code >> 18));
+      prefix += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+      prefix += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      prefix += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    return prefix;
+  }
+  return std::nullopt;
+}
+
+// Copies every row of @p res into one batch, sized exactly up front.
+application::UserBatch rowsToBatch(const pqxx::result &res) {
+  std::size_t text_bytes = 0;
+  for (const auto &row : res) {
+    const application::UserView user = rowToView(row);
+    text_bytes += user.name.size() + user.email.size();
+  }
+  application::UserBatch users;
+  users.reserve(res.size(), text_bytes);
+  for (const auto &row : res) {
+    users.push_back(rowToView(row));
+  }
+  return users;
+}
+
+// Opens a COPY stream yielding one TextRow<T> per row of @p query.
+template <typename T, std::size_t... I>
+auto streamTextRows(pqxx::transaction_base &txn, std::string_view query,
+                    std::index_sequence<I...>) {
+  return txn.stream<std::tuple_element_t<I, TextRow<T>>...>(query);
+}
+
+template <typename T>
+auto streamTextRows(pqxx::transaction_base &txn, std::string_view query) {
+  return streamTextRows<T>(
+      txn, query,
+      std::make_index_sequence<std::tuple_size_v<TextRow<T>>>{});
+}
+
+} // namespace
+
 PostgreUserRepository::PostgreUserRepository(
-    const std::shared_ptr<cppcrudbp::common::DBConnection> &conn)
-    : db_connection_(conn) {}
+    std::shared_ptr<cppcrudbp::common::ConnectionPool> pool)
+    : pool_(std::move(pool)) {
+  if (!pool_) {
+    throw std::invalid_argument("ConnectionPool cannot be null.");
+  }
+}
 
-bool PostgreUserRepository::createUser(
-    const application::CreateUserRequest &user) {
+std::optional<application::UserResponse>
+PostgreUserRepository::createUser(const application::CreateUserRequest &user) {
   try {
-    const auto conn = db_connection_->getConnection();
-    pqxx::work txn(*conn);
-    txn.exec_params("INSERT INTO users (name, email) VALUES ($1, $2)",
-                    user.name, user.email);
-    txn.commit();
-    return true;
+    return inTransaction<pqxx::nontransaction>(
+        *pool_, this,
+        [&](Lease &conn, pqxx::transaction_base &txn)
+            -> std::optional<application::UserResponse> {
+          pqxx::result res = execPrepared(conn, txn, user_statements::kCreate,
+                                          user.name, user.email);
+          return rowToUser(res[0]);
+        });
   } catch (const std::exception &e) {
-    std::cerr << "Error creating user: " << e.what() << '\n';
-    return false;
+    common::logError("postgres", "Error creating user: ", e.what());
+    return std::nullopt;
   }
 }
 
+application::BulkCreateResult PostgreUserRepository::bulkCreateUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  application::BulkCreateResult result;
+  if (users.empty()) {
+    return result;
+  }
+  try {
+    // COPY and the INSERT that moves the rows must share a transaction.
+    pqxx::result res = inTransaction<pqxx::work>(
+        *pool_, this, [&](Lease &, pqxx::transaction_base &txn) {
+          return importStaged(txn, users, user_statements::kInsertFromImport);
+        });
+
+    std::unordered_multiset<std::string_view> inserted;
+    inserted.reserve(res.size());
+    for (const auto &row : res) {
+      inserted.insert(row[0].view());
+    }
+    result.inserted = res.size();
+    for (const auto &user : users) {
+      const auto it = inserted.find(user.email);
+      if (it != inserted.end()) {
+        inserted.erase(it);
+      } else {
+        result.rejected_emails.push_back(user.email);
+      }
+    }
+  } catch (const std::exception &e) {
+    common::logError("postgres", "Error importing users: ", e.what());
+    result = application::BulkCreateResult{};
+    result.failed = users.size();
+  }
+  return result;
+}
+
+application::BulkUpsertResult PostgreUserRepository::upsertUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  application::BulkUpsertResult result;
+  if (users.empty()) {
+    return result;
+  }
+  try {
+    pqxx::result res = inTransaction<pqxx::work>(
+        *pool_, this, [&](Lease &, pqxx::transaction_base &txn) {
+          return importStaged(txn, users, user_statements::kUpsertFromImport);
+        });
+    for (const auto &row : res) {
+      ++(row[0].as<bool>() ? result.inserted : result.updated);
+    }
+    // Rows neither inserted nor updated were repeats or already current.
+    std::unordered_set<std::string_view> emails;
+    emails.reserve(users.size());
+    for (const auto &user : users) {
+      emails.insert(user.email);
+    }
+    result.unchanged = emails.size() - res.size();
+  } catch (const std::exception &e) {
+    common::logError("postgres", "Error upserting users: ", e.what());
+    result = application::BulkUpsertResult{};
+    result.failed = users.size();
+  }
+  return result;
+}
+
+std::optional<application::UserResponse>
+PostgreUserRepository::findUserById(int id) {
+  return inTransaction<pqxx::nontransaction>(
+      *pool_, this,
+      [&](Lease &conn, pqxx::transaction_base &txn)
+          -> std::optional<application::UserResponse> {
+        pqxx::result res =
+            execPrepared(conn, txn, user_statements::kGetById, id);
+        if (res.empty())
+          return std::nullopt;
+        return rowToUser(res[0]);
+      });
+}
+
 std::optional<application::UserResponse>
 PostgreUserRepository::getUserById(int id) {
   try {
-    const auto conn = db_connection_->getConnection();
-    pqxx::work txn(*conn);
-    pqxx::result res =
-        txn.exec_params("SELECT id, name, email FROM users WHERE id = $1", id);
-
-    if (res.empty())
-      return std::nullopt;
-
-    const auto &row = res[0];
-    application::UserResponse user;
-    user.id = row["id"].as<int>();
-    user.name = row["name"].as<std::string>();
-    user.email = row["email"].as<std::string>();
-    return user;
+    return findUserById(id);
   } catch (const std::exception &e) {
-    std::cerr << "Error fetching user: " << e.what() << '\n';
+    common::logError("postgres", "Error fetching user: ", e.what());
     return std::nullopt;
   }
 }
 
-std::vector<application::UserResponse> PostgreUserRepository::getAllUsers() {
-  std::vector<application::UserResponse> users;
+std::optional<application::UserResponse>
+PostgreUserRepository::getUserByEmail(const std::string &email) {
   try {
-    const auto conn = db_connection_->getConnection();
-    pqxx::work txn(*conn);
-    pqxx::result res = txn.exec("SELECT id, name, email FROM users");
+    return inTransaction<pqxx::nontransaction>(
+        *pool_, this,
+        [&](Lease &conn, pqxx::transaction_base &txn)
+            -> std::optional<application::UserResponse> {
+          pqxx::result res =
+              execPrepared(conn, txn, user_statements::kGetByEmail, email);
+          if (res.empty())
+            return std::nullopt;
+          return rowToUser(res[0]);
+        });
+  } catch (const std::exception &e) {
+    common::logError("postgres", "Error fetching user by email: ", e.what());
+    return std::nullopt;
+  }
+}
 
-    for (const auto &row : res) {
-      application::UserResponse user;
-      user.id = row["id"].as<int>();
-      user.name = row["name"].as<std::string>();
-      user.email = row["email"].as<std::string>();
-      users.push_back(user);
-    }
+application::UserBatch
+PostgreUserRepository::findUsersByIds(const std::vector<int> &ids) {
+  if (ids.empty()) {
+    return {};
+  }
+  return inTransaction<pqxx::nontransaction>(
+      *pool_, this, [&](Lease &conn, pqxx::transaction_base &txn) {
+        return rowsToBatch(execPrepared(conn, txn, user_statements::kGetByIds,
+                                        toIntArray(ids)));
+      });
+}
+
+application::UserBatch
+PostgreUserRepository::getUsersByIds(const std::vector<int> &ids) {
+  try {
+    return findUsersByIds(ids);
   } catch (const std::exception &e) {
-    std::cerr << "Error retrieving users: " << e.what() << '\n';
+    common::logError("postgres", "Error fetching users by id: ", e.what());
+    return {};
   }
-  return users;
 }
 
-bool PostgreUserRepository::updateUser(const domain::User &user) {
+application::UserBatch PostgreUserRepository::getAllUsers() {
   try {
-    const auto conn = db_connection_->getConnection();
-    pqxx::work txn(*conn);
-    txn.exec_params("UPDATE users SET name = $1, email = $2 WHERE id = $3",
-                    user.name, user.email, user.id);
-    txn.commit();
-    return true;
+    return inTransaction<pqxx::nontransaction>(
+        *pool_, this, [&](Lease &conn, pqxx::transaction_base &txn) {
+          return rowsToBatch(execPrepared(conn, txn, user_statements::kGetAll));
+        });
   } catch (const std::exception &e) {
-    std::cerr << "Error updating user: " << e.what() << '\n';
+    common::logError("postgres", "Error retrieving users: ", e.what());
+    return {};
+  }
+}
+
+application::UserBatch
+PostgreUserRepository::getUsersPage(int after_id, std::size_t limit) {
+  try {
+    return inTransaction<pqxx::nontransaction>(
+        *pool_, this, [&](Lease &conn, pqxx::transaction_base &txn) {
+          return rowsToBatch(execPrepared(conn, txn, user_statements::kGetPage,
+                                          after_id,
+                                          static_cast<long long>(limit)));
+        });
+  } catch (const std::exception &e) {
+    common::logError("postgres", "Error retrieving users page: ", e.what());
+    return {};
+  }
+}
+
+application::UserBatch PostgreUserRepository::searchUsersByNamePrefix(
+    const std::string &prefix, const application::NameCursor &after,
+    std::size_t limit) {
+  // Start at the later of the cursor and the first name with the prefix.
+  const bool before_prefix = after.name < prefix;
+  const std::string &from_name = before_prefix ? prefix : after.name;
+  const int from_id = before_prefix ? 0 : after.id;
+  const auto past_prefix = prefixSuccessor(prefix);
+  try {
+    return inTransaction<pqxx::nontransaction>(
+        *pool_, this, [&](Lease &conn, pqxx::transaction_base &txn) {
+          const auto rows = static_cast<long long>(limit);
+          return rowsToBatch(
+              past_prefix
+                  ? execPrepared(conn, txn,
+                                 user_statements::kSearchByNamePrefix,
+                                 from_name, from_id, *past_prefix, rows)
+                  : execPrepared(conn, txn, user_statements::kSearchFromName,
+                                 from_name, from_id, rows));
+        });
+  } catch (const std::exception &e) {
+    common::logError("postgres", "Error searching users by name: ", e.what());
+    return {};
+  }
+}
+
+bool PostgreUserRepository::forEachUser(const domain::UserVisitor &visitor) {
+  try {
+    return inTransaction<pqxx::nontransaction>(
+        *pool_, this, [&](Lease &conn, pqxx::transaction_base &txn) {
+          try {
+            application::UserResponse user;
+            for (const auto &row : streamTextRows<application::UserResponse>(
+                     txn, user_statements::kStreamAll)) {
+              mapTextRowInto(user, row); // Reuses the strings' capacity.
+              visitor(user);
+            }
+          } catch (...) {
+            // An interrupted COPY leaves the session unusable; don't
+            // recycle it.
+            conn.invalidate();
+            throw;
+          }
+          return true;
+        });
+  } catch (const std::exception &e) {
+    common::logError("postgres", "Error streaming users: ", e.what());
     return false;
   }
 }
 
+std::optional<application::UserResponse>
+PostgreUserRepository::updateUser(const domain::User &user) {
+  try {
+    return inTransaction<pqxx::nontransaction>(
+        *pool_, this,
+        [&](Lease &conn, pqxx::transaction_base &txn)
+            -> std::optional<application::UserResponse> {
+          pqxx::result res = execPrepared(conn, txn, user_statements::kUpdate,
+                                          user.name, user.email, user.id);
+          if (res.empty())
+            return std::nullopt;
+          return rowToUser(res[0]);
+        });
+  } catch (const std::exception &e) {
+    common::logError("postgres", "Error updating user: ", e.what());
+    return std::nullopt;
+  }
+}
+
+std::vector<int>
+PostgreUserRepository::updateUsers(const std::vector<domain::User> &users) {
+  if (users.empty()) {
+    return {};
+  }
+  try {
+    std::string ids, names, emails;
+    std::tie(ids, names, emails) = toUpdateArrays(lastUpdatePerId(users));
+    std::vector<int> updated = inTransaction<pqxx::nontransaction>(
+        *pool_, this, [&](Lease &conn, pqxx::transaction_base &txn) {
+          pqxx::result res = execPrepared(
+              conn, txn, user_statements::kUpdateMany, ids, names, emails);
+          std::vector<int> updated;
+          updated.reserve(res.size());
+          for (const auto &row : res) {
+            updated.push_back(row[0].as<int>());
+          }
+          return updated;
+        });
+    std::sort(updated.begin(), updated.end());
+    return updated;
+  } catch (const std::exception &e) {
+    common::logError("postgres", "Error updating users: ", e.what());
+    return {};
+  }
+}
+
 bool PostgreUserRepository::deleteUser(int id) {
   try {
-    const auto conn = db_connection_->getConnection();
-    pqxx::work txn(*conn);
-    txn.exec_params("DELETE FROM users WHERE id = $1", id);
-    txn.commit();
-    return true;
+    return inTransaction<pqxx::nontransaction>(
+        *pool_, this, [&](Lease &conn, pqxx::transaction_base &txn) {
+          return execPrepared(conn, txn, user_statements::kDelete, id)
+                     .affected_rows() > 0;
+        });
   } catch (const std::exception &e) {
-    std::cerr << "Error deleting user: " << e.what() << '\n';
+    common::logError("postgres", "Error deleting user: ", e.what());
     return false;
   }
 }
 
+std::vector<int>
+PostgreUserRepository::deleteUsers(const std::vector<int> &ids) {
+  if (ids.empty()) {
+    return {};
+  }
+  try {
+    std::vector<int> deleted = inTransaction<pqxx::nontransaction>(
+        *pool_, this, [&](Lease &conn, pqxx::transaction_base &txn) {
+          pqxx::result res = execPrepared(
+              conn, txn, user_statements::kDeleteByIds, toIntArray(ids));
+          std::vector<int> deleted;
+          deleted.reserve(res.size());
+          for (const auto &row : res) {
+            deleted.push_back(row[0].as<int>());
+          }
+          return deleted;
+        });
+    std::sort(deleted.begin(), deleted.end());
+    return deleted;
+  } catch (const std::exception &e) {
+    common::logError("postgres", "Error deleting users: ", e.what());
+    return {};
+  }
+}
+
+std::unique_ptr<domain::IUnitOfWork> PostgreUserRepository::beginUnitOfWork() {
+  if (PostgreUnitOfWork::find(this)) {
+    common::logError("postgres",
+                     "Error starting unit of work: one is already open.");
+    return nullptr;
+  }
+  try {
+    return std::make_unique<PostgreUnitOfWork>(this, pool_->acquire());
+  } catch (const std::exception &e) {
+    common::logError("postgres", "Error starting unit of work: ", e.what());
+    return nullptr;
+  }
+}
+
 } // namespace cppcrudbp::infrastructure
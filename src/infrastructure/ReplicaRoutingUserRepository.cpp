@@ -0,0 +1,459 @@
+#include "infrastructure/replica_routing_user_repository.h"
+#include "common/logger.h"
+#include "infrastructure/active_unit_of_work.h"
+#include "infrastructure/postgre_user_repository.h"
+#include "infrastructure/user_statements.h"
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace cppcrudbp::infrastructure {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// When this thread last wrote through each repository; a thread writes
+// through one or two, so a linear scan is the fastest lookup.
+struct SessionWrite {
+  const void *owner;
+  Clock::time_point at;
+};
+
+std::vector<SessionWrite> &sessionWrites() {
+  thread_local std::vector<SessionWrite> writes;
+  return writes;
+}
+
+Clock::time_point lastWrite(const void *owner) {
+  for (const auto &write : sessionWrites()) {
+    if (write.owner == owner) {
+      return write.at;
+    }
+  }
+  return Clock::time_point{};
+}
+
+std::string replicaName(std::size_t index) {
+  return "Read replica " + std::to_string(index);
+}
+
+// A connection of the monitor's own, so a busy pool cannot delay its
+// readings, that gives up on a connect or a query after about @p timeout.
+pqxx::connection openProbe(const std::string &connection_string,
+                           std::chrono::milliseconds timeout) {
+  // libpq counts connect_timeout in whole seconds and treats 1 as 2.
+  const auto seconds =
+      std::to_string(std::max<long long>(2, (timeout.count() + 999) / 1000));
+  std::string options = connection_string;
+  if (options.rfind("postgresql://", 0) == 0 ||
+      options.rfind("postgres://", 0) == 0) {
+    options += options.find('?') == std::string::npos ? '?' : '&';
+    options += "connect_timeout=" + seconds;
+  } else {
+    options += " connect_timeout=" + seconds;
+  }
+  pqxx::connection conn(options);
+  {
+    pqxx::nontransaction txn(conn);
+    txn.exec("SET statement_timeout = " + std::to_string(timeout.count()));
+  }
+  return conn;
+}
+
+} // namespace
+
+struct ReplicaRoutingUserRepository::Replica {
+  std::shared_ptr<common::ConnectionPool> pool;
+  std::unique_ptr<PostgreUserRepository> reader;
+  // Time of the newest primary sample this replica has replayed past, in
+  // Clock ticks: it holds every commit made before then. 0 until seen.
+  std::atomic<Clock::rep> current_as_of{0};
+  std::atomic<std::size_t> outstanding{0};
+  std::atomic<std::uint64_t> reads{0};
+  std::thread monitor;
+};
+
+// Keeps a read counted as outstanding on its replica while it runs.
+class ReplicaRoutingUserRepository::ReadLease {
+public:
+  ReadLease(domain::IUserRepository &target, Replica *replica)
+      : target_(&target), replica_(replica) {}
+  ~ReadLease() {
+    if (replica_) {
+      replica_->outstanding.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+  ReadLease(const ReadLease &) = delete;
+  ReadLease &operator=(const ReadLease &) = delete;
+
+  domain::IUserRepository *operator->() const { return target_; }
+
+private:
+  domain::IUserRepository *target_;
+  Replica *replica_;
+};
+
+// Keeps the opening thread's reads on the primary, where its uncommitted
+// writes are, and records its writes once it commits.
+class RoutingUnitOfWork final : public domain::IUnitOfWork,
+                                public ActiveUnitOfWork<RoutingUnitOfWork> {
+public:
+  RoutingUnitOfWork(ReplicaRoutingUserRepository *owner,
+                    std::unique_ptr<domain::IUnitOfWork> inner)
+      : ActiveUnitOfWork(owner), owner_(owner), inner_(std::move(inner)) {}
+  ~RoutingUnitOfWork() override { rollback(); }
+
+  bool commit() override {
+    if (!inner_) {
+      return false;
+    }
+    const bool committed = inner_->commit();
+    finish();
+    // Even a failed commit may have reached the database.
+    owner_->noteWrite();
+    return committed;
+  }
+
+  void rollback() override {
+    if (!inner_) {
+      return;
+    }
+    inner_->rollback();
+    finish();
+  }
+
+private:
+  void finish() {
+    deactivate();
+    inner_.reset();
+  }
+
+  ReplicaRoutingUserRepository *owner_;
+  std::unique_ptr<domain::IUnitOfWork> inner_;
+};
+
+ReplicaRoutingUserRepository::ReplicaRoutingUserRepository(
+    std::shared_ptr<cppcrudbp::common::ConnectionPool> primary,
+    std::vector<std::shared_ptr<cppcrudbp::common::ConnectionPool>> replicas,
+    ReadRoutingOptions options)
+    : primary_pool_(std::move(primary)), options_(options) {
+  if (!primary_pool_) {
+    throw std::invalid_argument("ConnectionPool cannot be null.");
+  }
+  if (replicas.empty()) {
+    throw std::invalid_argument("At least one read replica is required.");
+  }
+  if (options_.poll_interval.count() <= 0 ||
+      options_.max_lag <= options_.poll_interval) {
+    throw std::invalid_argument(
+        "Replica lag threshold must exceed a positive poll interval.");
+  }
+  primary_ = std::make_unique<PostgreUserRepository>(primary_pool_);
+  replicas_.reserve(replicas.size());
+  for (auto &pool : replicas) {
+    if (!pool) {
+      throw std::invalid_argument("ConnectionPool cannot be null.");
+    }
+    auto replica = std::make_unique<Replica>();
+    replica->reader = std::make_unique<PostgreUserRepository>(pool);
+    replica->pool = std::move(pool);
+    replicas_.push_back(std::move(replica));
+  }
+  monitor_ = std::thread([this] { samplePrimary(); });
+  for (std::size_t i = 0; i < replicas_.size(); ++i) {
+    replicas_[i]->monitor = std::thread([this, i] { monitorReplica(i); });
+  }
+}
+
+ReplicaRoutingUserRepository::~ReplicaRoutingUserRepository() {
+  {
+    const std::lock_guard<std::mutex> lock(state_mutex_);
+    stopping_ = true;
+  }
+  state_changed_.notify_all();
+  monitor_.join();
+  for (auto &replica : replicas_) {
+    replica->monitor.join();
+  }
+}
+
+// --- Routing ---
+
+ReplicaRoutingUserRepository::ReadLease ReplicaRoutingUserRepository::route() {
+  if (!RoutingUnitOfWork::find(this)) {
+    // A replica qualifies if it holds this thread's last write and is
+    // within max_lag of the primary.
+    const Clock::time_point needed =
+        std::max(Clock::now() - options_.max_lag, lastWrite(this));
+    Replica *best = nullptr;
+    // Ties go round the replicas rather than always to the first.
+    const std::size_t start =
+        next_replica_.fetch_add(1, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < replicas_.size(); ++i) {
+      Replica &replica = *replicas_[(start + i) % replicas_.size()];
+      const Clock::time_point as_of{Clock::duration{
+          replica.current_as_of.load(std::memory_order_relaxed)}};
+      if (as_of > needed &&
+          (!best || replica.outstanding.load(std::memory_order_relaxed) <
+                        best->outstanding.load(std::memory_order_relaxed))) {
+        best = &replica;
+      }
+    }
+    if (best) {
+      best->outstanding.fetch_add(1, std::memory_order_relaxed);
+      best->reads.fetch_add(1, std::memory_order_relaxed);
+      return ReadLease(*best->reader, best);
+    }
+    lag_fallbacks_.fetch_add(1, std::memory_order_relaxed);
+  }
+  primary_reads_.fetch_add(1, std::memory_order_relaxed);
+  return ReadLease(*primary_, nullptr);
+}
+
+void ReplicaRoutingUserRepository::noteWrite() {
+  if (RoutingUnitOfWork::find(this)) {
+    return; // Noted at commit.
+  }
+  // Taken after the write returned, so any primary sample taken later
+  // covers it.
+  const auto now = Clock::now();
+  for (auto &write : sessionWrites()) {
+    if (write.owner == this) {
+      write.at = now;
+      return;
+    }
+  }
+  sessionWrites().push_back(SessionWrite{this, now});
+}
+
+// --- Lag monitor ---
+
+bool ReplicaRoutingUserRepository::waitPoll() {
+  std::unique_lock<std::mutex> lock(state_mutex_);
+  return !state_changed_.wait_for(lock, options_.poll_interval,
+                                  [this] { return stopping_; });
+}
+
+void ReplicaRoutingUserRepository::samplePrimary() {
+  std::optional<pqxx::connection> conn;
+  bool reachable = true;
+  do {
+    try {
+      if (!conn) {
+        conn.emplace(openProbe(primary_pool_->connectionString(),
+                               options_.probe_timeout));
+      }
+      // Taken before the query, so the sample covers every commit made
+      // before this instant.
+      const auto taken = Clock::now();
+      std::int64_t position;
+      {
+        pqxx::nontransaction txn(*conn);
+        const pqxx::result res = txn.exec(user_statements::kPrimaryWalPosition);
+        position = res[0][0].as<std::int64_t>();
+      }
+      {
+        const std::lock_guard<std::mutex> lock(samples_mutex_);
+        samples_.emplace_back(taken, position);
+        // A replica behind every sample kept is past max_lag anyway.
+        while (samples_.size() > 1 &&
+               samples_[1].first < taken - options_.max_lag) {
+          samples_.pop_front();
+        }
+      }
+      if (!reachable) {
+        common::Logger::global().log(common::LogLevel::kInfo,
+                                     "replica-routing",
+                                     "Primary WAL position readable again");
+        reachable = true;
+      }
+    } catch (const std::exception &e) {
+      conn.reset(); // Reopened on the next poll.
+      // Replicas age out of routing while the primary cannot be sampled.
+      if (reachable) {
+        common::logError("replica-routing",
+                         "Reading the primary WAL position failed: ",
+                         e.what());
+        reachable = false;
+      }
+    }
+  } while (waitPoll());
+}
+
+void ReplicaRoutingUserRepository::monitorReplica(std::size_t index) {
+  Replica &replica = *replicas_[index];
+  std::optional<pqxx::connection> conn;
+  bool reachable = true;
+  do {
+    std::optional<Clock::time_point> as_of;
+    try {
+      if (!conn) {
+        conn.emplace(openProbe(replica.pool->connectionString(),
+                               options_.probe_timeout));
+      }
+      const auto asked = Clock::now();
+      std::optional<std::int64_t> replayed;
+      {
+        pqxx::nontransaction txn(*conn);
+        const pqxx::result res =
+            txn.exec(user_statements::kReplicaReplayPosition);
+        if (!res[0][0].is_null()) {
+          replayed = res[0][0].as<std::int64_t>();
+        }
+      }
+      // Not a standby: it has every commit made before the query.
+      as_of = replayed ? sampleAt(*replayed) : asked;
+      if (!reachable) {
+        common::Logger::global().log(common::LogLevel::kInfo,
+                                     "replica-routing", replicaName(index),
+                                     " reachable again");
+        reachable = true;
+      }
+    } catch (const std::exception &e) {
+      conn.reset();
+      if (reachable) {
+        common::logWarning("replica-routing", replicaName(index),
+                           " unreachable, reading elsewhere: ", e.what());
+        reachable = false;
+      }
+    }
+    if (as_of && as_of->time_since_epoch().count() >
+                     replica.current_as_of.load(std::memory_order_relaxed)) {
+      replica.current_as_of.store(as_of->time_since_epoch().count(),
+                                  std::memory_order_relaxed);
+    }
+  } while (waitPoll());
+}
+
+std::optional<ReplicaRoutingUserRepository::Clock::time_point>
+ReplicaRoutingUserRepository::sampleAt(std::int64_t position) {
+  const std::lock_guard<std::mutex> lock(samples_mutex_);
+  for (auto it = samples_.rbegin(); it != samples_.rend(); ++it) {
+    if (it->second <= position) {
+      return it->first;
+    }
+  }
+  return std::nullopt;
+}
+
+ReadRoutingStats ReplicaRoutingUserRepository::stats() const {
+  ReadRoutingStats stats;
+  stats.primary_reads = primary_reads_.load(std::memory_order_relaxed);
+  stats.lag_fallbacks = lag_fallbacks_.load(std::memory_order_relaxed);
+  const auto now = Clock::now();
+  stats.replicas.reserve(replicas_.size());
+  for (const auto &replica : replicas_) {
+    ReadReplicaStats entry;
+    const auto as_of = replica->current_as_of.load(std::memory_order_relaxed);
+    if (as_of != 0) {
+      entry.lag = std::chrono::duration_cast<std::chrono::milliseconds>(
+          now - Clock::time_point{Clock::duration{as_of}});
+    }
+    entry.reads = replica->reads.load(std::memory_order_relaxed);
+    entry.outstanding = replica->outstanding.load(std::memory_order_relaxed);
+    stats.replicas.push_back(entry);
+  }
+  return stats;
+}
+
+// --- IUserRepository ---
+
+std::optional<application::UserResponse>
+ReplicaRoutingUserRepository::createUser(
+    const application::CreateUserRequest &user) {
+  auto created = primary_->createUser(user);
+  noteWrite();
+  return created;
+}
+
+application::BulkCreateResult ReplicaRoutingUserRepository::bulkCreateUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  auto result = primary_->bulkCreateUsers(users);
+  noteWrite();
+  return result;
+}
+
+application::BulkUpsertResult ReplicaRoutingUserRepository::upsertUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  auto result = primary_->upsertUsers(users);
+  noteWrite();
+  return result;
+}
+
+std::optional<application::UserResponse>
+ReplicaRoutingUserRepository::getUserById(int id) {
+  return route()->getUserById(id);
+}
+
+std::optional<application::UserResponse>
+ReplicaRoutingUserRepository::getUserByEmail(const std::string &email) {
+  return route()->getUserByEmail(email);
+}
+
+application::UserBatch
+ReplicaRoutingUserRepository::getUsersByIds(const std::vector<int> &ids) {
+  return route()->getUsersByIds(ids);
+}
+
+application::UserBatch ReplicaRoutingUserRepository::getAllUsers() {
+  return route()->getAllUsers();
+}
+
+application::UserBatch
+ReplicaRoutingUserRepository::getUsersPage(int after_id, std::size_t limit) {
+  return route()->getUsersPage(after_id, limit);
+}
+
+application::UserBatch ReplicaRoutingUserRepository::searchUsersByNamePrefix(
+    const std::string &prefix, const application::NameCursor &after,
+    std::size_t limit) {
+  return route()->searchUsersByNamePrefix(prefix, after, limit);
+}
+
+bool ReplicaRoutingUserRepository::forEachUser(
+    const domain::UserVisitor &visitor) {
+  return route()->forEachUser(visitor);
+}
+
+std::optional<application::UserResponse>
+ReplicaRoutingUserRepository::updateUser(const cppcrudbp::domain::User &user) {
+  auto updated = primary_->updateUser(user);
+  noteWrite();
+  return updated;
+}
+
+std::vector<int> ReplicaRoutingUserRepository::updateUsers(
+    const std::vector<cppcrudbp::domain::User> &users) {
+  std::vector<int> updated = primary_->updateUsers(users);
+  noteWrite();
+  return updated;
+}
+
+bool ReplicaRoutingUserRepository::deleteUser(int id) {
+  const bool deleted = primary_->deleteUser(id);
+  noteWrite();
+  return deleted;
+}
+
+std::vector<int>
+ReplicaRoutingUserRepository::deleteUsers(const std::vector<int> &ids) {
+  std::vector<int> deleted = primary_->deleteUsers(ids);
+  noteWrite();
+  return deleted;
+}
+
+std::unique_ptr<domain::IUnitOfWork>
+ReplicaRoutingUserRepository::beginUnitOfWork() {
+  if (RoutingUnitOfWork::find(this)) {
+    return nullptr;
+  }
+  auto inner = primary_->beginUnitOfWork();
+  if (!inner) {
+    return nullptr;
+  }
+  return std::make_unique<RoutingUnitOfWork>(this, std::move(inner));
+}
+
+} // namespace cppcrudbp::infrastructure
@@ -0,0 +1,587 @@
+#include "infrastructure/replicated_user_repository.h"
+#include "common/logger.h"
+#include "infrastructure/active_unit_of_work.h"
+#include "infrastructure/postgre_support.h"
+#include "infrastructure/user_statements.h"
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace cppcrudbp::infrastructure {
+
+namespace {
+
+using Kind = domain::UserChange::Kind;
+using postgre_support::rowToUser;
+
+// Past this many changed ids in one round, reloading the table costs less
+// than re-reading them.
+constexpr std::size_t kReloadThreshold = 50000;
+// Records handed to a visitor per lock acquisition in forEachUser.
+constexpr std::size_t kVisitChunk = 256;
+
+// Payloads sent by the users trigger: "I:<id>", "U:<id>", "D:<id>", or "T"
+// after a TRUNCATE.
+bool parseChange(std::string_view payload, Kind &kind, int &id) {
+  if (payload == "T") {
+    kind = Kind::kTruncate;
+    id = 0;
+    return true;
+  }
+  if (payload.size() < 3 || payload[1] != ':') {
+    return false;
+  }
+  switch (payload[0]) {
+  case 'I':
+    kind = Kind::kInsert;
+    break;
+  case 'U':
+    kind = Kind::kUpdate;
+    break;
+  case 'D':
+    kind = Kind::kDelete;
+    break;
+  default:
+    return false;
+  }
+  const char *end = payload.data() + payload.size();
+  return std::from_chars(payload.data() + 2, end, id).ptr == end;
+}
+
+// Collects the payloads of one channel while the connection is polled.
+class ChangeReceiver final : public pqxx::notification_receiver {
+public:
+  ChangeReceiver(pqxx::connection &conn, const std::string &channel,
+                 std::vector<std::string> &payloads)
+      : notification_receiver(conn, channel), payloads_(payloads) {}
+
+  void operator()(const std::string &payload, int) override {
+    payloads_.push_back(payload);
+  }
+
+private:
+  std::vector<std::string> &payloads_;
+};
+
+} // namespace
+
+// Routes the opening thread's reads past the replica, which holds only
+// committed rows, and keeps its writes from being applied locally early.
+class ReplicatedUnitOfWork final
+    : public domain::IUnitOfWork,
+      public ActiveUnitOfWork<ReplicatedUnitOfWork> {
+public:
+  ReplicatedUnitOfWork(const ReplicatedUserRepository *owner,
+                       std::unique_ptr<domain::IUnitOfWork> inner)
+      : ActiveUnitOfWork(owner), inner_(std::move(inner)) {}
+  ~ReplicatedUnitOfWork() override { rollback(); }
+
+  bool commit() override {
+    if (!inner_) {
+      return false;
+    }
+    const bool committed = inner_->commit();
+    finish();
+    return committed;
+  }
+
+  void rollback() override {
+    if (!inner_) {
+      return;
+    }
+    inner_->rollback();
+    finish();
+  }
+
+private:
+  void finish() {
+    deactivate();
+    inner_.reset();
+  }
+
+  std::unique_ptr<domain::IUnitOfWork> inner_;
+};
+
+ReplicatedUserRepository::ReplicatedUserRepository(
+    std::shared_ptr<cppcrudbp::domain::IUserRepository> inner,
+    std::string connection_string, UserReplicaOptions options)
+    : inner_(std::move(inner)),
+      connection_string_(std::move(connection_string)),
+      options_(std::move(options)) {
+  if (!inner_) {
+    throw std::invalid_argument("Wrapped repository cannot be null.");
+  }
+  if (options_.heartbeat.count() <= 0) {
+    throw std::invalid_argument("Replica heartbeat must be positive.");
+  }
+  listener_ = std::thread([this] { run(); });
+}
+
+ReplicatedUserRepository::~ReplicatedUserRepository() {
+  {
+    const std::lock_guard<std::mutex> lock(state_mutex_);
+    stopping_ = true;
+  }
+  state_changed_.notify_all();
+  listener_.join();
+}
+
+bool ReplicatedUserRepository::current() const {
+  const Clock::rep synced = synced_at_.load(std::memory_order_acquire);
+  if (synced == 0) {
+    return false;
+  }
+  const Clock::time_point as_of{Clock::duration(synced)};
+  return Clock::now() - as_of <= options_.max_staleness;
+}
+
+bool ReplicatedUserRepository::servesReads() {
+  if (ReplicatedUnitOfWork::find(this) || !current()) {
+    fallback_reads_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  local_reads_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void ReplicatedUserRepository::markSynced(Clock::time_point as_of) {
+  {
+    const std::lock_guard<std::mutex> lock(state_mutex_);
+    synced_at_.store(as_of.time_since_epoch().count(),
+                     std::memory_order_release);
+  }
+  state_changed_.notify_all();
+}
+
+bool ReplicatedUserRepository::stopping() {
+  const std::lock_guard<std::mutex> lock(state_mutex_);
+  return stopping_;
+}
+
+bool ReplicatedUserRepository::waitUntilCurrent(
+    std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(state_mutex_);
+  return state_changed_.wait_for(lock, timeout,
+                                 [this] { return stopping_ || current(); }) &&
+         !stopping_;
+}
+
+// --- Listener ---
+
+void ReplicatedUserRepository::run() {
+  while (!stopping()) {
+    try {
+      listen();
+    } catch (const std::exception &e) {
+      // Reads keep being served until the replica is max_staleness old.
+      common::logError("replica", "Replica listener failed: ", e.what());
+    }
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    state_changed_.wait_for(lock, options_.reconnect_delay,
+                            [this] { return stopping_; });
+  }
+}
+
+void ReplicatedUserRepository::listen() {
+  pqxx::connection conn(connection_string_);
+  std::vector<std::string> payloads;
+  // LISTEN before loading, so no change can fall between the two; changes
+  // already in the load are merely read again.
+  ChangeReceiver receiver(conn, options_.channel, payloads);
+  {
+    // Without the trigger no change would ever arrive.
+    pqxx::nontransaction txn(conn);
+    if (txn.exec(user_statements::kFindChangeTrigger).empty()) {
+      throw std::runtime_error("users has no users_notify_change trigger; "
+                               "apply sql/migrations/"
+                               "002_users_change_notify.sql.");
+    }
+  }
+  conn.prepare(user_statements::kGetAll.name, user_statements::kGetAll.sql);
+  conn.prepare(user_statements::kGetByIds.name,
+               user_statements::kGetByIds.sql);
+
+  Clock::time_point round = Clock::now();
+  // Ids written locally during the last read, read again the next round.
+  std::vector<int> reread = reload(conn);
+  markSynced(round);
+
+  const long heartbeat_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(options_.heartbeat)
+          .count();
+  std::vector<PendingChange> changes;
+  std::vector<int> ids;
+  while (!stopping()) {
+    conn.await_notification(heartbeat_us / 1000000, heartbeat_us % 1000000);
+    // The server sends every notification committed before this round
+    // trip ahead of its reply.
+    round = Clock::now();
+    {
+      pqxx::nontransaction txn(conn);
+      txn.exec("SELECT 1");
+    }
+    conn.get_notifs();
+
+    changes.clear();
+    ids.clear();
+    bool truncated = false;
+    for (const std::string &payload : payloads) {
+      PendingChange change{};
+      if (!parseChange(payload, change.kind, change.id)) {
+        common::logWarning("replica", "Ignoring notification: ", payload);
+        continue;
+      }
+      truncated = truncated || change.kind == Kind::kTruncate;
+      changes.push_back(change);
+      ids.push_back(change.id);
+    }
+    payloads.clear();
+
+    ids.insert(ids.end(), reread.begin(), reread.end());
+    reread.clear();
+    if (!ids.empty()) {
+      std::sort(ids.begin(), ids.end());
+      ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+      if (truncated || ids.size() > kReloadThreshold) {
+        reread = reload(conn);
+      } else {
+        reread = refresh(conn, ids);
+      }
+      changes_.fetch_add(changes.size(), std::memory_order_relaxed);
+    }
+    markSynced(round);
+    publish(changes);
+  }
+}
+
+std::vector<int> ReplicatedUserRepository::reload(pqxx::connection &conn) {
+  std::uint64_t read_seq;
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    read_seq = write_seq_;
+  }
+  std::map<int, application::UserResponse> users;
+  {
+    pqxx::nontransaction txn(conn);
+    for (const auto &row : txn.exec_prepared(user_statements::kGetAll.name)) {
+      application::UserResponse user = rowToUser(row);
+      const int id = user.id;
+      users.emplace(id, std::move(user));
+    }
+  }
+  std::vector<int> reread;
+  {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    // Rows written locally since the load began keep their local state.
+    for (const auto &[id, seq] : local_writes_) {
+      if (seq <= read_seq) {
+        continue;
+      }
+      if (const auto it = users_.find(id); it != users_.end()) {
+        users.insert_or_assign(id, it->second);
+      } else {
+        users.erase(id);
+      }
+      reread.push_back(id);
+    }
+    users_.swap(users);
+    pruneLocalWrites(read_seq);
+  }
+  reloads_.fetch_add(1, std::memory_order_relaxed);
+  // The previous copy is freed here, outside the lock.
+  return reread;
+}
+
+std::vector<int>
+ReplicatedUserRepository::refresh(pqxx::connection &conn,
+                                  const std::vector<int> &ids) {
+  std::uint64_t read_seq;
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    read_seq = write_seq_;
+  }
+  pqxx::nontransaction txn(conn);
+  // Sorted by id, like @p ids; ids without a row were deleted.
+  const pqxx::result res =
+      txn.exec_prepared(user_statements::kGetByIds.name, toIntArray(ids));
+  std::vector<int> reread;
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  auto row = res.begin();
+  for (const int id : ids) {
+    const bool found = row != res.end() && (*row)[0].as<int>() == id;
+    const auto local = local_writes_.find(id);
+    if (local != local_writes_.end() && local->second > read_seq) {
+      reread.push_back(id); // The local write may be the newer one.
+    } else if (found) {
+      users_.insert_or_assign(id, rowToUser(*row));
+    } else {
+      users_.erase(id);
+    }
+    if (found) {
+      ++row;
+    }
+  }
+  pruneLocalWrites(read_seq);
+  return reread;
+}
+
+void ReplicatedUserRepository::pruneLocalWrites(std::uint64_t seq) {
+  // Every later read started after these writes had committed.
+  for (auto it = local_writes_.begin(); it != local_writes_.end();) {
+    it = it->second <= seq ? local_writes_.erase(it) : std::next(it);
+  }
+}
+
+void ReplicatedUserRepository::publish(
+    const std::vector<PendingChange> &changes) {
+  const std::lock_guard<std::mutex> lock(listeners_mutex_);
+  if (listeners_.empty()) {
+    return;
+  }
+  for (const PendingChange &pending : changes) {
+    domain::UserChange change{pending.kind, {pending.id, "", ""}};
+    if (pending.kind == Kind::kInsert || pending.kind == Kind::kUpdate) {
+      // The row as read this round; empty if deleted since.
+      std::shared_lock<std::shared_mutex> users_lock(mutex_);
+      if (const auto it = users_.find(pending.id); it != users_.end()) {
+        change.user.name = it->second.name;
+        change.user.email = it->second.email;
+      }
+    }
+    for (const auto &[subscription, listener] : listeners_) {
+      try {
+        listener(change);
+      } catch (const std::exception &e) {
+        common::logError("replica", "Change listener failed: ", e.what());
+      }
+    }
+  }
+}
+
+// --- Local copy ---
+
+void ReplicatedUserRepository::store(const application::UserResponse &user) {
+  if (ReplicatedUnitOfWork::find(this)) {
+    return; // Not committed yet; its notification will bring it.
+  }
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  users_.insert_or_assign(user.id, user);
+  local_writes_[user.id] = ++write_seq_;
+}
+
+void ReplicatedUserRepository::erase(int id) {
+  if (ReplicatedUnitOfWork::find(this)) {
+    return;
+  }
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  users_.erase(id);
+  local_writes_[id] = ++write_seq_;
+}
+
+// --- IUserRepository ---
+
+std::optional<application::UserResponse> ReplicatedUserRepository::createUser(
+    const application::CreateUserRequest &user) {
+  auto created = inner_->createUser(user);
+  if (created) {
+    store(*created);
+  }
+  return created;
+}
+
+application::BulkCreateResult ReplicatedUserRepository::bulkCreateUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  return inner_->bulkCreateUsers(users);
+}
+
+application::BulkUpsertResult ReplicatedUserRepository::upsertUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  return inner_->upsertUsers(users);
+}
+
+std::optional<application::UserResponse>
+ReplicatedUserRepository::getUserById(int id) {
+  if (!servesReads()) {
+    return inner_->getUserById(id);
+  }
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  if (const auto it = users_.find(id); it != users_.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+std::optional<application::UserResponse>
+ReplicatedUserRepository::getUserByEmail(const std::string &email) {
+  return inner_->getUserByEmail(email);
+}
+
+application::UserBatch
+ReplicatedUserRepository::getUsersByIds(const std::vector<int> &ids) {
+  if (!servesReads()) {
+    return inner_->getUsersByIds(ids);
+  }
+  std::vector<int> sorted(ids);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  application::UserBatch batch;
+  batch.reserve(sorted.size());
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  for (const int id : sorted) {
+    if (const auto it = users_.find(id); it != users_.end()) {
+      batch.push_back(id, it->second.name, it->second.email);
+    }
+  }
+  return batch;
+}
+
+application::UserBatch ReplicatedUserRepository::getAllUsers() {
+  if (!servesReads()) {
+    return inner_->getAllUsers();
+  }
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  std::size_t text_bytes = 0;
+  for (const auto &[id, user] : users_) {
+    text_bytes += user.name.size() + user.email.size();
+  }
+  application::UserBatch batch;
+  batch.reserve(users_.size(), text_bytes);
+  for (const auto &[id, user] : users_) {
+    batch.push_back(id, user.name, user.email);
+  }
+  return batch;
+}
+
+application::UserBatch
+ReplicatedUserRepository::getUsersPage(int after_id, std::size_t limit) {
+  if (!servesReads()) {
+    return inner_->getUsersPage(after_id, limit);
+  }
+  application::UserBatch batch;
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  batch.reserve(std::min(limit, users_.size()));
+  for (auto it = users_.upper_bound(after_id);
+       it != users_.end() && batch.size() < limit; ++it) {
+    batch.push_back(it->first, it->second.name, it->second.email);
+  }
+  return batch;
+}
+
+application::UserBatch ReplicatedUserRepository::searchUsersByNamePrefix(
+    const std::string &prefix, const application::NameCursor &after,
+    std::size_t limit) {
+  return inner_->searchUsersByNamePrefix(prefix, after, limit);
+}
+
+bool ReplicatedUserRepository::forEachUser(
+    const domain::UserVisitor &visitor) {
+  if (!servesReads()) {
+    return inner_->forEachUser(visitor);
+  }
+  // Copy small chunks under the lock and visit them without it, so a slow
+  // or re-entrant visitor never blocks the listener.
+  std::vector<application::UserResponse> chunk;
+  chunk.reserve(kVisitChunk);
+  std::optional<int> last;
+  for (;;) {
+    chunk.clear();
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      for (auto it = last ? users_.upper_bound(*last) : users_.begin();
+           it != users_.end() && chunk.size() < kVisitChunk; ++it) {
+        chunk.push_back(it->second);
+      }
+    }
+    if (chunk.empty()) {
+      return true;
+    }
+    last = chunk.back().id;
+    for (const auto &user : chunk) {
+      visitor(user);
+    }
+  }
+}
+
+std::optional<application::UserResponse>
+ReplicatedUserRepository::updateUser(const cppcrudbp::domain::User &user) {
+  auto updated = inner_->updateUser(user);
+  if (updated) {
+    store(*updated);
+  }
+  return updated;
+}
+
+std::vector<int> ReplicatedUserRepository::updateUsers(
+    const std::vector<cppcrudbp::domain::User> &users) {
+  std::vector<int> updated = inner_->updateUsers(users);
+  // A row updated holds exactly what was sent; in input order, so the last
+  // update of an id is the one stored.
+  for (const auto &user : users) {
+    if (std::binary_search(updated.begin(), updated.end(), user.id)) {
+      store(application::toUserResponse(user));
+    }
+  }
+  return updated;
+}
+
+bool ReplicatedUserRepository::deleteUser(int id) {
+  const bool deleted = inner_->deleteUser(id);
+  if (deleted) {
+    erase(id);
+  }
+  return deleted;
+}
+
+std::vector<int>
+ReplicatedUserRepository::deleteUsers(const std::vector<int> &ids) {
+  std::vector<int> deleted = inner_->deleteUsers(ids);
+  for (const int id : deleted) {
+    erase(id);
+  }
+  return deleted;
+}
+
+std::unique_ptr<domain::IUnitOfWork>
+ReplicatedUserRepository::beginUnitOfWork() {
+  if (ReplicatedUnitOfWork::find(this)) {
+    return nullptr;
+  }
+  auto inner = inner_->beginUnitOfWork();
+  if (!inner) {
+    return nullptr;
+  }
+  return std::make_unique<ReplicatedUnitOfWork>(this, std::move(inner));
+}
+
+// --- IUserChangeFeed ---
+
+std::uint64_t
+ReplicatedUserRepository::subscribe(domain::UserChangeListener listener) {
+  const std::lock_guard<std::mutex> lock(listeners_mutex_);
+  const std::uint64_t subscription = next_subscription_++;
+  listeners_.emplace(subscription, std::move(listener));
+  return subscription;
+}
+
+void ReplicatedUserRepository::unsubscribe(std::uint64_t subscription) {
+  // Waits for a publish() in progress, which holds the lock.
+  const std::lock_guard<std::mutex> lock(listeners_mutex_);
+  listeners_.erase(subscription);
+}
+
+UserReplicaStats ReplicatedUserRepository::stats() const {
+  UserReplicaStats snapshot;
+  snapshot.local_reads = local_reads_.load(std::memory_order_relaxed);
+  snapshot.fallback_reads = fallback_reads_.load(std::memory_order_relaxed);
+  snapshot.changes = changes_.load(std::memory_order_relaxed);
+  snapshot.reloads = reloads_.load(std::memory_order_relaxed);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  snapshot.users = users_.size();
+  return snapshot;
+}
+
+} // namespace cppcrudbp::infrastructure
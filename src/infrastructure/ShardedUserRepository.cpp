@@ -0,0 +1,787 @@
+#include "infrastructure/sharded_user_repository.h"
+#include "common/logger.h"
+#include "infrastructure/postgre_support.h"
+#include "infrastructure/postgre_user_repository.h"
+#include "infrastructure/user_statements.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+
+namespace cppcrudbp::infrastructure {
+
+namespace {
+
+using postgre_support::execPrepared;
+using postgre_support::importStaged;
+using postgre_support::inTransaction;
+using postgre_support::Lease;
+using postgre_support::rowToUser;
+using postgre_support::rowToView;
+
+// Users per shard fetched at a time by forEachUser.
+constexpr std::size_t kVisitChunk = 1000;
+
+// Merges batches each ordered by @p less into one, up to @p limit users.
+// There are few shards, so the least head is found by a linear scan.
+template <typename Less>
+application::UserBatch merge(const std::vector<application::UserBatch> &parts,
+                             std::size_t limit, Less less) {
+  std::size_t total = 0;
+  for (const auto &part : parts) {
+    total += part.size();
+  }
+  application::UserBatch merged;
+  merged.reserve(std::min(total, limit));
+  std::vector<std::size_t> next(parts.size(), 0);
+  while (merged.size() < limit) {
+    std::size_t best = parts.size();
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+      if (next[i] < parts[i].size() &&
+          (best == parts.size() ||
+           less(parts[i][next[i]], parts[best][next[best]]))) {
+        best = i;
+      }
+    }
+    if (best == parts.size()) {
+      break;
+    }
+    merged.push_back(parts[best][next[best]++]);
+  }
+  return merged;
+}
+
+bool byId(const application::UserView &a, const application::UserView &b) {
+  return a.id < b.id;
+}
+
+bool byNameThenId(const application::UserView &a,
+                  const application::UserView &b) {
+  return a.name < b.name || (a.name == b.name && a.id < b.id);
+}
+
+// The shards with something to do, for scatter().
+template <typename Group>
+std::vector<bool> nonEmpty(const std::vector<Group> &groups) {
+  std::vector<bool> involved(groups.size());
+  for (std::size_t shard = 0; shard < groups.size(); ++shard) {
+    involved[shard] = !groups[shard].empty();
+  }
+  return involved;
+}
+
+// Threads serving one shard's part of scattered calls.
+class ShardWorkers {
+public:
+  explicit ShardWorkers(std::size_t threads) {
+    threads_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+      threads_.emplace_back(&ShardWorkers::run, this);
+    }
+  }
+
+  ~ShardWorkers() {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    ready_.notify_all();
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+
+  ShardWorkers(const ShardWorkers &) = delete;
+  ShardWorkers &operator=(const ShardWorkers &) = delete;
+
+  void post(std::function<void()> job) {
+    {
+      const std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(std::move(job));
+    }
+    ready_.notify_one();
+  }
+
+private:
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      ready_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+      if (jobs_.empty()) {
+        return; // Stopping, with nothing left to run.
+      }
+      std::function<void()> job = std::move(jobs_.front());
+      jobs_.pop_front();
+      lock.unlock();
+      job();
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<std::function<void()>> jobs_; // mutex_
+  bool stopping_ = false;                  // mutex_
+  std::vector<std::thread> threads_;
+};
+
+} // namespace
+
+struct ShardedUserRepository::Shard {
+  std::shared_ptr<common::ConnectionPool> pool;
+  // Single-shard reads are plain PostgreUserRepository calls.
+  std::unique_ptr<PostgreUserRepository> reader;
+  // More threads than connections could only wait for one.
+  std::unique_ptr<ShardWorkers> workers;
+};
+
+ShardedUserRepository::ShardedUserRepository(
+    std::vector<std::shared_ptr<cppcrudbp::common::ConnectionPool>> shards) {
+  if (shards.empty()) {
+    throw std::invalid_argument("At least one shard is required.");
+  }
+  shards_.reserve(shards.size());
+  for (auto &pool : shards) {
+    if (!pool) {
+      throw std::invalid_argument("ConnectionPool cannot be null.");
+    }
+    auto reader = std::make_unique<PostgreUserRepository>(pool);
+    auto workers = std::make_unique<ShardWorkers>(
+        std::max<std::size_t>(1, pool->options().max_size));
+    shards_.push_back(
+        Shard{std::move(pool), std::move(reader), std::move(workers)});
+  }
+}
+
+ShardedUserRepository::~ShardedUserRepository() = default;
+
+std::size_t ShardedUserRepository::shardCount() const {
+  return shards_.size();
+}
+
+std::size_t ShardedUserRepository::shardOfId(int id) const {
+  const auto shards = static_cast<long long>(shards_.size());
+  return static_cast<std::size_t>(((id % shards) + shards) % shards);
+}
+
+std::size_t ShardedUserRepository::shardOfEmail(std::string_view email) const {
+  // FNV-1a: stable across builds and platforms, as it must be for claims
+  // to be found again.
+  std::uint64_t hash = 0xcbf29ce484222325ull;
+  for (const char c : email) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return static_cast<std::size_t>(hash % shards_.size());
+}
+
+template <typename Run>
+auto ShardedUserRepository::scatter(Run &&run,
+                                    const std::vector<bool> &involved) {
+  using Result = std::invoke_result_t<Run &, std::size_t>;
+  std::vector<Result> results(shards_.size());
+  std::vector<std::size_t> targets;
+  for (std::size_t shard = 0; shard < shards_.size(); ++shard) {
+    if (involved.empty() || involved[shard]) {
+      targets.push_back(shard);
+    }
+  }
+  if (targets.empty()) {
+    return results;
+  }
+  std::vector<std::future<Result>> pending;
+  pending.reserve(targets.size() - 1);
+  for (std::size_t i = 1; i < targets.size(); ++i) {
+    const std::size_t shard = targets[i];
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        [&run, shard] { return run(shard); });
+    pending.push_back(task->get_future());
+    shards_[shard].workers->post([task] { (*task)(); });
+  }
+  // The calling thread takes the first shard rather than waiting idle. The
+  // tasks refer to run, so every one is waited for even if one throws.
+  std::exception_ptr error;
+  try {
+    results[targets[0]] = run(targets[0]);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  for (std::size_t i = 1; i < targets.size(); ++i) {
+    try {
+      results[targets[i]] = pending[i - 1].get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return results;
+}
+
+void ShardedUserRepository::releaseEmail(const std::string &email, int id) {
+  try {
+    inTransaction<pqxx::nontransaction>(
+        *shards_[shardOfEmail(email)].pool, this,
+        [&](Lease &conn, pqxx::transaction_base &txn) {
+          return execPrepared(conn, txn, user_statements::kShardReleaseEmail,
+                              email, id);
+        });
+  } catch (const std::exception &e) {
+    common::logError("sharded", "Stale claim on ", email, " left: ",
+                     e.what());
+  }
+}
+
+std::optional<application::UserResponse>
+ShardedUserRepository::createUser(const application::CreateUserRequest &user) {
+  const std::size_t shard = shardOfEmail(user.email);
+  try {
+    return inTransaction<pqxx::nontransaction>(
+        *shards_[shard].pool, this,
+        [&](Lease &conn, pqxx::transaction_base &txn)
+            -> std::optional<application::UserResponse> {
+          pqxx::result res = execPrepared(
+              conn, txn, user_statements::kShardCreate, user.name, user.email,
+              static_cast<long long>(shards_.size()),
+              static_cast<long long>(shard));
+          return rowToUser(res[0]);
+        });
+  } catch (const std::exception &e) {
+    common::logError("sharded", "Error creating user: ", e.what());
+    return std::nullopt;
+  }
+}
+
+application::BulkCreateResult ShardedUserRepository::bulkCreateUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  application::BulkCreateResult result;
+  if (users.empty()) {
+    return result;
+  }
+  std::vector<std::vector<application::CreateUserRequest>> groups(
+      shards_.size());
+  std::vector<std::size_t> shard_of(users.size());
+  for (std::size_t i = 0; i < users.size(); ++i) {
+    shard_of[i] = shardOfEmail(users[i].email);
+    groups[shard_of[i]].push_back(users[i]);
+  }
+
+  // The emails each shard inserted, or nullopt if its batch failed.
+  const auto inserted = scatter(
+      [&](std::size_t shard) -> std::optional<std::vector<std::string>> {
+        try {
+          const pqxx::result res = inTransaction<pqxx::work>(
+              *shards_[shard].pool, this,
+              [&](Lease &, pqxx::transaction_base &txn) {
+                return importStaged(txn, groups[shard],
+                                    user_statements::kShardInsertFromImport,
+                                    static_cast<long long>(shards_.size()),
+                                    static_cast<long long>(shard));
+              });
+          std::vector<std::string> emails;
+          emails.reserve(res.size());
+          for (const auto &row : res) {
+            emails.emplace_back(row[0].view());
+          }
+          return emails;
+        } catch (const std::exception &e) {
+          common::logError("sharded", "Error importing users: ", e.what());
+          return std::nullopt;
+        }
+      },
+      nonEmpty(groups));
+
+  std::unordered_multiset<std::string_view> remaining;
+  for (const auto &emails : inserted) {
+    if (emails) {
+      result.inserted += emails->size();
+      remaining.insert(emails->begin(), emails->end());
+    }
+  }
+  // Rejections are reported in input order, as from a single database.
+  for (std::size_t i = 0; i < users.size(); ++i) {
+    if (!inserted[shard_of[i]]) {
+      ++result.failed;
+      continue;
+    }
+    const auto it = remaining.find(users[i].email);
+    if (it != remaining.end()) {
+      remaining.erase(it);
+    } else {
+      result.rejected_emails.push_back(users[i].email);
+    }
+  }
+  return result;
+}
+
+application::BulkUpsertResult ShardedUserRepository::upsertUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  application::BulkUpsertResult result;
+  if (users.empty()) {
+    return result;
+  }
+  std::vector<std::vector<application::CreateUserRequest>> groups(
+      shards_.size());
+  for (const auto &user : users) {
+    groups[shardOfEmail(user.email)].push_back(user);
+  }
+
+  struct ShardUpsert {
+    bool failed = false;
+    std::size_t emails = 0; // Distinct.
+    std::size_t inserted = 0;
+    std::size_t updated = 0;
+    std::vector<domain::User> elsewhere; // Rows on other shards.
+  };
+  auto outcomes = scatter(
+      [&](std::size_t shard) {
+        ShardUpsert outcome;
+        std::unordered_set<std::string_view> emails;
+        for (const auto &user : groups[shard]) {
+          emails.insert(user.email);
+        }
+        outcome.emails = emails.size();
+        try {
+          const pqxx::result res = inTransaction<pqxx::work>(
+              *shards_[shard].pool, this,
+              [&](Lease &, pqxx::transaction_base &txn) {
+                return importStaged(txn, groups[shard],
+                                    user_statements::kShardUpsertFromImport,
+                                    static_cast<long long>(shards_.size()),
+                                    static_cast<long long>(shard));
+              });
+          for (const auto &row : res) {
+            const char kind = row[0].view()[0];
+            if (kind == 'i') {
+              ++outcome.inserted;
+            } else if (kind == 'r') {
+              ++outcome.updated;
+            } else {
+              outcome.elsewhere.push_back(domain::User{
+                  row[1].as<int>(), std::string(row[2].view()),
+                  std::string(row[3].view())});
+            }
+          }
+        } catch (const std::exception &e) {
+          common::logError("sharded", "Error upserting users: ", e.what());
+          outcome.failed = true;
+        }
+        return outcome;
+      },
+      nonEmpty(groups));
+
+  for (std::size_t shard = 0; shard < outcomes.size(); ++shard) {
+    ShardUpsert &outcome = outcomes[shard];
+    if (outcome.failed) {
+      result.failed += groups[shard].size();
+      continue;
+    }
+    // Users whose email changed since they were created, one by one.
+    std::size_t renamed = 0;
+    std::size_t lost = 0;
+    for (const domain::User &user : outcome.elsewhere) {
+      try {
+        renamed += inTransaction<pqxx::nontransaction>(
+            *shards_[shardOfId(user.id)].pool, this,
+            [&](Lease &conn, pqxx::transaction_base &txn) {
+              return execPrepared(conn, txn, user_statements::kShardRename,
+                                  user.name, user.id, user.email)
+                  .affected_rows();
+            });
+      } catch (const std::exception &e) {
+        common::logError("sharded", "Error upserting users: ", e.what());
+        ++lost;
+      }
+    }
+    const std::size_t changed =
+        outcome.inserted + outcome.updated + renamed + lost;
+    result.inserted += outcome.inserted;
+    result.updated += outcome.updated + renamed;
+    result.failed += lost;
+    result.unchanged += outcome.emails > changed ? outcome.emails - changed : 0;
+  }
+  return result;
+}
+
+std::optional<application::UserResponse>
+ShardedUserRepository::getUserById(int id) {
+  return shards_[shardOfId(id)].reader->getUserById(id);
+}
+
+std::optional<application::UserResponse>
+ShardedUserRepository::findUserById(int id) {
+  return shards_[shardOfId(id)].reader->findUserById(id);
+}
+
+std::optional<application::UserResponse>
+ShardedUserRepository::getUserByEmail(const std::string &email) {
+  int id = 0;
+  try {
+    pqxx::result res = inTransaction<pqxx::nontransaction>(
+        *shards_[shardOfEmail(email)].pool, this,
+        [&](Lease &conn, pqxx::transaction_base &txn) {
+          return execPrepared(conn, txn, user_statements::kShardFindEmail,
+                              email);
+        });
+    if (res.empty()) {
+      return std::nullopt;
+    }
+    if (!res[0][1].is_null()) {
+      // The row is on the claim's shard, as it is unless its email changed.
+      return application::UserResponse{res[0][0].as<int>(),
+                                       std::string(res[0][1].view()),
+                                       std::string(res[0][2].view())};
+    }
+    id = res[0][0].as<int>();
+  } catch (const std::exception &e) {
+    common::logError("sharded", "Error fetching user by email: ", e.what());
+    return std::nullopt;
+  }
+  auto user = getUserById(id);
+  if (user && user->email != email) {
+    return std::nullopt; // A stale claim.
+  }
+  return user;
+}
+
+application::UserBatch
+ShardedUserRepository::getUsersByIds(const std::vector<int> &ids) {
+  return usersByIds(ids, &PostgreUserRepository::getUsersByIds);
+}
+
+application::UserBatch
+ShardedUserRepository::findUsersByIds(const std::vector<int> &ids) {
+  return usersByIds(ids, &PostgreUserRepository::findUsersByIds);
+}
+
+application::UserBatch ShardedUserRepository::usersByIds(
+    const std::vector<int> &ids,
+    application::UserBatch (PostgreUserRepository::*read)(
+        const std::vector<int> &)) {
+  if (ids.empty()) {
+    return {};
+  }
+  std::vector<std::vector<int>> groups(shards_.size());
+  for (const int id : ids) {
+    groups[shardOfId(id)].push_back(id);
+  }
+  const auto parts = scatter(
+      [&](std::size_t shard) {
+        return (shards_[shard].reader.get()->*read)(groups[shard]);
+      },
+      nonEmpty(groups));
+  return merge(parts, ids.size(), byId);
+}
+
+application::UserBatch ShardedUserRepository::getAllUsers() {
+  auto parts = scatter([this](std::size_t shard) {
+    return shards_[shard].reader->getAllUsers();
+  });
+  if (parts.size() == 1) {
+    return std::move(parts[0]);
+  }
+  // Unordered, like a single database's.
+  std::size_t users = 0;
+  std::size_t text_bytes = 0;
+  for (const auto &part : parts) {
+    users += part.size();
+    for (const auto &user : part) {
+      text_bytes += user.name.size() + user.email.size();
+    }
+  }
+  application::UserBatch all;
+  all.reserve(users, text_bytes);
+  for (const auto &part : parts) {
+    for (const auto &user : part) {
+      all.push_back(user);
+    }
+  }
+  return all;
+}
+
+application::UserBatch
+ShardedUserRepository::getUsersPage(int after_id, std::size_t limit) {
+  // Each shard's first @p limit users after the cursor hold the page.
+  const auto parts = scatter([&](std::size_t shard) {
+    return shards_[shard].reader->getUsersPage(after_id, limit);
+  });
+  return merge(parts, limit, byId);
+}
+
+application::UserBatch ShardedUserRepository::searchUsersByNamePrefix(
+    const std::string &prefix, const application::NameCursor &after,
+    std::size_t limit) {
+  const auto parts = scatter([&](std::size_t shard) {
+    return shards_[shard].reader->searchUsersByNamePrefix(prefix, after,
+                                                          limit);
+  });
+  return merge(parts, limit, byNameThenId);
+}
+
+bool ShardedUserRepository::forEachUser(const domain::UserVisitor &visitor) {
+  // Merges the shards in id order, holding one chunk of each at a time.
+  struct Cursor {
+    application::UserBatch chunk;
+    std::size_t next = 0;
+    int after_id = 0;
+    bool done = false;
+  };
+  std::vector<Cursor> cursors(shards_.size());
+  application::UserResponse user;
+  try {
+    for (;;) {
+      std::size_t best = cursors.size();
+      for (std::size_t shard = 0; shard < cursors.size(); ++shard) {
+        Cursor &cursor = cursors[shard];
+        if (!cursor.done && cursor.next == cursor.chunk.size()) {
+          cursor.chunk = inTransaction<pqxx::nontransaction>(
+              *shards_[shard].pool, this,
+              [&](Lease &conn, pqxx::transaction_base &txn) {
+                const pqxx::result res = execPrepared(
+                    conn, txn, user_statements::kGetPage, cursor.after_id,
+                    static_cast<long long>(kVisitChunk));
+                application::UserBatch chunk;
+                chunk.reserve(res.size());
+                for (const auto &row : res) {
+                  chunk.push_back(rowToView(row));
+                }
+                return chunk;
+              });
+          cursor.next = 0;
+          cursor.done = cursor.chunk.empty();
+          if (!cursor.done) {
+            cursor.after_id = cursor.chunk.back().id;
+          }
+        }
+        if (!cursor.done &&
+            (best == cursors.size() ||
+             cursor.chunk[cursor.next].id <
+                 cursors[best].chunk[cursors[best].next].id)) {
+          best = shard;
+        }
+      }
+      if (best == cursors.size()) {
+        return true;
+      }
+      const auto view = cursors[best].chunk[cursors[best].next++];
+      user.id = view.id;
+      user.name.assign(view.name);
+      user.email.assign(view.email);
+      visitor(user);
+    }
+  } catch (const std::exception &e) {
+    common::logError("sharded", "Error streaming users: ", e.what());
+    return false;
+  }
+}
+
+std::optional<application::UserResponse>
+ShardedUserRepository::updateUser(const domain::User &user) {
+  // Claim the new email first: until the old claim is released below, both
+  // emails are blocked, never free for two users.
+  bool claimed = false;
+  try {
+    const pqxx::result res = inTransaction<pqxx::nontransaction>(
+        *shards_[shardOfEmail(user.email)].pool, this,
+        [&](Lease &conn, pqxx::transaction_base &txn) {
+          return execPrepared(conn, txn, user_statements::kShardClaimEmail,
+                              user.email, user.id);
+        });
+    if (res.empty()) {
+      return std::nullopt; // Another user has that email.
+    }
+    claimed = res[0][0].as<bool>();
+  } catch (const std::exception &e) {
+    common::logError("sharded", "Error updating user: ", e.what());
+    return std::nullopt;
+  }
+
+  std::optional<application::UserResponse> updated;
+  std::string old_email;
+  try {
+    const pqxx::result res = inTransaction<pqxx::nontransaction>(
+        *shards_[shardOfId(user.id)].pool, this,
+        [&](Lease &conn, pqxx::transaction_base &txn) {
+          return execPrepared(conn, txn, user_statements::kShardUpdate,
+                              user.name, user.email, user.id);
+        });
+    if (!res.empty()) {
+      updated = rowToUser(res[0]);
+      old_email = res[0][3].c_str();
+    }
+  } catch (const std::exception &e) {
+    common::logError("sharded", "Error updating user: ", e.what());
+  }
+  if (!updated) {
+    if (claimed) {
+      releaseEmail(user.email, user.id);
+    }
+    return std::nullopt;
+  }
+  if (old_email != user.email) {
+    releaseEmail(old_email, user.id);
+  }
+  return updated;
+}
+
+std::vector<int>
+ShardedUserRepository::updateUsers(const std::vector<domain::User> &users) {
+  std::vector<std::vector<domain::User>> groups(shards_.size());
+  for (auto &user : lastUpdatePerId(users)) {
+    groups[shardOfId(user.id)].push_back(std::move(user));
+  }
+  // Per shard, the users renamed in one statement and those whose email
+  // changes, which go through updateUser for its claims.
+  struct Outcome {
+    std::vector<int> renamed;
+    std::vector<int> new_email;
+  };
+  const auto outcomes = scatter(
+      [&](std::size_t shard) {
+        Outcome outcome;
+        try {
+          std::string ids, names, emails;
+          std::tie(ids, names, emails) = toUpdateArrays(groups[shard]);
+          const pqxx::result res = inTransaction<pqxx::nontransaction>(
+              *shards_[shard].pool, this,
+              [&](Lease &conn, pqxx::transaction_base &txn) {
+                return execPrepared(conn, txn,
+                                    user_statements::kShardUpdateMany, ids,
+                                    names, emails);
+              });
+          for (const auto &row : res) {
+            (row[1].as<bool>() ? outcome.renamed : outcome.new_email)
+                .push_back(row[0].as<int>());
+          }
+        } catch (const std::exception &e) {
+          common::logError("sharded", "Error updating users: ", e.what());
+        }
+        return outcome;
+      },
+      nonEmpty(groups));
+
+  std::vector<int> updated;
+  for (std::size_t shard = 0; shard < outcomes.size(); ++shard) {
+    const auto &group = groups[shard];
+    updated.insert(updated.end(), outcomes[shard].renamed.begin(),
+                   outcomes[shard].renamed.end());
+    for (const int id : outcomes[shard].new_email) {
+      const auto user = std::lower_bound(
+          group.begin(), group.end(), id,
+          [](const domain::User &user, int id) { return user.id < id; });
+      if (updateUser(*user)) {
+        updated.push_back(id);
+      }
+    }
+  }
+  std::sort(updated.begin(), updated.end());
+  return updated;
+}
+
+bool ShardedUserRepository::deleteUser(int id) {
+  std::optional<std::string> email;
+  try {
+    const pqxx::result res = inTransaction<pqxx::nontransaction>(
+        *shards_[shardOfId(id)].pool, this,
+        [&](Lease &conn, pqxx::transaction_base &txn) {
+          return execPrepared(conn, txn, user_statements::kShardDelete, id);
+        });
+    if (!res.empty()) {
+      email = res[0][0].c_str();
+    }
+  } catch (const std::exception &e) {
+    common::logError("sharded", "Error deleting user: ", e.what());
+    return false;
+  }
+  if (!email) {
+    return false;
+  }
+  releaseEmail(*email, id);
+  return true;
+}
+
+std::vector<int>
+ShardedUserRepository::deleteUsers(const std::vector<int> &ids) {
+  if (ids.empty()) {
+    return {};
+  }
+  std::vector<std::vector<int>> groups(shards_.size());
+  for (const int id : ids) {
+    groups[shardOfId(id)].push_back(id);
+  }
+  // Per shard, the ids deleted and, for each, the shard of its claim.
+  using Deleted = std::vector<std::pair<int, std::size_t>>;
+  const auto deleted = scatter(
+      [&](std::size_t shard) {
+        Deleted rows;
+        try {
+          const pqxx::result res = inTransaction<pqxx::nontransaction>(
+              *shards_[shard].pool, this,
+              [&](Lease &conn, pqxx::transaction_base &txn) {
+                return execPrepared(conn, txn,
+                                    user_statements::kShardDeleteByIds,
+                                    toIntArray(groups[shard]));
+              });
+          rows.reserve(res.size());
+          for (const auto &row : res) {
+            rows.emplace_back(row[0].as<int>(), shardOfEmail(row[1].view()));
+          }
+        } catch (const std::exception &e) {
+          common::logError("sharded", "Error deleting users: ", e.what());
+        }
+        return rows;
+      },
+      nonEmpty(groups));
+
+  std::vector<int> ids_deleted;
+  std::vector<std::vector<int>> claims(shards_.size());
+  for (const Deleted &rows : deleted) {
+    for (const auto &[id, claim_shard] : rows) {
+      ids_deleted.push_back(id);
+      claims[claim_shard].push_back(id);
+    }
+  }
+  scatter(
+      [&](std::size_t shard) {
+        try {
+          inTransaction<pqxx::nontransaction>(
+              *shards_[shard].pool, this,
+              [&](Lease &conn, pqxx::transaction_base &txn) {
+                return execPrepared(conn, txn,
+                                    user_statements::kShardReleaseEmailsOf,
+                                    toIntArray(claims[shard]));
+              });
+          return true;
+        } catch (const std::exception &e) {
+          common::logError("sharded", "Stale claims left: ", e.what());
+          return false;
+        }
+      },
+      nonEmpty(claims));
+  std::sort(ids_deleted.begin(), ids_deleted.end());
+  return ids_deleted;
+}
+
+std::unique_ptr<domain::IUnitOfWork> ShardedUserRepository::beginUnitOfWork() {
+  common::logError("sharded", "Error starting unit of work: transactions "
+                              "across shards are not supported.");
+  return nullptr;
+}
+
+} // namespace cppcrudbp::infrastructure
@@ -0,0 +1,442 @@
+#include "infrastructure/snapshot_user_repository.h"
+#include "common/logger.h"
+#include "infrastructure/active_unit_of_work.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace cppcrudbp::infrastructure {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+application::UserResponse toResponse(const application::UserView &user) {
+  return application::UserResponse{user.id, std::string(user.name),
+                                   std::string(user.email)};
+}
+
+domain::SnapshotInfo describe(const std::string &path,
+                              const UserSnapshot &snapshot,
+                              Clock::time_point start) {
+  return domain::SnapshotInfo{path, snapshot.size(), snapshot.bytes(),
+                              Clock::now() - start};
+}
+
+} // namespace
+
+// Routes the opening thread's reads past the snapshot, which cannot hold
+// uncommitted rows, and holds back its writes until it ends.
+class SnapshotUnitOfWork final : public domain::IUnitOfWork,
+                                 public ActiveUnitOfWork<SnapshotUnitOfWork> {
+public:
+  SnapshotUnitOfWork(SnapshotUserRepository *owner,
+                     std::unique_ptr<domain::IUnitOfWork> inner)
+      : ActiveUnitOfWork(owner), owner_(owner), inner_(std::move(inner)) {}
+  ~SnapshotUnitOfWork() override { rollback(); }
+
+  bool commit() override {
+    if (!inner_) {
+      return false;
+    }
+    const bool committed = inner_->commit();
+    finish();
+    // Even a failed commit may have reached the database.
+    owner_->markWritten(ids_, all_);
+    return committed;
+  }
+
+  void rollback() override {
+    if (!inner_) {
+      return;
+    }
+    inner_->rollback();
+    finish();
+  }
+
+  void wrote(const std::vector<int> &ids, bool all) {
+    ids_.insert(ids_.end(), ids.begin(), ids.end());
+    all_ = all_ || all;
+  }
+
+private:
+  void finish() {
+    deactivate();
+    inner_.reset();
+  }
+
+  SnapshotUserRepository *owner_;
+  std::unique_ptr<domain::IUnitOfWork> inner_;
+  std::vector<int> ids_;
+  bool all_ = false;
+};
+
+SnapshotUserRepository::SnapshotUserRepository(
+    std::shared_ptr<cppcrudbp::domain::IUserRepository> inner,
+    std::string path, SnapshotOptions options)
+    : inner_(std::move(inner)), path_(std::move(path)), options_(options) {
+  if (!inner_) {
+    throw std::invalid_argument("Wrapped repository cannot be null.");
+  }
+  if (options_.refresh_interval.count() <= 0) {
+    throw std::invalid_argument("Snapshot refresh interval must be positive.");
+  }
+  try {
+    const auto info = loadSnapshot(path_);
+    common::Logger::global().log(
+        common::LogLevel::kInfo, "snapshot", "Loaded ", info.path, ": ",
+        std::to_string(info.users), " users, ", std::to_string(info.bytes),
+        " bytes in ",
+        std::to_string(
+            std::chrono::duration_cast<std::chrono::microseconds>(info.elapsed)
+                .count()),
+        " us");
+  } catch (const std::exception &e) {
+    common::logWarning("snapshot", "Reading from the repository until the "
+                                   "snapshot is written: ",
+                       e.what());
+  }
+  refresher_ = std::thread([this] { run(); });
+}
+
+SnapshotUserRepository::~SnapshotUserRepository() {
+  {
+    const std::lock_guard<std::mutex> lock(state_mutex_);
+    stopping_ = true;
+  }
+  state_changed_.notify_all();
+  refresher_.join();
+}
+
+// --- Snapshot ---
+
+std::shared_ptr<const UserSnapshot>
+SnapshotUserRepository::readable(std::optional<int> id) {
+  std::shared_ptr<const UserSnapshot> snapshot;
+  if (!SnapshotUnitOfWork::find(this)) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const bool clean =
+        all_dirty_ == 0 && (id ? dirty_.count(*id) == 0 : dirty_.empty());
+    if (clean) {
+      snapshot = snapshot_;
+    }
+  }
+  (snapshot ? snapshot_reads_ : fallback_reads_)
+      .fetch_add(1, std::memory_order_relaxed);
+  return snapshot;
+}
+
+void SnapshotUserRepository::noteWrites(const std::vector<int> &ids,
+                                        bool all) {
+  if (auto *unit = SnapshotUnitOfWork::find(this)) {
+    unit->wrote(ids, all);
+    return;
+  }
+  markWritten(ids, all);
+}
+
+void SnapshotUserRepository::markWritten(const std::vector<int> &ids,
+                                         bool all) {
+  if (ids.empty() && !all) {
+    return;
+  }
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  const std::uint64_t write = ++writes_;
+  if (all) {
+    all_dirty_ = write;
+  }
+  for (const int id : ids) {
+    dirty_[id] = write;
+  }
+}
+
+void SnapshotUserRepository::install(
+    std::shared_ptr<const UserSnapshot> snapshot, std::uint64_t seen) {
+  {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    snapshot_.swap(snapshot);
+    if (all_dirty_ <= seen) {
+      all_dirty_ = 0;
+    }
+    for (auto it = dirty_.begin(); it != dirty_.end();) {
+      it = it->second <= seen ? dirty_.erase(it) : std::next(it);
+    }
+  }
+  // The previous snapshot is unmapped here, outside the lock, once no
+  // reader holds it.
+}
+
+domain::SnapshotInfo SnapshotUserRepository::refresh() {
+  const std::lock_guard<std::mutex> refresh_lock(refresh_mutex_);
+  const auto start = Clock::now();
+  std::uint64_t seen;
+  {
+    // Writes numbered up to here completed before the snapshot reads the
+    // users, so it holds them.
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    seen = writes_;
+  }
+  UserSnapshot::write(path_, *inner_);
+  auto snapshot = UserSnapshot::open(path_, options_.verify);
+  auto info = describe(path_, *snapshot, start);
+  install(std::move(snapshot), seen);
+  refreshes_.fetch_add(1, std::memory_order_relaxed);
+  return info;
+}
+
+domain::SnapshotInfo
+SnapshotUserRepository::saveSnapshot(const std::string &path) {
+  const std::lock_guard<std::mutex> refresh_lock(refresh_mutex_);
+  const auto start = Clock::now();
+  const std::size_t users = UserSnapshot::write(path, *inner_);
+  // Mapping it back for its size also proves the file readable.
+  const auto snapshot = UserSnapshot::open(path, false);
+  auto info = describe(path, *snapshot, start);
+  info.users = users;
+  return info;
+}
+
+domain::SnapshotInfo
+SnapshotUserRepository::loadSnapshot(const std::string &path) {
+  const auto start = Clock::now();
+  auto snapshot = UserSnapshot::open(path, options_.verify);
+  auto info = describe(path, *snapshot, start);
+  // Its age is unknown, so every write noted so far stays noted.
+  install(std::move(snapshot), 0);
+  return info;
+}
+
+void SnapshotUserRepository::run() {
+  std::chrono::seconds wait{0};
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (snapshot_) {
+      wait = options_.refresh_interval;
+    }
+  }
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(state_mutex_);
+      if (state_changed_.wait_for(lock, wait, [this] { return stopping_; })) {
+        return;
+      }
+    }
+    wait = options_.refresh_interval;
+    try {
+      const auto info = refresh();
+      common::Logger::global().log(
+          common::LogLevel::kInfo, "snapshot", "Refreshed ", info.path, ": ",
+          std::to_string(info.users), " users in ",
+          std::to_string(
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                  info.elapsed)
+                  .count()),
+          " ms");
+    } catch (const std::exception &e) {
+      common::logError("snapshot", "Snapshot refresh failed: ", e.what());
+    }
+  }
+}
+
+SnapshotStats SnapshotUserRepository::stats() const {
+  SnapshotStats stats;
+  stats.snapshot_reads = snapshot_reads_.load(std::memory_order_relaxed);
+  stats.fallback_reads = fallback_reads_.load(std::memory_order_relaxed);
+  stats.refreshes = refreshes_.load(std::memory_order_relaxed);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  stats.users = snapshot_ ? snapshot_->size() : 0;
+  return stats;
+}
+
+// --- IUserRepository ---
+
+std::optional<application::UserResponse> SnapshotUserRepository::createUser(
+    const application::CreateUserRequest &user) {
+  auto created = inner_->createUser(user);
+  if (created) {
+    noteWrites({created->id});
+  }
+  return created;
+}
+
+application::BulkCreateResult SnapshotUserRepository::bulkCreateUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  auto result = inner_->bulkCreateUsers(users);
+  noteWrites({}, true);
+  return result;
+}
+
+application::BulkUpsertResult SnapshotUserRepository::upsertUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  auto result = inner_->upsertUsers(users);
+  noteWrites({}, true);
+  return result;
+}
+
+std::optional<application::UserResponse>
+SnapshotUserRepository::getUserById(int id) {
+  const auto snapshot = readable(id);
+  if (!snapshot) {
+    return inner_->getUserById(id);
+  }
+  if (const auto user = snapshot->find(id)) {
+    return toResponse(*user);
+  }
+  return std::nullopt;
+}
+
+std::optional<application::UserResponse>
+SnapshotUserRepository::getUserByEmail(const std::string &email) {
+  return inner_->getUserByEmail(email);
+}
+
+application::UserBatch
+SnapshotUserRepository::getUsersByIds(const std::vector<int> &ids) {
+  std::vector<int> sorted(ids);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  std::shared_ptr<const UserSnapshot> snapshot;
+  std::vector<int> written;
+  if (!SnapshotUnitOfWork::find(this)) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (all_dirty_ == 0) {
+      snapshot = snapshot_;
+      for (const int id : sorted) {
+        if (dirty_.count(id) != 0) {
+          written.push_back(id);
+        }
+      }
+    }
+  }
+  if (!snapshot) {
+    fallback_reads_.fetch_add(1, std::memory_order_relaxed);
+    return inner_->getUsersByIds(ids);
+  }
+  snapshot_reads_.fetch_add(1, std::memory_order_relaxed);
+
+  // Merge the snapshot's users with the written ones, read afresh; both
+  // are in id order.
+  const application::UserBatch fresh = written.empty()
+                                           ? application::UserBatch()
+                                           : inner_->getUsersByIds(written);
+  application::UserBatch batch;
+  batch.reserve(sorted.size());
+  std::size_t next_fresh = 0;
+  auto next_written = written.begin();
+  for (const int id : sorted) {
+    if (next_written != written.end() && *next_written == id) {
+      ++next_written;
+      if (next_fresh < fresh.size() && fresh[next_fresh].id == id) {
+        const auto user = fresh[next_fresh++];
+        batch.push_back(user.id, user.name, user.email);
+      }
+    } else if (const auto user = snapshot->find(id)) {
+      batch.push_back(user->id, user->name, user->email);
+    }
+  }
+  return batch;
+}
+
+application::UserBatch SnapshotUserRepository::getAllUsers() {
+  const auto snapshot = readable();
+  if (!snapshot) {
+    return inner_->getAllUsers();
+  }
+  application::UserBatch batch;
+  batch.reserve(snapshot->size(), snapshot->textBytes());
+  for (std::size_t i = 0; i < snapshot->size(); ++i) {
+    const auto user = snapshot->at(i);
+    batch.push_back(user.id, user.name, user.email);
+  }
+  return batch;
+}
+
+application::UserBatch
+SnapshotUserRepository::getUsersPage(int after_id, std::size_t limit) {
+  const auto snapshot = readable();
+  if (!snapshot) {
+    return inner_->getUsersPage(after_id, limit);
+  }
+  const std::size_t first = snapshot->upperBound(after_id);
+  const std::size_t end = first + std::min(limit, snapshot->size() - first);
+  application::UserBatch batch;
+  batch.reserve(end - first);
+  for (std::size_t i = first; i < end; ++i) {
+    const auto user = snapshot->at(i);
+    batch.push_back(user.id, user.name, user.email);
+  }
+  return batch;
+}
+
+application::UserBatch SnapshotUserRepository::searchUsersByNamePrefix(
+    const std::string &prefix, const application::NameCursor &after,
+    std::size_t limit) {
+  return inner_->searchUsersByNamePrefix(prefix, after, limit);
+}
+
+bool SnapshotUserRepository::forEachUser(const domain::UserVisitor &visitor) {
+  const auto snapshot = readable();
+  if (!snapshot) {
+    return inner_->forEachUser(visitor);
+  }
+  // The mapping is immutable and held alive by @c snapshot, so no lock is
+  // needed; one record is reused to keep its string capacity.
+  application::UserResponse user{};
+  for (std::size_t i = 0; i < snapshot->size(); ++i) {
+    const auto view = snapshot->at(i);
+    user.id = view.id;
+    user.name.assign(view.name);
+    user.email.assign(view.email);
+    visitor(user);
+  }
+  return true;
+}
+
+std::optional<application::UserResponse>
+SnapshotUserRepository::updateUser(const cppcrudbp::domain::User &user) {
+  auto updated = inner_->updateUser(user);
+  noteWrites({user.id});
+  return updated;
+}
+
+std::vector<int> SnapshotUserRepository::updateUsers(
+    const std::vector<cppcrudbp::domain::User> &users) {
+  std::vector<int> updated = inner_->updateUsers(users);
+  std::vector<int> ids;
+  ids.reserve(users.size());
+  for (const auto &user : users) {
+    ids.push_back(user.id);
+  }
+  noteWrites(ids);
+  return updated;
+}
+
+bool SnapshotUserRepository::deleteUser(int id) {
+  const bool deleted = inner_->deleteUser(id);
+  if (deleted) {
+    noteWrites({id});
+  }
+  return deleted;
+}
+
+std::vector<int>
+SnapshotUserRepository::deleteUsers(const std::vector<int> &ids) {
+  std::vector<int> deleted = inner_->deleteUsers(ids);
+  noteWrites(deleted);
+  return deleted;
+}
+
+std::unique_ptr<domain::IUnitOfWork>
+SnapshotUserRepository::beginUnitOfWork() {
+  if (SnapshotUnitOfWork::find(this)) {
+    return nullptr;
+  }
+  auto inner = inner_->beginUnitOfWork();
+  if (!inner) {
+    return nullptr;
+  }
+  return std::make_unique<SnapshotUnitOfWork>(this, std::move(inner));
+}
+
+} // namespace cppcrudbp::infrastructure
@@ -0,0 +1,348 @@
+#include "infrastructure/user_snapshot.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace cppcrudbp::infrastructure {
+
+struct UserSnapshot::Header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t index_bits; // The index has 2^index_bits slots.
+  std::uint64_t users;
+  std::uint64_t records_offset;
+  std::uint64_t index_offset;
+  std::uint64_t heap_offset;
+  std::uint64_t heap_bytes;
+  std::uint64_t file_bytes;
+  std::uint64_t checksum; // Of bytes [records_offset, file_bytes).
+  std::int64_t created_unix_ms;
+};
+
+struct UserSnapshot::Record {
+  std::int32_t id;
+  std::uint32_t text_offset; // Name, then email, in the heap.
+  std::uint16_t name_length;
+  std::uint16_t email_length;
+};
+
+namespace {
+
+constexpr char kMagic[8] = {'C', 'P', 'P', 'U', 'S', 'N', 'A', 'P'};
+constexpr std::uint32_t kEmptySlot = std::numeric_limits<std::uint32_t>::max();
+
+std::uint64_t alignUp(std::uint64_t offset) { return (offset + 7) & ~7ull; }
+
+std::uint64_t rotl(std::uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+std::uint64_t load64(const char *data) {
+  std::uint64_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+// Multiply-rotate hash over 8-byte words in four independent lanes, so
+// the multiplies overlap; @p size is a multiple of 8.
+std::uint64_t checksum(const char *data, std::size_t size) {
+  constexpr std::uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+  constexpr std::uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+  std::uint64_t lanes[4] = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    for (std::size_t lane = 0; lane < 4; ++lane) {
+      lanes[lane] =
+          rotl(lanes[lane] + load64(data + i + 8 * lane) * kPrime2, 31) *
+          kPrime1;
+    }
+  }
+  std::uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) +
+                       rotl(lanes[2], 12) + rotl(lanes[3], 18);
+  for (; i + 8 <= size; i += 8) {
+    hash ^= rotl(load64(data + i) * kPrime2, 31) * kPrime1;
+    hash = rotl(hash, 27) * kPrime1 + kPrime2;
+  }
+  hash ^= size;
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  return hash;
+}
+
+std::size_t slotOf(int id, std::uint32_t index_bits) {
+  return static_cast<std::size_t>(
+      (static_cast<std::uint64_t>(static_cast<std::uint32_t>(id)) *
+       0x9E3779B97F4A7C15ull) >>
+      (64 - index_bits));
+}
+
+std::runtime_error fileError(const std::string &what,
+                             const std::string &path) {
+  return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+std::shared_ptr<const UserSnapshot> UserSnapshot::open(const std::string &path,
+                                                        bool verify) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw fileError("Cannot open snapshot", path);
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    const auto error = fileError("Cannot stat snapshot", path);
+    ::close(fd);
+    throw error;
+  }
+  const auto size = static_cast<std::size_t>(st.st_size);
+  if (size < sizeof(Header)) {
+    ::close(fd);
+    throw std::runtime_error("Snapshot " + path + " is truncated.");
+  }
+  void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // The mapping keeps the file open.
+  if (mapped == MAP_FAILED) {
+    throw fileError("Cannot map snapshot", path);
+  }
+
+  std::shared_ptr<UserSnapshot> snapshot(new UserSnapshot());
+  snapshot->data_ = static_cast<const char *>(mapped);
+  snapshot->bytes_ = size;
+  const auto *header = reinterpret_cast<const Header *>(snapshot->data_);
+  const auto invalid = [&path](const char *why) {
+    return std::runtime_error("Snapshot " + path + " is invalid: " + why);
+  };
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+    throw invalid("not a users snapshot");
+  }
+  if (header->version != kVersion) {
+    throw invalid("unsupported version or byte order");
+  }
+  const std::uint64_t index_slots = std::uint64_t{1} << header->index_bits;
+  if (header->file_bytes != size || header->index_bits < 1 ||
+      header->index_bits > 32 || header->users > kEmptySlot ||
+      index_slots <= header->users ||
+      header->records_offset != alignUp(sizeof(Header)) ||
+      header->index_offset <
+          header->records_offset + header->users * sizeof(Record) ||
+      header->heap_offset <
+          header->index_offset + index_slots * sizeof(std::uint32_t) ||
+      header->heap_offset + header->heap_bytes > size ||
+      header->index_offset % 8 != 0 || header->heap_offset % 8 != 0 ||
+      size % 8 != 0) {
+    throw invalid("inconsistent header");
+  }
+  if (verify && checksum(snapshot->data_ + header->records_offset,
+                         size - header->records_offset) !=
+                    header->checksum) {
+    throw invalid("checksum mismatch");
+  }
+  snapshot->header_ = header;
+  snapshot->records_ = reinterpret_cast<const Record *>(
+      snapshot->data_ + header->records_offset);
+  snapshot->index_ = reinterpret_cast<const std::uint32_t *>(
+      snapshot->data_ + header->index_offset);
+  snapshot->heap_ = snapshot->data_ + header->heap_offset;
+  return snapshot;
+}
+
+std::size_t UserSnapshot::write(const std::string &path,
+                                domain::IUserRepository &source) {
+  static_assert(sizeof(Header) == 80 && sizeof(Record) == 12,
+                "The file layout must not change without a new version.");
+  std::vector<Record> records;
+  std::string heap;
+  std::string error;
+  const bool read = source.forEachUser(
+      [&records, &heap, &error](const application::UserResponse &user) {
+        constexpr std::size_t kMaxLength =
+            std::numeric_limits<std::uint16_t>::max();
+        if (!error.empty()) {
+          return;
+        }
+        if (user.name.size() > kMaxLength || user.email.size() > kMaxLength) {
+          error = "user " + std::to_string(user.id) + " has a field over " +
+                  std::to_string(kMaxLength) + " bytes";
+          return;
+        }
+        if (heap.size() + user.name.size() + user.email.size() >
+            std::numeric_limits<std::uint32_t>::max()) {
+          error = "names and emails exceed 4 GiB";
+          return;
+        }
+        records.push_back(
+            Record{user.id, static_cast<std::uint32_t>(heap.size()),
+                   static_cast<std::uint16_t>(user.name.size()),
+                   static_cast<std::uint16_t>(user.email.size())});
+        heap += user.name;
+        heap += user.email;
+      });
+  if (!read) {
+    throw std::runtime_error("Cannot write snapshot " + path +
+                             ": reading users failed.");
+  }
+  if (!error.empty()) {
+    throw std::runtime_error("Cannot write snapshot " + path + ": " + error +
+                             ".");
+  }
+  const auto by_id = [](const Record &a, const Record &b) {
+    return a.id < b.id;
+  };
+  if (!std::is_sorted(records.begin(), records.end(), by_id)) {
+    std::sort(records.begin(), records.end(), by_id);
+  }
+
+  // At most half full, so probe runs stay short.
+  std::uint32_t index_bits = 4;
+  while ((std::uint64_t{1} << index_bits) < 2 * records.size()) {
+    ++index_bits;
+  }
+  std::vector<std::uint32_t> index(std::size_t{1} << index_bits, kEmptySlot);
+  const std::size_t mask = index.size() - 1;
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    std::size_t slot = slotOf(records[i].id, index_bits);
+    while (index[slot] != kEmptySlot) {
+      slot = (slot + 1) & mask;
+    }
+    index[slot] = static_cast<std::uint32_t>(i);
+  }
+
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.index_bits = index_bits;
+  header.users = records.size();
+  header.records_offset = alignUp(sizeof(Header));
+  header.index_offset =
+      alignUp(header.records_offset + records.size() * sizeof(Record));
+  header.heap_offset =
+      alignUp(header.index_offset + index.size() * sizeof(std::uint32_t));
+  header.heap_bytes = heap.size();
+  header.file_bytes = alignUp(header.heap_offset + heap.size());
+  header.created_unix_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+
+  std::vector<char> file(header.file_bytes, 0);
+  std::memcpy(file.data() + header.records_offset, records.data(),
+              records.size() * sizeof(Record));
+  std::memcpy(file.data() + header.index_offset, index.data(),
+              index.size() * sizeof(std::uint32_t));
+  std::memcpy(file.data() + header.heap_offset, heap.data(), heap.size());
+  header.checksum = checksum(file.data() + header.records_offset,
+                             file.size() - header.records_offset);
+  std::memcpy(file.data(), &header, sizeof(header));
+
+  const std::string temp = path + ".tmp";
+  const int fd =
+      ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw fileError("Cannot create snapshot", temp);
+  }
+  std::size_t written = 0;
+  while (written < file.size()) {
+    const ssize_t n =
+        ::write(fd, file.data() + written, file.size() - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      const auto error = fileError("Cannot write snapshot", temp);
+      ::close(fd);
+      std::remove(temp.c_str());
+      throw error;
+    }
+    written += static_cast<std::size_t>(n);
+  }
+  // Durable before it replaces the old file.
+  if (::fsync(fd) != 0 || ::close(fd) != 0) {
+    const auto error = fileError("Cannot write snapshot", temp);
+    std::remove(temp.c_str());
+    throw error;
+  }
+  if (std::rename(temp.c_str(), path.c_str()) != 0) {
+    const auto error = fileError("Cannot replace snapshot", path);
+    std::remove(temp.c_str());
+    throw error;
+  }
+  return records.size();
+}
+
+UserSnapshot::~UserSnapshot() {
+  if (data_) {
+    ::munmap(const_cast<char *>(data_), bytes_);
+  }
+}
+
+std::size_t UserSnapshot::size() const {
+  return static_cast<std::size_t>(header_->users);
+}
+
+std::size_t UserSnapshot::textBytes() const {
+  return static_cast<std::size_t>(header_->heap_bytes);
+}
+
+std::int64_t UserSnapshot::createdAtMs() const {
+  return header_->created_unix_ms;
+}
+
+application::UserView UserSnapshot::at(std::size_t i) const {
+  const Record &record = records_[i];
+  // Only a checksum covers the records: without one, keep reads in the heap.
+  if (std::uint64_t{record.text_offset} + record.name_length +
+          record.email_length >
+      header_->heap_bytes) {
+    throw std::runtime_error("Snapshot record " + std::to_string(i) +
+                             " points outside the heap.");
+  }
+  const char *text = heap_ + record.text_offset;
+  return application::UserView{
+      record.id, std::string_view(text, record.name_length),
+      std::string_view(text + record.name_length, record.email_length)};
+}
+
+std::optional<application::UserView> UserSnapshot::find(int id) const {
+  const std::size_t mask = (std::size_t{1} << header_->index_bits) - 1;
+  // open() checked that the index has an empty slot, but not where: a
+  // corrupt index could be full, so stop after one pass.
+  std::size_t slot = slotOf(id, header_->index_bits);
+  for (std::size_t probe = 0; probe <= mask; ++probe) {
+    const std::uint32_t record = index_[slot];
+    if (record == kEmptySlot) {
+      return std::nullopt;
+    }
+    if (record >= header_->users) {
+      throw std::runtime_error("Snapshot index slot " + std::to_string(slot) +
+                               " names no record.");
+    }
+    if (records_[record].id == id) {
+      return at(record);
+    }
+    slot = (slot + 1) & mask;
+  }
+  return std::nullopt;
+}
+
+std::size_t UserSnapshot::upperBound(int id) const {
+  const Record *end = records_ + size();
+  return static_cast<std::size_t>(
+      std::upper_bound(records_, end, id,
+                       [](int value, const Record &record) {
+                         return value < record.id;
+                       }) -
+      records_);
+}
+
+} // namespace cppcrudbp::infrastructure
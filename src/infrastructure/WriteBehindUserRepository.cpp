@@ -0,0 +1,474 @@
+#include "infrastructure/write_behind_user_repository.h"
+#include "common/logger.h"
+#include "infrastructure/active_unit_of_work.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace cppcrudbp::infrastructure {
+
+// Sends the opening thread's calls straight to the wrapped repository,
+// whose unit of work they belong to.
+class WriteBehindUnitOfWork final
+    : public domain::IUnitOfWork,
+      public ActiveUnitOfWork<WriteBehindUnitOfWork> {
+public:
+  WriteBehindUnitOfWork(const WriteBehindUserRepository *owner,
+                        std::unique_ptr<domain::IUnitOfWork> inner)
+      : ActiveUnitOfWork(owner), inner_(std::move(inner)) {}
+  ~WriteBehindUnitOfWork() override { rollback(); }
+
+  bool commit() override {
+    if (!inner_) {
+      return false;
+    }
+    const bool committed = inner_->commit();
+    finish();
+    return committed;
+  }
+
+  void rollback() override {
+    if (!inner_) {
+      return;
+    }
+    inner_->rollback();
+    finish();
+  }
+
+private:
+  void finish() {
+    deactivate();
+    inner_.reset();
+  }
+
+  std::unique_ptr<domain::IUnitOfWork> inner_;
+};
+
+WriteBehindUserRepository::WriteBehindUserRepository(
+    std::shared_ptr<cppcrudbp::domain::IUserRepository> inner,
+    WriteBehindOptions options)
+    : inner_(std::move(inner)), options_(options) {
+  if (!inner_) {
+    throw std::invalid_argument("Wrapped repository cannot be null.");
+  }
+  if (options_.flush_batch == 0 || options_.max_pending == 0 ||
+      options_.max_delay.count() <= 0 || options_.max_attempts == 0) {
+    throw std::invalid_argument("Write-behind bounds must be positive.");
+  }
+  auto &metrics = common::Metrics::global();
+  queue_metric_ = metrics.registerOperation("write-behind", "updateUser");
+  flush_metric_ = metrics.registerOperation("write-behind", "flush");
+  flusher_ = std::thread([this] { run(); });
+}
+
+WriteBehindUserRepository::~WriteBehindUserRepository() {
+  {
+    const std::lock_guard<std::mutex> lock(state_mutex_);
+    stopping_ = true;
+  }
+  state_changed_.notify_all();
+  flusher_.join();
+}
+
+// --- Queue ---
+
+void WriteBehindUserRepository::run() {
+  std::unique_lock<std::mutex> lock(state_mutex_);
+  for (;;) {
+    state_changed_.wait(lock,
+                        [this] { return stopping_ || !queued_.empty(); });
+    if (!stopping_) {
+      // A full batch goes at once, a smaller one when its oldest update
+      // is due.
+      state_changed_.wait_until(lock, oldest_ + options_.max_delay, [this] {
+        return stopping_ || queued_.size() >= options_.flush_batch;
+      });
+    }
+    if (stopping_ && queued_.empty()) {
+      return; // Drained.
+    }
+    lock.unlock();
+    flushQueued();
+    lock.lock();
+  }
+}
+
+void WriteBehindUserRepository::flushQueued() {
+  const std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+  writeQueued();
+}
+
+void WriteBehindUserRepository::writeQueued() {
+  std::vector<Pending> batch;
+  {
+    // Reads keep seeing the batch in flushing_ until it is written.
+    const std::lock_guard<std::mutex> lock(state_mutex_);
+    flushing_.swap(queued_);
+    batch.reserve(flushing_.size());
+    for (const auto &entry : flushing_) {
+      batch.push_back(entry.second);
+    }
+  }
+  if (batch.empty()) {
+    return;
+  }
+  std::sort(batch.begin(), batch.end(),
+            [](const Pending &a, const Pending &b) { return a.seq < b.seq; });
+  std::vector<domain::User> users;
+  users.reserve(batch.size());
+  for (const auto &entry : batch) {
+    users.push_back(entry.user);
+  }
+
+  common::OperationTimer timer(flush_metric_);
+  const auto start = Clock::now();
+  std::vector<int> written;
+  try {
+    written = inner_->updateUsers(users);
+  } catch (const std::exception &e) {
+    common::logError("write-behind", "Error writing queued updates: ",
+                     e.what());
+  }
+  std::vector<Pending> unwritten;
+  if (written.size() < batch.size()) {
+    // Retried alone and in call order, a rejected update fails by itself.
+    for (auto &entry : batch) {
+      if (std::binary_search(written.begin(), written.end(), entry.user.id)) {
+        continue;
+      }
+      bool applied = false;
+      try {
+        applied = inner_->updateUser(entry.user).has_value();
+      } catch (const std::exception &e) {
+        common::logError("write-behind", "Error writing queued update: ",
+                         e.what());
+      }
+      if (!applied) {
+        unwritten.push_back(std::move(entry));
+      }
+    }
+  }
+  const auto elapsed =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                           start)
+          .count();
+
+  // A failure may be transient (e.g. a lost connection): the update goes
+  // back in the queue, unless a newer one of its id replaced it meanwhile.
+  std::size_t retried = 0;
+  std::size_t failed = 0;
+  {
+    const std::lock_guard<std::mutex> lock(state_mutex_);
+    flushing_.clear();
+    for (auto &entry : unwritten) {
+      if (queued_.count(entry.user.id) != 0) {
+        continue;
+      }
+      if (++entry.attempts >= options_.max_attempts ||
+          queued_.size() >= options_.max_pending) {
+        ++failed;
+        continue;
+      }
+      if (queued_.empty()) {
+        oldest_ = Clock::now();
+      }
+      const int id = entry.user.id;
+      queued_.emplace(id, std::move(entry));
+      ++retried;
+    }
+  }
+  if (retried != 0) {
+    state_changed_.notify_all();
+  }
+
+  timer.addRows(batch.size());
+  timer.check(failed == 0);
+  flushes_.fetch_add(1, std::memory_order_relaxed);
+  rows_flushed_.fetch_add(batch.size(), std::memory_order_relaxed);
+  retried_.fetch_add(retried, std::memory_order_relaxed);
+  failed_.fetch_add(failed, std::memory_order_relaxed);
+  flush_ns_.fetch_add(elapsed, std::memory_order_relaxed);
+  // Only flushes write it, and they hold flush_mutex_.
+  if (elapsed > max_flush_ns_.load(std::memory_order_relaxed)) {
+    max_flush_ns_.store(elapsed, std::memory_order_relaxed);
+  }
+  if (failed != 0) {
+    common::logWarning("write-behind", std::to_string(failed), " of ",
+                       std::to_string(batch.size()),
+                       " queued updates not applied");
+  }
+}
+
+void WriteBehindUserRepository::flushIfQueued() {
+  {
+    const std::lock_guard<std::mutex> lock(state_mutex_);
+    if (queued_.empty() && flushing_.empty()) {
+      return;
+    }
+  }
+  flushQueued();
+}
+
+void WriteBehindUserRepository::flush() { flushQueued(); }
+
+WriteBehindUserRepository::Updates
+WriteBehindUserRepository::queuedUpdates(const std::vector<int> &ids) const {
+  Updates updates;
+  const std::lock_guard<std::mutex> lock(state_mutex_);
+  if (queued_.empty() && flushing_.empty()) {
+    return updates;
+  }
+  for (const int id : ids) {
+    if (const auto it = queued_.find(id); it != queued_.end()) {
+      updates.insert_or_assign(id, it->second.user);
+    } else if (const auto it = flushing_.find(id); it != flushing_.end()) {
+      updates.insert_or_assign(id, it->second.user);
+    }
+  }
+  return updates;
+}
+
+void WriteBehindUserRepository::dropQueued(const std::vector<int> &ids) {
+  std::size_t dropped = 0;
+  const auto drop = [&] {
+    bool in_flight = false;
+    const std::lock_guard<std::mutex> lock(state_mutex_);
+    for (const int id : ids) {
+      dropped += queued_.erase(id);
+      in_flight = in_flight || flushing_.count(id) != 0;
+    }
+    return in_flight;
+  };
+  if (drop()) {
+    // Deleted under a flush, the update would be reported not applied:
+    // wait for the flush, then drop whatever it put back in the queue.
+    const std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    drop();
+  }
+  dropped_.fetch_add(dropped, std::memory_order_relaxed);
+}
+
+WriteBehindStats WriteBehindUserRepository::stats() const {
+  WriteBehindStats stats;
+  stats.updates = updates_.load(std::memory_order_relaxed);
+  stats.direct = direct_.load(std::memory_order_relaxed);
+  stats.coalesced = coalesced_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  stats.flushes = flushes_.load(std::memory_order_relaxed);
+  stats.rows_flushed = rows_flushed_.load(std::memory_order_relaxed);
+  stats.retried = retried_.load(std::memory_order_relaxed);
+  stats.failed = failed_.load(std::memory_order_relaxed);
+  stats.flush_time =
+      std::chrono::nanoseconds(flush_ns_.load(std::memory_order_relaxed));
+  stats.max_flush_time =
+      std::chrono::nanoseconds(max_flush_ns_.load(std::memory_order_relaxed));
+  const std::lock_guard<std::mutex> lock(state_mutex_);
+  stats.pending = queued_.size() + flushing_.size();
+  return stats;
+}
+
+// --- IUserRepository ---
+
+std::optional<application::UserResponse>
+WriteBehindUserRepository::createUser(
+    const application::CreateUserRequest &user) {
+  if (!WriteBehindUnitOfWork::find(this)) {
+    flushIfQueued(); // A queued update may free or take its email.
+  }
+  return inner_->createUser(user);
+}
+
+application::BulkCreateResult WriteBehindUserRepository::bulkCreateUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  if (!WriteBehindUnitOfWork::find(this)) {
+    flushIfQueued();
+  }
+  return inner_->bulkCreateUsers(users);
+}
+
+application::BulkUpsertResult WriteBehindUserRepository::upsertUsers(
+    const std::vector<application::CreateUserRequest> &users) {
+  if (!WriteBehindUnitOfWork::find(this)) {
+    flushIfQueued();
+  }
+  return inner_->upsertUsers(users);
+}
+
+std::optional<application::UserResponse>
+WriteBehindUserRepository::getUserById(int id) {
+  if (WriteBehindUnitOfWork::find(this)) {
+    return inner_->getUserById(id);
+  }
+  // Looked up on both sides of the read: an update flushed in between may
+  // or may not be in what it returns.
+  const Updates before = queuedUpdates({id});
+  auto user = inner_->getUserById(id);
+  const Updates after = queuedUpdates({id});
+  const Updates &latest = after.empty() ? before : after;
+  if (user && !latest.empty()) {
+    const domain::User &queued = latest.begin()->second;
+    user->name = queued.name;
+    user->email = queued.email;
+  }
+  return user;
+}
+
+std::optional<application::UserResponse>
+WriteBehindUserRepository::getUserByEmail(const std::string &email) {
+  if (!WriteBehindUnitOfWork::find(this)) {
+    flushIfQueued();
+  }
+  return inner_->getUserByEmail(email);
+}
+
+application::UserBatch
+WriteBehindUserRepository::getUsersByIds(const std::vector<int> &ids) {
+  if (WriteBehindUnitOfWork::find(this)) {
+    return inner_->getUsersByIds(ids);
+  }
+  const Updates before = queuedUpdates(ids);
+  application::UserBatch batch = inner_->getUsersByIds(ids);
+  Updates latest = queuedUpdates(ids);
+  for (const auto &entry : before) {
+    latest.insert(entry); // Keeps the newer update where both have one.
+  }
+  if (latest.empty()) {
+    return batch;
+  }
+  application::UserBatch merged;
+  merged.reserve(batch.size());
+  for (const auto user : batch) {
+    if (const auto it = latest.find(user.id); it != latest.end()) {
+      merged.push_back(user.id, it->second.name, it->second.email);
+    } else {
+      merged.push_back(user);
+    }
+  }
+  return merged;
+}
+
+application::UserBatch WriteBehindUserRepository::getAllUsers() {
+  if (!WriteBehindUnitOfWork::find(this)) {
+    flushIfQueued();
+  }
+  return inner_->getAllUsers();
+}
+
+application::UserBatch
+WriteBehindUserRepository::getUsersPage(int after_id, std::size_t limit) {
+  if (!WriteBehindUnitOfWork::find(this)) {
+    flushIfQueued();
+  }
+  return inner_->getUsersPage(after_id, limit);
+}
+
+application::UserBatch WriteBehindUserRepository::searchUsersByNamePrefix(
+    const std::string &prefix, const application::NameCursor &after,
+    std::size_t limit) {
+  if (!WriteBehindUnitOfWork::find(this)) {
+    flushIfQueued();
+  }
+  return inner_->searchUsersByNamePrefix(prefix, after, limit);
+}
+
+bool WriteBehindUserRepository::forEachUser(
+    const domain::UserVisitor &visitor) {
+  if (!WriteBehindUnitOfWork::find(this)) {
+    flushIfQueued();
+  }
+  return inner_->forEachUser(visitor);
+}
+
+std::optional<application::UserResponse>
+WriteBehindUserRepository::updateUser(const cppcrudbp::domain::User &user) {
+  if (WriteBehindUnitOfWork::find(this)) {
+    return inner_->updateUser(user);
+  }
+  common::OperationTimer timer(queue_metric_);
+  // An id with a queued update exists; any other is looked up, so that an
+  // update to a missing user is not reported as done.
+  std::string email;
+  if (const Updates queued = queuedUpdates({user.id}); !queued.empty()) {
+    email = queued.begin()->second.email;
+  } else if (const auto stored = inner_->getUserById(user.id)) {
+    email = stored->email;
+  } else {
+    timer.check(false);
+    return std::nullopt;
+  }
+  if (email != user.email) {
+    // A new email can conflict with any update before it, queued or not:
+    // those are written first, then this one at once, so every batch only
+    // renames and applies whatever order it is written in.
+    const std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    writeQueued();
+    auto updated = inner_->updateUser(user);
+    direct_.fetch_add(1, std::memory_order_relaxed);
+    timer.check(updated.has_value());
+    return updated;
+  }
+  for (;;) {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    if (const auto it = queued_.find(user.id); it != queued_.end()) {
+      it->second = Pending{user, next_seq_++};
+      coalesced_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+    if (queued_.size() < options_.max_pending) {
+      if (queued_.empty()) {
+        oldest_ = Clock::now();
+      }
+      queued_.emplace(user.id, Pending{user, next_seq_++});
+      const std::size_t queued = queued_.size();
+      lock.unlock();
+      timer.addRows(1);
+      // The flusher waits for a first update, then for a full batch.
+      if (queued == 1 || queued == options_.flush_batch) {
+        state_changed_.notify_all();
+      }
+      break;
+    }
+    lock.unlock();
+    flushQueued(); // Full: make room in the calling thread.
+  }
+  updates_.fetch_add(1, std::memory_order_relaxed);
+  return application::toUserResponse(user);
+}
+
+std::vector<int> WriteBehindUserRepository::updateUsers(
+    const std::vector<cppcrudbp::domain::User> &users) {
+  if (!WriteBehindUnitOfWork::find(this)) {
+    flushIfQueued(); // Already a batch; only the order must be kept.
+  }
+  return inner_->updateUsers(users);
+}
+
+bool WriteBehindUserRepository::deleteUser(int id) {
+  if (!WriteBehindUnitOfWork::find(this)) {
+    dropQueued({id});
+  }
+  return inner_->deleteUser(id);
+}
+
+std::vector<int>
+WriteBehindUserRepository::deleteUsers(const std::vector<int> &ids) {
+  if (!WriteBehindUnitOfWork::find(this)) {
+    dropQueued(ids);
+  }
+  return inner_->deleteUsers(ids);
+}
+
+std::unique_ptr<domain::IUnitOfWork>
+WriteBehindUserRepository::beginUnitOfWork() {
+  if (WriteBehindUnitOfWork::find(this)) {
+    return nullptr;
+  }
+  flushIfQueued(); // The unit of work must see the updates before it.
+  auto inner = inner_->beginUnitOfWork();
+  if (!inner) {
+    return nullptr;
+  }
+  return std::make_unique<WriteBehindUnitOfWork>(this, std::move(inner));
+}
+
+} // namespace cppcrudbp::infrastructure
@@ -1,59 +1,144 @@
 #include "presentation/cli.h"
+#include "common/metrics.h"
 #include "domain/domain_exception.h" // Include custom exceptions
+#include "presentation/json_reader.h"
+#include "presentation/json_writer.h"
+#include "presentation/request_validation.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
 #include <limits> // For numeric_limits
 #include <optional>
-#include <regex> // For basic email validation (example)
 #include <sstream>
+#include <thread>
+#include <unordered_set>
 
-// --- Simple JSON Simulation (replace with nlohmann/json or similar) ---
-// This is a very crude simulation for demonstration purposes.
-// In a real project, you would use a robust JSON parsing library.
 namespace {
-// Helper to extract a value from a simple "key": "value" JSON string
-std::string extractJsonValue(const std::string &json, const std::string &key) {
-  std::string search_key = "\"" + key + "\":\"";
-  size_t start_pos = json.find(search_key);
-  if (start_pos == std::string::npos) {
-    return ""; // Key not found
-  }
-  start_pos += search_key.length();
-  size_t end_pos = json.find("\"", start_pos);
-  if (end_pos == std::string::npos) {
-    return ""; // Malformed JSON
-  }
-  return json.substr(start_pos, end_pos - start_pos);
-}
-
-// Helper to extract an int value from a simple "key": number JSON string
-std::optional<int> extractJsonIntValue(const std::string &json,
-                                       const std::string &key) {
-  std::string search_key = "\"" + key + "\":";
-  size_t start_pos = json.find(search_key);
-  if (start_pos == std::string::npos) {
-    return std::nullopt; // Key not found
-  }
-  start_pos += search_key.length();
-  size_t end_pos =
-      json.find_first_of(",}", start_pos); // Find comma or closing brace
-  if (end_pos == std::string::npos) {
-    return std::nullopt; // Malformed JSON
-  }
-  std::string num_str = json.substr(start_pos, end_pos - start_pos);
-  try {
-    return std::stoi(num_str);
-  } catch (const std::exception &) {
-    return std::nullopt; // Not a valid integer
+// Puts a stream pointer back when a scope ends, exceptions included.
+class StreamRestore {
+public:
+  explicit StreamRestore(std::ostream *&stream)
+      : stream_(stream), saved_(stream) {}
+  ~StreamRestore() { stream_ = saved_; }
+  StreamRestore(const StreamRestore &) = delete;
+  StreamRestore &operator=(const StreamRestore &) = delete;
+
+private:
+  std::ostream *&stream_;
+  std::ostream *const saved_;
+};
+
+// Splits one CSV record into fields. Fields may be double-quoted, with ""
+// standing for a literal quote inside a quoted field.
+std::vector<std::string> splitCsvRecord(const std::string &line) {
+  std::vector<std::string> fields(1);
+  bool quoted = false;
+  for (size_t i = 0; i < line.size(); ++i) {
+    const char c = line[i];
+    if (quoted) {
+      if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+        fields.back() += '"';
+        ++i;
+      } else if (c == '"') {
+        quoted = false;
+      } else {
+        fields.back() += c;
+      }
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == ',') {
+      fields.emplace_back();
+    } else {
+      fields.back() += c;
+    }
+  }
+  return fields;
+}
+
+// Parses the id arguments of get-many/delete-many. Ids may be separated by
+// spaces, commas or both.
+std::vector<int> parseIdList(const std::vector<std::string> &args) {
+  std::vector<int> ids;
+  for (const auto &arg : args) {
+    std::stringstream ss(arg);
+    std::string token;
+    while (std::getline(ss, token, ',')) {
+      if (!token.empty()) {
+        ids.push_back(std::stoi(token));
+      }
+    }
+  }
+  return ids;
+}
+
+bool endsWith(const std::string &value, const std::string &suffix) {
+  return value.size() >= suffix.size() &&
+         value.compare(value.size() - suffix.size(), suffix.size(),
+                       suffix) == 0;
+}
+
+// Splits a command line into its command word and arguments, separated by
+// whitespace. A double-quoted argument is kept whole, quotes and escapes
+// included, as a JSON string; everything from the first '{' outside one is
+// kept together as a single JSON argument.
+std::string splitCommandLine(const std::string &commandLine,
+                             std::vector<std::string> &args) {
+  const auto isSpace = [](char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+  };
+  std::string command;
+  std::size_t i = 0;
+  while (true) {
+    while (i < commandLine.size() && isSpace(commandLine[i])) {
+      ++i;
+    }
+    if (i == commandLine.size()) {
+      break;
+    }
+    const std::size_t start = i;
+    if (commandLine[i] == '{' && !command.empty()) {
+      args.push_back(commandLine.substr(i)); // The rest is JSON.
+      break;
+    }
+    if (commandLine[i] == '"') {
+      for (++i; i < commandLine.size() && commandLine[i] != '"'; ++i) {
+        if (commandLine[i] == '\\') {
+          ++i;
+        }
+      }
+      i = std::min(i + 1, commandLine.size());
+    } else {
+      while (i < commandLine.size() && !isSpace(commandLine[i]) &&
+             commandLine[i] != '{') {
+        ++i;
+      }
+    }
+    std::string token = commandLine.substr(start, i - start);
+    if (command.empty()) {
+      command = std::move(token);
+    } else {
+      args.push_back(std::move(token));
+    }
   }
+  return command;
 }
 
 } // anonymous namespace
 
 namespace cppcrudbp::cli {
 
+using presentation::validateUserFields;
+
 CliAdapter::CliAdapter(
-    std::shared_ptr<cppcrudbp::application::UserService> userService)
-    : userService_(std::move(userService)) {
+    std::shared_ptr<cppcrudbp::application::UserService> userService,
+    std::shared_ptr<cppcrudbp::domain::IUserChangeFeed> changes,
+    std::shared_ptr<cppcrudbp::domain::IUserSnapshotStore> snapshots)
+    : userService_(std::move(userService)), changes_(std::move(changes)),
+      snapshots_(std::move(snapshots)) {
   if (!userService_) {
     throw std::invalid_argument("UserService cannot be null.");
   }
@@ -61,103 +146,248 @@ CliAdapter::CliAdapter(
 
 void CliAdapter::run() {
   std::string commandLine;
+  interactive_ = true;
   showHelp();
-  std::cout << "\nEnter command (type 'help' for options, 'exit' to quit):"
-            << std::endl;
+  *out_ << "\nEnter command (type 'help' for options, 'exit' to quit):"
+        << '\n';
 
   while (true) {
-    std::cout << "> ";
+    *out_ << "> " << std::flush;
     std::getline(std::cin, commandLine);
 
     // Clear potential error flags and ignore remaining characters in the buffer
     if (std::cin.fail()) {
       std::cin.clear();
       std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-      std::cerr << "Input error. Please try again." << std::endl;
+      *err_ << "Input error. Please try again." << std::endl;
       continue;
     }
 
     if (commandLine == "exit") {
-      std::cout << "Exiting CLI. Goodbye!" << std::endl;
+      rollbackOpenUnitOfWork();
+      *out_ << "Exiting CLI. Goodbye!" << std::endl;
       break;
     } else if (commandLine == "help") {
       showHelp();
     } else {
       processCommand(commandLine);
     }
+    out_->flush();
   }
+  interactive_ = false;
 }
 
-void CliAdapter::showHelp() const {
-  std::cout << "\n--- Available Commands ---" << std::endl;
-  std::cout << "  create <json_data>          - Create a new user. Example: "
-               "create {\"name\":\"Alice\",\"email\":\"alice@example.com\"}"
-            << std::endl;
-  std::cout
-      << "  get <id>                    - Get a user by ID. Example: get 1"
-      << std::endl;
-  std::cout << "  get-all                     - Get all users." << std::endl;
-  std::cout << "  update <id> <json_data>     - Update an existing user. "
-               "Example: update 1 {\"name\":\"Alice "
-               "Updated\",\"email\":\"alice.updated@example.com\"}"
-            << std::endl;
-  std::cout << "  delete <id>                 - Delete a user by ID. Example: "
-               "delete 1"
-            << std::endl;
-  std::cout << "  help                        - Show this help message."
-            << std::endl;
-  std::cout << "  exit                        - Exit the application."
-            << std::endl;
-  std::cout << "--------------------------" << std::endl;
-}
-
-void CliAdapter::processCommand(const std::string &commandLine) {
-  std::stringstream ss(commandLine);
-  std::string command;
-  ss >> command;
+void CliAdapter::runBatch(std::istream &input, std::size_t groupSize) {
+  // Errors go to the same buffered stream so results stay in command order.
+  const StreamRestore restoreErr(err_);
+  err_ = out_;
+  groupSize = std::max<std::size_t>(1, groupSize);
 
-  std::vector<std::string> args;
-  std::string arg;
-  // Read remaining arguments, handling potential JSON string
-  while (ss >> std::ws &&
-         std::getline(ss, arg, '{')) { // Read until '{' to capture JSON
-    if (!arg.empty()) {
-      std::stringstream arg_ss(arg);
-      std::string token;
-      while (arg_ss >> token) {
-        args.push_back(token);
+  std::size_t commands = 0;
+  std::size_t failed = 0;
+  std::vector<cppcrudbp::application::CreateUserRequest> pendingCreates;
+  pendingCreates.reserve(groupSize);
+
+  // Consecutive creates are sent as one bulk insert (one transaction).
+  const auto flushCreates = [&] {
+    if (pendingCreates.empty()) {
+      return;
+    }
+    const auto result = userService_->bulkCreateUsers(pendingCreates);
+    // The first row per email wins, so rejections belong to the last
+    // occurrences of each rejected email.
+    std::unordered_multiset<std::string> rejected(
+        result.rejected_emails.begin(), result.rejected_emails.end());
+    std::vector<bool> was_rejected(pendingCreates.size());
+    for (std::size_t i = pendingCreates.size(); i-- > 0;) {
+      const auto it = rejected.find(pendingCreates[i].email);
+      if (it != rejected.end()) {
+        rejected.erase(it);
+        was_rejected[i] = true;
+      }
+    }
+    for (std::size_t i = 0; i < pendingCreates.size(); ++i) {
+      if (result.failed > 0) {
+        *out_ << "Failed to create user " << pendingCreates[i].email << ".\n";
+        ++failed;
+      } else if (was_rejected[i]) {
+        *out_ << "Email already in use: " << pendingCreates[i].email << ".\n";
+        ++failed;
+      } else {
+        *out_ << "User created!\n";
+      }
+    }
+    pendingCreates.clear();
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+  std::string line;
+  while (std::getline(input, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    const auto first = line.find_first_not_of(" \t");
+    if (first == std::string::npos || line[first] == '#') {
+      continue;
+    }
+    if (line == "exit") {
+      break;
+    }
+    ++commands;
+
+    std::vector<std::string> args;
+    if (splitCommandLine(line, args) == "create" && !args.empty()) {
+      try {
+        pendingCreates.push_back(parseCreateUserRequest(args[0]));
+      } catch (const std::invalid_argument &e) {
+        flushCreates();
+        *out_ << "Input Error: " << e.what() << '\n';
+        ++failed;
+        continue;
+      }
+      if (pendingCreates.size() == groupSize) {
+        flushCreates();
       }
+      continue;
     }
-    if (ss.good()) { // If '{' was found, put it back and read the rest as JSON
-      std::string json_part =
-          "{" + std::string(std::istreambuf_iterator<char>(ss), {});
-      args.push_back(json_part);
-      break; // Stop processing arguments, the rest is JSON
+    flushCreates();
+    if (!processCommand(line)) {
+      ++failed;
     }
   }
+  flushCreates();
+  rollbackOpenUnitOfWork();
+
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  *out_ << "Batch finished: " << commands << " commands, "
+        << commands - failed << " succeeded, " << failed << " failed in "
+        << seconds << " s ("
+        << (seconds > 0 ? static_cast<double>(commands) / seconds : 0.0)
+        << " commands/sec)." << std::endl;
+}
+
+void CliAdapter::showHelp() const {
+  *out_ << "\n--- Available Commands ---" << '\n';
+  *out_ << "  create <json_data>          - Create a new user. Example: "
+           "create {\"name\":\"Alice\",\"email\":\"alice@example.com\"}"
+        << '\n';
+  *out_ << "  import <file>               - Bulk-create users from a "
+           "JSONL file (one create object per line) or a name,email CSV "
+           "file. Example: import users.csv"
+        << '\n';
+  *out_ << "  sync <file>                 - Upsert users from a file in the "
+           "import formats: new emails are created, known ones renamed. "
+           "Example: sync users.csv"
+        << '\n';
+  *out_ << "  get <id>                    - Get a user by ID. Example: get 1"
+        << '\n';
+  *out_ << "  find-email <email>          - Get a user by email. Example: "
+           "find-email alice@example.com"
+        << '\n';
+  *out_ << "  get-many <id>...            - Get several users in one query "
+           "and list the IDs not found. Example: get-many 1 2 3"
+        << '\n';
+  *out_ << "  get-all                     - Get all users." << '\n';
+  *out_ << "  get-page <after_id> <limit> - Get up to <limit> users with "
+           "ID greater than <after_id>. Example: get-page 0 50"
+        << '\n';
+  *out_ << "  search <prefix> <limit>     - Get up to <limit> users whose "
+           "name starts with <prefix>, ordered by name; the printed next-page "
+           "command continues the list. Quote a prefix with spaces as a JSON "
+           "string. Example: search \"Al\" 20"
+        << '\n';
+  *out_ << "  update <id> <json_data>     - Update an existing user. "
+           "Example: update 1 {\"name\":\"Alice "
+           "Updated\",\"email\":\"alice.updated@example.com\"}"
+        << '\n';
+  *out_ << "  delete <id>                 - Delete a user by ID. Example: "
+           "delete 1"
+        << '\n';
+  *out_ << "  delete-many <id>...         - Delete several users in one "
+           "query and list the IDs not found. Example: delete-many 1 2 3"
+        << '\n';
+  *out_ << "  stats [prometheus]          - Show call counts and latency "
+           "percentiles per operation, or dump them in Prometheus format."
+        << '\n';
+  *out_ << "  watch [seconds]             - Print every change to the "
+           "users, from any client, as it is committed; for <seconds>, or "
+           "until Enter. Needs --replica."
+        << '\n';
+  *out_ << "  snapshot-save <file>        - Write every user to a snapshot "
+           "file. Needs --snapshot. Example: snapshot-save users.snap"
+        << '\n';
+  *out_ << "  snapshot-load <file>        - Serve reads from a snapshot "
+           "file until the next refresh. Needs --snapshot."
+        << '\n';
+  *out_ << "  begin                       - Start a transaction; the "
+           "commands up to 'commit' or 'rollback' apply together."
+        << '\n';
+  *out_ << "  commit                      - Apply the open transaction."
+        << '\n';
+  *out_ << "  rollback                    - Discard the open transaction."
+        << '\n';
+  *out_ << "  help                        - Show this help message." << '\n';
+  *out_ << "  exit                        - Exit the application." << '\n';
+  *out_ << "--------------------------" << '\n';
+}
+
+bool CliAdapter::processCommand(const std::string &commandLine) {
+  std::vector<std::string> args;
+  const std::string command = splitCommandLine(commandLine, args);
 
   try {
     if (command == "create") {
       handleCreateUser(args);
+    } else if (command == "import") {
+      handleImportUsers(args);
+    } else if (command == "sync") {
+      handleSyncUsers(args);
     } else if (command == "get") {
       handleGetUserById(args);
+    } else if (command == "find-email") {
+      handleGetUserByEmail(args);
+    } else if (command == "get-many") {
+      handleGetUsersByIds(args);
     } else if (command == "get-all") {
       handleGetAllUsers();
+    } else if (command == "get-page") {
+      handleGetUsersPage(args);
+    } else if (command == "search") {
+      handleSearchUsers(args);
     } else if (command == "update") {
       handleUpdateUser(args);
     } else if (command == "delete") {
       handleDeleteUser(args);
+    } else if (command == "delete-many") {
+      handleDeleteUsers(args);
+    } else if (command == "stats") {
+      handleStats(args);
+    } else if (command == "watch") {
+      handleWatch(args);
+    } else if (command == "snapshot-save" || command == "snapshot-load") {
+      handleSnapshot(command, args);
+    } else if (command == "begin") {
+      handleBegin();
+    } else if (command == "commit") {
+      handleCommit();
+    } else if (command == "rollback") {
+      handleRollback();
     } else {
-      std::cout << "Unknown command: '" << command
-                << "'. Type 'help' for options." << std::endl;
+      *out_ << "Unknown command: '" << command
+            << "'. Type 'help' for options." << '\n';
+      return false;
     }
+    return true;
   } catch (const cppcrudbp::domain::DomainException &e) {
-    std::cerr << "Error: " << e.what() << std::endl;
+    *err_ << "Error: " << e.what() << '\n';
   } catch (const std::invalid_argument &e) {
-    std::cerr << "Input Error: " << e.what() << std::endl;
+    *err_ << "Input Error: " << e.what() << '\n';
   } catch (const std::exception &e) {
-    std::cerr << "An unexpected error occurred: " << e.what() << std::endl;
+    *err_ << "An unexpected error occurred: " << e.what() << '\n';
   }
+  return false;
 }
 
 void CliAdapter::handleCreateUser(const std::vector<std::string> &args) {
@@ -168,8 +398,12 @@ void CliAdapter::handleCreateUser(const std::vector<std::string> &args) {
       args[0]; // Assuming JSON is the first (and only) arg for simplicity
   cppcrudbp::application::CreateUserRequest request =
       parseCreateUserRequest(jsonBody);
-  bool response = userService_->createUser(request);
-  std::cout << "User created! "; // << request << std::endl;
+  const auto created = userService_->createUser(request);
+  if (!created) {
+    throw cppcrudbp::domain::DomainException("User could not be created.");
+  }
+  presentation::JsonWriter json(out_);
+  json.raw("User created: ").user(*created).raw("\n");
 }
 
 void CliAdapter::handleGetUserById(const std::vector<std::string> &args) {
@@ -179,20 +413,123 @@ void CliAdapter::handleGetUserById(const std::vector<std::string> &args) {
   int id = std::stoi(args[0]);
   std::optional<application::UserResponse> response =
       userService_->getUserById(id);
-  std::cout << "User found: " << serializeUserResponse(response) << std::endl;
+  if (!response) {
+    *out_ << "User with ID " << id << " not found." << '\n';
+    return;
+  }
+  presentation::JsonWriter json(out_);
+  json.raw("User found: ").user(*response).raw("\n");
+}
+
+void CliAdapter::handleGetUserByEmail(const std::vector<std::string> &args) {
+  if (args.empty()) {
+    throw std::invalid_argument("Usage: find-email <email>");
+  }
+  const std::optional<application::UserResponse> response =
+      userService_->getUserByEmail(args[0]);
+  if (!response) {
+    *out_ << "User with email " << args[0] << " not found." << '\n';
+    return;
+  }
+  presentation::JsonWriter json(out_);
+  json.raw("User found: ").user(*response).raw("\n");
+}
+
+void CliAdapter::handleGetUsersByIds(const std::vector<std::string> &args) {
+  const std::vector<int> ids = parseIdList(args);
+  if (ids.empty()) {
+    throw std::invalid_argument("Usage: get-many <id> [<id>...]");
+  }
+  const application::UserBatch users = userService_->getUsersByIds(ids);
+  if (users.empty()) {
+    *out_ << "No users found." << '\n';
+  } else {
+    presentation::JsonWriter json(out_);
+    json.raw("Users: ").users(users).raw("\n");
+  }
+  reportMissingIds(ids, users.ids());
 }
 
 void CliAdapter::handleGetAllUsers() {
-  std::vector<cppcrudbp::application::UserResponse> responses =
-      userService_->getAllUsers();
+  // Rows are serialized as they arrive and written out in buffer-sized
+  // chunks instead of after the whole table loads.
+  std::size_t count = 0;
+  presentation::JsonWriter json(out_);
+  const bool completed = userService_->forEachUser(
+      [&json, &count](const application::UserResponse &user) {
+        json.raw(count++ == 0 ? "All users: [" : ",").user(user);
+      });
+  json.flush();
+  if (count == 0) {
+    *out_ << (completed ? "No users found." : "Failed to read users.")
+          << '\n';
+  } else {
+    *out_ << "]" << '\n';
+    if (!completed) {
+      *out_ << "Listing interrupted after " << count << " users." << '\n';
+    }
+  }
+}
+
+void CliAdapter::handleGetUsersPage(const std::vector<std::string> &args) {
+  if (args.size() < 2) {
+    throw std::invalid_argument("Usage: get-page <after_id> <limit>");
+  }
+  int after_id = std::stoi(args[0]);
+  int limit = std::stoi(args[1]);
+  if (limit <= 0) {
+    throw std::invalid_argument("Page limit must be positive.");
+  }
+  const application::UserBatch responses =
+      userService_->getUsersPage(after_id, static_cast<std::size_t>(limit));
   if (responses.empty()) {
-    std::cout << "No users found." << std::endl;
+    *out_ << "No users found." << '\n';
   } else {
-    std::cout << "All users: " << serializeUserResponses(responses)
-              << std::endl;
+    presentation::JsonWriter json(out_);
+    json.raw("Users: ").users(responses).raw("\n");
+    json.flush();
+    *out_ << "Next page: get-page " << responses.back().id << " " << limit
+          << '\n';
   }
 }
 
+void CliAdapter::handleSearchUsers(const std::vector<std::string> &args) {
+  if (args.size() < 2) {
+    throw std::invalid_argument(
+        "Usage: search <prefix> <limit> [{\"name\":...,\"id\":...}]");
+  }
+  // A prefix holding spaces is given as a JSON string, e.g. "Ann M".
+  std::string prefix = args[0];
+  if (!prefix.empty() && prefix.front() == '"') {
+    presentation::JsonReader reader(args[0]);
+    reader.readString(prefix);
+    reader.expectEnd();
+  }
+  int limit = std::stoi(args[1]);
+  if (limit <= 0) {
+    throw std::invalid_argument("Page limit must be positive.");
+  }
+  application::NameCursor after;
+  if (args.size() > 2) {
+    presentation::parseNameCursorJson(args[2], after);
+  }
+  const application::UserBatch responses =
+      userService_->searchUsersByNamePrefix(prefix, after,
+                                            static_cast<std::size_t>(limit));
+  if (responses.empty()) {
+    *out_ << "No users found." << '\n';
+    return;
+  }
+  presentation::JsonWriter json(out_);
+  json.raw("Users: ").users(responses).raw("\n");
+  // The prefix and the cursor, the page's last user, are printed as JSON
+  // so that names may hold spaces.
+  const application::UserView last = responses.back();
+  json.raw("Next page: search ").string(prefix).raw(" ").number(limit);
+  json.raw(" {\"name\":").string(last.name).raw(",\"id\":");
+  json.number(last.id).raw("}\n");
+}
+
 void CliAdapter::handleUpdateUser(const std::vector<std::string> &args) {
   if (args.size() < 2) {
     throw std::invalid_argument("Usage: update <id> <json_data>");
@@ -201,9 +538,12 @@ void CliAdapter::handleUpdateUser(const std::vector<std::string> &args) {
   std::string jsonBody = args[1]; // Assuming JSON is the second arg
   cppcrudbp::application::UpdateUserRequest request =
       parseUpdateUserRequest(jsonBody, id);
-  bool response = userService_->updateUser(request);
-  std::cout
-      << "User updated! "; // << serializeUserResponse(response) << std::endl;
+  const auto updated = userService_->updateUser(request);
+  if (!updated) {
+    throw cppcrudbp::domain::DomainException("User could not be updated.");
+  }
+  presentation::JsonWriter json(out_);
+  json.raw("User updated: ").user(*updated).raw("\n");
 }
 
 void CliAdapter::handleDeleteUser(const std::vector<std::string> &args) {
@@ -213,69 +553,336 @@ void CliAdapter::handleDeleteUser(const std::vector<std::string> &args) {
   int id = std::stoi(args[0]);
   bool deleted = userService_->deleteUser(id);
   if (deleted) {
-    std::cout << "User with ID " << id << " deleted successfully." << std::endl;
+    *out_ << "User with ID " << id << " deleted successfully." << '\n';
   } else {
-    std::cout << "User with ID " << id << " not found." << std::endl;
+    *out_ << "User with ID " << id << " not found." << '\n';
   }
 }
 
-// --- Helper for JSON simulation (copied from HttpUserController.cpp for
-// consistency) ---
-cppcrudbp::application::CreateUserRequest
-CliAdapter::parseCreateUserRequest(const std::string &json) {
-  cppcrudbp::application::CreateUserRequest request;
-  request.name = extractJsonValue(json, "name");
-  request.email = extractJsonValue(json, "email");
+void CliAdapter::handleDeleteUsers(const std::vector<std::string> &args) {
+  const std::vector<int> ids = parseIdList(args);
+  if (ids.empty()) {
+    throw std::invalid_argument("Usage: delete-many <id> [<id>...]");
+  }
+  const std::vector<int> deleted = userService_->deleteUsers(ids);
+  *out_ << "Deleted " << deleted.size() << " users." << '\n';
+  reportMissingIds(ids, deleted);
+}
 
-  if (request.name.empty() || request.email.empty()) {
-    throw std::invalid_argument(
-        "Name and email are required in JSON for user creation.");
+void CliAdapter::reportMissingIds(std::vector<int> requested,
+                                  const std::vector<int> &present) {
+  std::sort(requested.begin(), requested.end());
+  requested.erase(std::unique(requested.begin(), requested.end()),
+                  requested.end());
+  std::vector<int> missing;
+  std::set_difference(requested.begin(), requested.end(), present.begin(),
+                      present.end(), std::back_inserter(missing));
+  if (missing.empty()) {
+    return;
   }
-  std::regex email_regex(R"(^[^@\s]+@[^@\s]+\.[^@\s]+$)");
-  if (!std::regex_match(request.email, email_regex)) {
-    throw std::invalid_argument("Invalid email format.");
+  *out_ << "Not found:";
+  for (std::size_t i = 0; i < missing.size(); ++i) {
+    *out_ << (i == 0 ? " " : ", ") << missing[i];
   }
-  return request;
+  *out_ << '\n';
 }
 
-cppcrudbp::application::UpdateUserRequest
-CliAdapter::parseUpdateUserRequest(const std::string &json, int id) {
-  cppcrudbp::application::UpdateUserRequest request;
-  request.id = id;
-  request.name = extractJsonValue(json, "name");
-  request.email = extractJsonValue(json, "email");
+void CliAdapter::handleStats(const std::vector<std::string> &args) {
+  const auto stats = common::Metrics::global().snapshot();
+  if (!args.empty() && args[0] == "prometheus") {
+    common::writePrometheus(stats, *out_);
+    return;
+  }
+  if (!args.empty()) {
+    throw std::invalid_argument("Usage: stats [prometheus]");
+  }
+  const auto us = [](double ns) { return ns / 1000.0; };
+  *out_ << std::left << std::setw(36) << "operation" << std::right
+        << std::setw(10) << "calls" << std::setw(8) << "errors"
+        << std::setw(10) << "rows" << std::setw(12) << "bytes"
+        << std::setw(10) << "mean_us" << std::setw(10) << "p50_us"
+        << std::setw(10) << "p99_us" << std::setw(10) << "max_us" << '\n'
+        << std::fixed << std::setprecision(1);
+  for (const auto &op : stats) {
+    if (op.calls == 0) {
+      continue;
+    }
+    const auto &latency = op.latency;
+    *out_ << std::left << std::setw(36) << op.layer + "." + op.operation
+          << std::right << std::setw(10) << op.calls << std::setw(8)
+          << op.errors << std::setw(10) << op.rows << std::setw(12)
+          << op.bytes << std::setw(10) << us(latency.meanNs())
+          << std::setw(10) << us(latency.quantileNs(0.50)) << std::setw(10)
+          << us(latency.quantileNs(0.99)) << std::setw(10)
+          << us(latency.max_ns) << '\n';
+  }
+  *out_ << std::defaultfloat << std::setprecision(6);
+}
 
-  if (request.name.empty() || request.email.empty()) {
-    throw std::invalid_argument(
-        "Name and email are required in JSON for user update.");
+void CliAdapter::handleWatch(const std::vector<std::string> &args) {
+  if (!changes_) {
+    throw cppcrudbp::domain::DomainException(
+        "No change feed; start with --replica to watch changes.");
   }
-  std::regex email_regex(R"(^[^@\s]+@[^@\s]+\.[^@\s]+$)");
-  if (!std::regex_match(request.email, email_regex)) {
-    throw std::invalid_argument("Invalid email format.");
+  std::optional<std::chrono::seconds> duration;
+  if (!args.empty()) {
+    duration = std::chrono::seconds(std::stoi(args[0]));
+  } else if (!interactive_) {
+    throw std::invalid_argument("Usage: watch <seconds>");
   }
-  return request;
+
+  // Prompt first: once subscribed, only the feed's thread writes to out_
+  // until unsubscribe returns.
+  if (!duration) {
+    *out_ << "Watching changes; press Enter to stop." << std::endl;
+  }
+  // Runs on the feed's thread; this one only waits until it is removed.
+  const auto subscription =
+      changes_->subscribe([this](const domain::UserChange &change) {
+        presentation::JsonWriter json(out_);
+        const domain::User &user = change.user;
+        switch (change.kind) {
+        case domain::UserChange::Kind::kInsert:
+          json.raw("insert ");
+          break;
+        case domain::UserChange::Kind::kUpdate:
+          json.raw("update ");
+          break;
+        case domain::UserChange::Kind::kDelete:
+          json.raw("delete ").number(user.id).raw("\n");
+          break;
+        case domain::UserChange::Kind::kTruncate:
+          json.raw("truncate\n");
+          break;
+        }
+        if (change.kind == domain::UserChange::Kind::kInsert ||
+            change.kind == domain::UserChange::Kind::kUpdate) {
+          json.user(application::UserView{user.id, user.name, user.email})
+              .raw("\n");
+        }
+        json.flush();
+        out_->flush();
+      });
+  if (duration) {
+    std::this_thread::sleep_for(*duration);
+  } else {
+    std::string line;
+    std::getline(std::cin, line);
+  }
+  changes_->unsubscribe(subscription);
 }
 
-std::string CliAdapter::serializeUserResponse(
-    const std::optional<application::UserResponse> &response) {
-  std::stringstream ss;
-  ss << "{\"id\":" << response->id << ",\"name\":\"" << response->name
-     << "\",\"email\":\"" << response->email << "\"}";
-  return ss.str();
+void CliAdapter::handleSnapshot(const std::string &command,
+                                const std::vector<std::string> &args) {
+  if (!snapshots_) {
+    throw cppcrudbp::domain::DomainException(
+        "No snapshot store; start with --snapshot <file>.");
+  }
+  if (args.size() != 1) {
+    throw std::invalid_argument("Usage: " + command + " <file>");
+  }
+  const bool save = command == "snapshot-save";
+  const auto info = save ? snapshots_->saveSnapshot(args[0])
+                         : snapshots_->loadSnapshot(args[0]);
+  const auto ms =
+      std::chrono::duration<double, std::milli>(info.elapsed).count();
+  *out_ << (save ? "Saved " : "Loaded ") << info.users << " users ("
+        << info.bytes << " bytes) " << (save ? "to " : "from ") << info.path
+        << " in " << std::fixed << std::setprecision(1) << ms << " ms."
+        << std::defaultfloat << std::setprecision(6) << '\n';
 }
 
-std::string CliAdapter::serializeUserResponses(
-    const std::vector<cppcrudbp::application::UserResponse> &responses) {
-  std::stringstream ss;
-  ss << "[";
-  for (size_t i = 0; i < responses.size(); ++i) {
-    ss << serializeUserResponse(responses[i]);
-    if (i < responses.size() - 1) {
-      ss << ",";
+void CliAdapter::handleBegin() {
+  if (unitOfWork_) {
+    throw std::invalid_argument("A transaction is already open.");
+  }
+  unitOfWork_ = userService_->beginUnitOfWork();
+  if (!unitOfWork_) {
+    throw cppcrudbp::domain::DomainException(
+        "Transaction could not be started.");
+  }
+  *out_ << "Transaction started." << '\n';
+}
+
+void CliAdapter::handleCommit() {
+  if (!unitOfWork_) {
+    throw std::invalid_argument("No transaction is open.");
+  }
+  const bool committed = unitOfWork_->commit();
+  unitOfWork_.reset();
+  if (!committed) {
+    throw cppcrudbp::domain::DomainException(
+        "Transaction rolled back: a command in it failed.");
+  }
+  *out_ << "Transaction committed." << '\n';
+}
+
+void CliAdapter::handleRollback() {
+  if (!unitOfWork_) {
+    throw std::invalid_argument("No transaction is open.");
+  }
+  unitOfWork_->rollback();
+  unitOfWork_.reset();
+  *out_ << "Transaction rolled back." << '\n';
+}
+
+void CliAdapter::rollbackOpenUnitOfWork() {
+  if (unitOfWork_) {
+    unitOfWork_->rollback();
+    unitOfWork_.reset();
+    *err_ << "Open transaction rolled back." << '\n';
+  }
+}
+
+std::size_t CliAdapter::readUserFile(
+    const std::string &path,
+    const std::function<void(
+        const std::vector<cppcrudbp::application::CreateUserRequest> &)>
+        &onBatch) {
+  std::ifstream input(path);
+  if (!input) {
+    throw std::invalid_argument("Cannot open file: " + path);
+  }
+  const bool csv = endsWith(path, ".csv");
+
+  // The file is read and sent in fixed-size batches, never loaded whole.
+  constexpr size_t kBatchSize = 10000;
+  std::vector<cppcrudbp::application::CreateUserRequest> batch;
+  batch.reserve(kBatchSize);
+  size_t invalid = 0;
+
+  std::string line;
+  size_t line_number = 0;
+  while (std::getline(input, line)) {
+    ++line_number;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.find_first_not_of(" \t") == std::string::npos) {
+      continue;
     }
+    try {
+      if (csv) {
+        std::vector<std::string> fields = splitCsvRecord(line);
+        if (line_number == 1 && fields.size() == 2 && fields[0] == "name" &&
+            fields[1] == "email") {
+          continue; // Header row.
+        }
+        if (fields.size() != 2) {
+          throw std::invalid_argument("Expected 2 CSV fields: name,email.");
+        }
+        validateUserFields(fields[0], fields[1], "user creation");
+        batch.push_back({std::move(fields[0]), std::move(fields[1])});
+      } else {
+        batch.push_back(parseCreateUserRequest(line));
+      }
+    } catch (const std::invalid_argument &e) {
+      ++invalid;
+      *err_ << "Skipping line " << line_number << ": " << e.what() << '\n';
+      continue;
+    }
+    if (batch.size() == kBatchSize) {
+      onBatch(batch);
+      batch.clear();
+    }
+  }
+  if (!batch.empty()) {
+    onBatch(batch);
+  }
+  return invalid;
+}
+
+void CliAdapter::handleImportUsers(const std::vector<std::string> &args) {
+  if (args.empty()) {
+    throw std::invalid_argument("Usage: import <file.jsonl|file.csv>");
+  }
+  constexpr size_t kMaxReportedRejections = 10;
+  size_t inserted = 0, failed = 0, rejected = 0;
+  std::vector<std::string> rejected_sample;
+
+  const auto start = std::chrono::steady_clock::now();
+  const size_t invalid = readUserFile(args[0], [&](const auto &batch) {
+    auto result = userService_->bulkCreateUsers(batch);
+    inserted += result.inserted;
+    failed += result.failed;
+    rejected += result.rejected_emails.size();
+    for (auto &email : result.rejected_emails) {
+      if (rejected_sample.size() == kMaxReportedRejections) {
+        break;
+      }
+      rejected_sample.push_back(std::move(email));
+    }
+  });
+
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  *out_ << "Imported " << inserted << " users in " << seconds << " s ("
+        << (seconds > 0 ? static_cast<double>(inserted) / seconds : 0.0)
+        << " rows/sec)." << '\n';
+  if (rejected > 0) {
+    *out_ << "Rejected " << rejected << " duplicate emails, e.g.:";
+    for (const auto &email : rejected_sample) {
+      *out_ << " " << email;
+    }
+    *out_ << '\n';
+  }
+  if (invalid > 0) {
+    *out_ << "Skipped " << invalid << " invalid lines." << '\n';
+  }
+  if (failed > 0) {
+    *out_ << failed << " rows were not imported due to database errors."
+          << '\n';
   }
-  ss << "]";
-  return ss.str();
+}
+
+void CliAdapter::handleSyncUsers(const std::vector<std::string> &args) {
+  if (args.empty()) {
+    throw std::invalid_argument("Usage: sync <file.jsonl|file.csv>");
+  }
+  cppcrudbp::application::BulkUpsertResult total;
+  const auto start = std::chrono::steady_clock::now();
+  const size_t invalid = readUserFile(args[0], [&](const auto &batch) {
+    const auto result = userService_->upsertUsers(batch);
+    total.inserted += result.inserted;
+    total.updated += result.updated;
+    total.unchanged += result.unchanged;
+    total.failed += result.failed;
+  });
+
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  const size_t rows = total.inserted + total.updated + total.unchanged;
+  *out_ << "Synced " << rows << " users in " << seconds << " s ("
+        << (seconds > 0 ? static_cast<double>(rows) / seconds : 0.0)
+        << " rows/sec): " << total.inserted << " inserted, " << total.updated
+        << " updated, " << total.unchanged << " unchanged." << '\n';
+  if (invalid > 0) {
+    *out_ << "Skipped " << invalid << " invalid lines." << '\n';
+  }
+  if (total.failed > 0) {
+    *out_ << total.failed << " rows were not synced due to database errors."
+          << '\n';
+  }
+}
+
+// --- JSON request helpers ---
+cppcrudbp::application::CreateUserRequest
+CliAdapter::parseCreateUserRequest(const std::string &json) {
+  cppcrudbp::application::CreateUserRequest request;
+  presentation::parseCreateUserJson(json, request);
+  validateUserFields(request.name, request.email, "user creation");
+  return request;
+}
+
+cppcrudbp::application::UpdateUserRequest
+CliAdapter::parseUpdateUserRequest(const std::string &json, int id) {
+  cppcrudbp::application::UpdateUserRequest request;
+  request.id = id;
+  presentation::parseUpdateUserJson(json, request);
+  validateUserFields(request.name, request.email, "user update");
+  return request;
 }
 
 } // namespace cppcrudbp::cli
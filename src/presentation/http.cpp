@@ -0,0 +1,608 @@
+#include "presentation/http.h"
+#include "presentation/json_reader.h"
+#include "presentation/json_writer.h"
+#include "presentation/request_validation.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+
+namespace cppcrudbp::http {
+
+namespace {
+
+constexpr std::size_t kReadChunk = 16 * 1024;
+constexpr int kMaxEvents = 256;
+constexpr std::size_t kDefaultPageLimit = 100;
+// A page is built on the worker thread, which serves other connections too.
+constexpr std::size_t kMaxPageLimit = 1000;
+
+// Outcome of trying to parse one request off the front of the read buffer.
+enum class ParseStatus { kIncomplete, kComplete, kError };
+
+struct ParseResult {
+  ParseStatus status = ParseStatus::kIncomplete;
+  std::size_t consumed = 0; // Bytes of the buffer the request spans.
+  int error_status = 0;     // HTTP status to answer with on kError.
+};
+
+const char *reasonPhrase(int status) {
+  switch (status) {
+  case 200:
+    return "OK";
+  case 201:
+    return "Created";
+  case 204:
+    return "No Content";
+  case 400:
+    return "Bad Request";
+  case 404:
+    return "Not Found";
+  case 405:
+    return "Method Not Allowed";
+  case 409:
+    return "Conflict";
+  case 413:
+    return "Payload Too Large";
+  case 501:
+    return "Not Implemented";
+  default:
+    return "Internal Server Error";
+  }
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    const char x = a[i] >= 'A' && a[i] <= 'Z' ? a[i] - 'A' + 'a' : a[i];
+    const char y = b[i] >= 'A' && b[i] <= 'Z' ? b[i] - 'A' + 'a' : b[i];
+    if (x != y) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string_view trim(std::string_view value) {
+  while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+    value.remove_prefix(1);
+  }
+  while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+    value.remove_suffix(1);
+  }
+  return value;
+}
+
+template <typename Int> bool parseNumber(std::string_view text, Int &value) {
+  const char *end = text.data() + text.size();
+  const auto result = std::from_chars(text.data(), end, value);
+  return !text.empty() && result.ec == std::errc() && result.ptr == end;
+}
+
+// Parses the request at the start of @p buffer. Views in @p request point
+// into @p buffer.
+ParseResult parseRequest(std::string_view buffer, std::size_t max_bytes,
+                         HttpRequest &request) {
+  ParseResult result;
+  const std::size_t head_end = buffer.find("\r\n\r\n");
+  if (head_end == std::string_view::npos) {
+    if (buffer.size() > max_bytes) {
+      result.status = ParseStatus::kError;
+      result.error_status = 413;
+    }
+    return result;
+  }
+  result.status = ParseStatus::kError;
+  result.error_status = 400;
+
+  std::string_view head = buffer.substr(0, head_end);
+  std::size_t line_end = head.find("\r\n");
+  const std::string_view request_line = head.substr(0, line_end);
+  head.remove_prefix(line_end == std::string_view::npos ? head.size()
+                                                        : line_end + 2);
+
+  // METHOD SP target SP HTTP/1.x
+  const std::size_t method_end = request_line.find(' ');
+  const std::size_t target_end = request_line.rfind(' ');
+  if (method_end == std::string_view::npos || target_end == method_end) {
+    return result;
+  }
+  request.method = request_line.substr(0, method_end);
+  std::string_view target =
+      request_line.substr(method_end + 1, target_end - method_end - 1);
+  const std::string_view version = request_line.substr(target_end + 1);
+  if (version == "HTTP/1.1") {
+    request.keep_alive = true;
+  } else if (version == "HTTP/1.0") {
+    request.keep_alive = false;
+  } else {
+    return result;
+  }
+  const std::size_t query_start = target.find('?');
+  request.path = target.substr(0, query_start);
+  request.query = query_start == std::string_view::npos
+                      ? std::string_view()
+                      : target.substr(query_start + 1);
+
+  std::size_t content_length = 0;
+  while (!head.empty()) {
+    line_end = head.find("\r\n");
+    const std::string_view line = head.substr(0, line_end);
+    head.remove_prefix(line_end == std::string_view::npos ? head.size()
+                                                          : line_end + 2);
+    const std::size_t colon = line.find(':');
+    if (colon == std::string_view::npos) {
+      return result;
+    }
+    const std::string_view name = line.substr(0, colon);
+    const std::string_view value = trim(line.substr(colon + 1));
+    if (equalsIgnoreCase(name, "content-length")) {
+      if (!parseNumber(value, content_length)) {
+        return result;
+      }
+    } else if (equalsIgnoreCase(name, "transfer-encoding")) {
+      result.error_status = 501;
+      return result;
+    } else if (equalsIgnoreCase(name, "connection")) {
+      if (equalsIgnoreCase(value, "close")) {
+        request.keep_alive = false;
+      } else if (equalsIgnoreCase(value, "keep-alive")) {
+        request.keep_alive = true;
+      }
+    }
+  }
+
+  if (content_length > max_bytes) {
+    result.error_status = 413;
+    return result;
+  }
+  const std::size_t body_start = head_end + 4;
+  if (buffer.size() - body_start < content_length) {
+    result.status = ParseStatus::kIncomplete;
+    return result;
+  }
+  request.body = buffer.substr(body_start, content_length);
+  result.status = ParseStatus::kComplete;
+  result.consumed = body_start + content_length;
+  return result;
+}
+
+void appendResponse(std::string &out, const HttpResponse &response,
+                    bool keep_alive) {
+  char digits[24];
+  auto end = std::to_chars(digits, digits + sizeof(digits), response.status);
+  out += "HTTP/1.1 ";
+  out.append(digits, end.ptr);
+  out += ' ';
+  out += reasonPhrase(response.status);
+  out += "\r\n";
+  if (!response.body.empty()) {
+    out += "Content-Type: ";
+    out += response.content_type;
+    out += "\r\n";
+  }
+  if (response.status != 204) {
+    end = std::to_chars(digits, digits + sizeof(digits), response.body.size());
+    out += "Content-Length: ";
+    out.append(digits, end.ptr);
+    out += "\r\n";
+  }
+  if (!keep_alive) {
+    out += "Connection: close\r\n";
+  }
+  out += "\r\n";
+  out += response.body;
+}
+
+HttpResponse errorResponse(int status, std::string_view message) {
+  presentation::JsonWriter json;
+  json.raw("{\"error\":").string(message).raw("}");
+  return HttpResponse{status, json.take()};
+}
+
+} // namespace
+
+struct HttpAdapter::Connection {
+  int fd;
+  std::string in;
+  std::string out;
+  std::size_t out_offset = 0;
+  bool close_after_write = false;
+};
+
+struct HttpAdapter::Worker {
+  int epoll_fd = -1;
+  std::unordered_map<int, std::unique_ptr<Connection>> connections;
+};
+
+HttpAdapter::HttpAdapter(
+    std::shared_ptr<cppcrudbp::application::UserService> userService,
+    HttpOptions options)
+    : userService_(std::move(userService)), options_(std::move(options)) {
+  if (!userService_) {
+    throw std::invalid_argument("UserService cannot be null");
+  }
+  if (options_.workers == 0) {
+    options_.workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  auto &metrics = common::Metrics::global();
+  metrics_.create = metrics.registerOperation("http", "POST /users");
+  metrics_.get = metrics.registerOperation("http", "GET /users/{id}");
+  metrics_.list = metrics.registerOperation("http", "GET /users");
+  metrics_.update = metrics.registerOperation("http", "PUT /users/{id}");
+  metrics_.remove = metrics.registerOperation("http", "DELETE /users/{id}");
+  metrics_.metrics = metrics.registerOperation("http", "GET /metrics");
+  metrics_.other = metrics.registerOperation("http", "other");
+}
+
+HttpAdapter::~HttpAdapter() {
+  stop();
+  wait();
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+  }
+  if (stop_fd_ >= 0) {
+    close(stop_fd_);
+  }
+}
+
+void HttpAdapter::start() {
+  listen_fd_ =
+      socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+  }
+  const int on = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options_.port);
+  if (inet_pton(AF_INET, options_.address.c_str(), &address.sin_addr) != 1) {
+    throw std::invalid_argument("Invalid listen address: " +
+                                options_.address);
+  }
+  if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) < 0 ||
+      listen(listen_fd_, SOMAXCONN) < 0) {
+    throw std::runtime_error("Cannot listen on " + options_.address + ":" +
+                             std::to_string(options_.port) + ": " +
+                             std::strerror(errno));
+  }
+  socklen_t length = sizeof(address);
+  getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&address), &length);
+  bound_port_ = ntohs(address.sin_port);
+
+  stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (stop_fd_ < 0) {
+    throw std::runtime_error(std::string("eventfd: ") + std::strerror(errno));
+  }
+  workers_.reserve(options_.workers);
+  for (std::size_t i = 0; i < options_.workers; ++i) {
+    workers_.emplace_back(&HttpAdapter::workerLoop, this);
+  }
+}
+
+void HttpAdapter::wait() {
+  for (auto &worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+  workers_.clear();
+}
+
+void HttpAdapter::stop() {
+  if (stop_fd_ >= 0) {
+    // Never read back, so the eventfd stays readable and wakes every worker.
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const auto written = write(stop_fd_, &one, sizeof(one));
+  }
+}
+
+void HttpAdapter::workerLoop() {
+  Worker worker;
+  worker.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (worker.epoll_fd < 0) {
+    return;
+  }
+  epoll_event event{};
+  // EPOLLEXCLUSIVE: a new connection wakes one worker, not all of them.
+  event.events = EPOLLIN | EPOLLEXCLUSIVE;
+  event.data.ptr = &listen_fd_;
+  epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, listen_fd_, &event);
+  event.events = EPOLLIN;
+  event.data.ptr = &stop_fd_;
+  epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, stop_fd_, &event);
+
+  epoll_event events[kMaxEvents];
+  bool running = true;
+  while (running) {
+    const int ready = epoll_wait(worker.epoll_fd, events, kMaxEvents, -1);
+    if (ready < 0 && errno != EINTR) {
+      break;
+    }
+    for (int i = 0; i < ready; ++i) {
+      void *const source = events[i].data.ptr;
+      if (source == &stop_fd_) {
+        running = false;
+        continue;
+      }
+      if (source == &listen_fd_) {
+        acceptConnections(worker);
+        continue;
+      }
+      auto &conn = *static_cast<Connection *>(source);
+      const std::uint32_t flags = events[i].events;
+      bool open = (flags & (EPOLLERR | EPOLLHUP)) == 0;
+      if (open && (flags & (EPOLLIN | EPOLLRDHUP))) {
+        open = readRequests(conn);
+      }
+      if (open) {
+        open = writeResponses(conn);
+      }
+      if (!open) {
+        closeConnection(worker, conn);
+      }
+    }
+  }
+
+  for (auto &entry : worker.connections) {
+    close(entry.first);
+  }
+  close(worker.epoll_fd);
+}
+
+void HttpAdapter::acceptConnections(Worker &worker) {
+  while (true) {
+    const int fd = accept4(listen_fd_, nullptr, nullptr,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      return; // EAGAIN, or another worker took it.
+    }
+    const int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    auto conn = std::make_unique<Connection>();
+    conn->fd = fd;
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = conn.get();
+    if (epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+      close(fd);
+      continue;
+    }
+    worker.connections.emplace(fd, std::move(conn));
+  }
+}
+
+void HttpAdapter::closeConnection(Worker &worker, Connection &conn) {
+  const int fd = conn.fd;
+  epoll_ctl(worker.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+  worker.connections.erase(fd);
+}
+
+bool HttpAdapter::readRequests(Connection &conn) {
+  // Edge-triggered: drain the socket until it would block.
+  bool peer_closed = false;
+  char chunk[kReadChunk];
+  while (true) {
+    const ssize_t n = recv(conn.fd, chunk, sizeof(chunk), 0);
+    if (n > 0) {
+      if (!conn.close_after_write) {
+        conn.in.append(chunk, static_cast<std::size_t>(n));
+      }
+    } else if (n == 0) {
+      peer_closed = true;
+      break;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    } else {
+      return false;
+    }
+  }
+
+  // Answer every complete request in the buffer (pipelining), in order.
+  std::size_t consumed = 0;
+  while (!conn.close_after_write) {
+    HttpRequest request;
+    const ParseResult parsed =
+        parseRequest(std::string_view(conn.in).substr(consumed),
+                     options_.max_request_bytes, request);
+    if (parsed.status == ParseStatus::kIncomplete) {
+      break;
+    }
+    if (parsed.status == ParseStatus::kError) {
+      appendResponse(conn.out,
+                     errorResponse(parsed.error_status,
+                                   reasonPhrase(parsed.error_status)),
+                     false);
+      conn.close_after_write = true;
+      break;
+    }
+    appendResponse(conn.out, handle(request), request.keep_alive);
+    consumed += parsed.consumed;
+    conn.close_after_write = !request.keep_alive;
+  }
+  if (conn.close_after_write) {
+    conn.in.clear();
+  } else {
+    conn.in.erase(0, consumed);
+  }
+
+  if (peer_closed) {
+    // Still try to deliver what was answered; nothing more will arrive.
+    conn.close_after_write = true;
+  }
+  return true;
+}
+
+bool HttpAdapter::writeResponses(Connection &conn) {
+  while (conn.out_offset < conn.out.size()) {
+    const ssize_t n =
+        send(conn.fd, conn.out.data() + conn.out_offset,
+             conn.out.size() - conn.out_offset, MSG_NOSIGNAL);
+    if (n >= 0) {
+      conn.out_offset += static_cast<std::size_t>(n);
+    } else if (errno == EINTR) {
+      continue;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return true; // EPOLLOUT fires once the socket drains.
+    } else {
+      return false;
+    }
+  }
+  conn.out.clear();
+  conn.out_offset = 0;
+  return !conn.close_after_write;
+}
+
+HttpResponse HttpAdapter::handle(const HttpRequest &request) {
+  const auto start = std::chrono::steady_clock::now();
+  common::MetricId metric = metrics_.other;
+  HttpResponse response = route(request, metric);
+  common::Metrics::global().record(
+      metric, std::chrono::steady_clock::now() - start, response.status >= 500,
+      0, response.body.size());
+  return response;
+}
+
+HttpResponse HttpAdapter::route(const HttpRequest &request,
+                                common::MetricId &metric) {
+  constexpr std::string_view kCollection = "/users";
+  try {
+    if (request.path == kCollection) {
+      if (request.method == "GET") {
+        metric = metrics_.list;
+        return listUsers(request.query);
+      }
+      if (request.method == "POST") {
+        metric = metrics_.create;
+        return createUser(request.body);
+      }
+      return errorResponse(405, "Method not allowed");
+    }
+    if (request.path == "/metrics" && request.method == "GET") {
+      metric = metrics_.metrics;
+      std::ostringstream text;
+      common::writePrometheus(common::Metrics::global().snapshot(), text);
+      return HttpResponse{200, text.str(), "text/plain; version=0.0.4"};
+    }
+    if (request.path.substr(0, kCollection.size() + 1) != "/users/") {
+      return errorResponse(404, "Not found");
+    }
+    int id = 0;
+    if (!parseNumber(request.path.substr(kCollection.size() + 1), id)) {
+      return errorResponse(400, "Invalid user ID");
+    }
+    if (request.method == "GET") {
+      metric = metrics_.get;
+      return getUser(id);
+    }
+    if (request.method == "PUT") {
+      metric = metrics_.update;
+      return updateUser(id, request.body);
+    }
+    if (request.method == "DELETE") {
+      metric = metrics_.remove;
+      return deleteUser(id);
+    }
+    return errorResponse(405, "Method not allowed");
+  } catch (const std::invalid_argument &e) {
+    return errorResponse(400, e.what());
+  } catch (const std::exception &e) {
+    return errorResponse(500, e.what());
+  }
+}
+
+HttpResponse HttpAdapter::listUsers(std::string_view query) {
+  // ?after_id=<id>&limit=<n>, both optional: a bare GET /users is the first
+  // page, never the whole table.
+  int after_id = 0;
+  std::size_t limit = kDefaultPageLimit;
+  while (!query.empty()) {
+    const std::size_t amp = query.find('&');
+    const std::string_view pair = query.substr(0, amp);
+    query.remove_prefix(amp == std::string_view::npos ? query.size()
+                                                      : amp + 1);
+    const std::size_t eq = pair.find('=');
+    const std::string_view key = pair.substr(0, eq);
+    const std::string_view value =
+        eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1);
+    if (key == "after_id" && !parseNumber(value, after_id)) {
+      return errorResponse(400, "Invalid after_id");
+    }
+    if (key == "limit" && (!parseNumber(value, limit) || limit == 0 ||
+                           limit > kMaxPageLimit)) {
+      return errorResponse(400, "Page limit must be between 1 and " +
+                                    std::to_string(kMaxPageLimit));
+    }
+  }
+  presentation::JsonWriter json;
+  json.users(userService_->getUsersPage(after_id, limit));
+  return HttpResponse{200, json.take()};
+}
+
+HttpResponse HttpAdapter::createUser(std::string_view body) {
+  application::CreateUserRequest request;
+  presentation::parseCreateUserJson(body, request);
+  presentation::validateUserFields(request.name, request.email,
+                                   "user creation");
+  const auto user = userService_->createUser(request);
+  if (!user) {
+    return errorResponse(409, "User could not be created");
+  }
+  presentation::JsonWriter json;
+  json.user(*user);
+  return HttpResponse{201, json.take()};
+}
+
+HttpResponse HttpAdapter::getUser(int id) {
+  const auto user = userService_->getUserById(id);
+  if (!user) {
+    return errorResponse(404, "User not found");
+  }
+  presentation::JsonWriter json;
+  json.user(*user);
+  return HttpResponse{200, json.take()};
+}
+
+HttpResponse HttpAdapter::updateUser(int id, std::string_view body) {
+  application::UpdateUserRequest request{id, {}, {}};
+  presentation::parseUpdateUserJson(body, request);
+  presentation::validateUserFields(request.name, request.email,
+                                   "user update");
+  const auto user = userService_->updateUser(request);
+  if (!user) {
+    return errorResponse(404, "User could not be updated");
+  }
+  presentation::JsonWriter json;
+  json.user(*user);
+  return HttpResponse{200, json.take()};
+}
+
+HttpResponse HttpAdapter::deleteUser(int id) {
+  if (!userService_->deleteUser(id)) {
+    return errorResponse(404, "User not found");
+  }
+  return HttpResponse{204, {}};
+}
+
+} // namespace cppcrudbp::http
@@ -0,0 +1,350 @@
+#include "presentation/json_reader.h"
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace cppcrudbp::presentation {
+
+namespace {
+
+void appendUtf8(std::string &out, unsigned code_point) {
+  if (code_point < 0x80) {
+    out += static_cast<char>(code_point);
+  } else if (code_point < 0x800) {
+    out += static_cast<char>(0xC0 | (code_point >> 6));
+    out += static_cast<char>(0x80 | (code_point & 0x3F));
+  } else if (code_point < 0x10000) {
+    out += static_cast<char>(0xE0 | (code_point >> 12));
+    out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (code_point & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (code_point >> 18));
+    out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (code_point & 0x3F));
+  }
+}
+
+template <typename Request>
+void parseUserJson(std::string_view json, Request &request) {
+  JsonReader reader(json);
+  reader.readObject([&request](std::string_view key, JsonReader &value) {
+    if (key == "name") {
+      value.readString(request.name);
+    } else if (key == "email") {
+      value.readString(request.email);
+    } else {
+      value.skipValue();
+    }
+  });
+  reader.expectEnd();
+}
+
+} // namespace
+
+void JsonReader::fail(const std::string &what) const {
+  throw std::invalid_argument("Malformed JSON at offset " +
+                              std::to_string(pos_) + ": " + what);
+}
+
+void JsonReader::skipWhitespace() {
+  while (pos_ < input_.size()) {
+    const char c = input_[pos_];
+    if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+      return;
+    }
+    ++pos_;
+  }
+}
+
+void JsonReader::expect(char c) {
+  if (peek() != c) {
+    fail(std::string("expected '") + c + "'");
+  }
+  ++pos_;
+}
+
+void JsonReader::expectEnd() {
+  skipWhitespace();
+  if (pos_ != input_.size()) {
+    fail("unexpected trailing characters");
+  }
+}
+
+unsigned JsonReader::readHex4() {
+  if (input_.size() - pos_ < 4) {
+    fail("truncated \\u escape");
+  }
+  unsigned value = 0;
+  for (int i = 0; i < 4; ++i) {
+    const char c = input_[pos_++];
+    value <<= 4;
+    if (c >= '0' && c <= '9') {
+      value |= static_cast<unsigned>(c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+      value |= static_cast<unsigned>(c - 'a' + 10);
+    } else if (c >= 'A' && c <= 'F') {
+      value |= static_cast<unsigned>(c - 'A' + 10);
+    } else {
+      fail("invalid hex digit in \\u escape");
+    }
+  }
+  return value;
+}
+
+void JsonReader::decodeEscape(std::string &out) {
+  // pos_ is just past the backslash.
+  if (pos_ >= input_.size()) {
+    fail("truncated escape");
+  }
+  const char c = input_[pos_++];
+  switch (c) {
+  case '"':
+  case '\\':
+  case '/':
+    out += c;
+    return;
+  case 'b':
+    out += '\b';
+    return;
+  case 'f':
+    out += '\f';
+    return;
+  case 'n':
+    out += '\n';
+    return;
+  case 'r':
+    out += '\r';
+    return;
+  case 't':
+    out += '\t';
+    return;
+  case 'u': {
+    unsigned code_point = readHex4();
+    if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+      if (input_.substr(pos_, 2) != "\\u") {
+        fail("unpaired high surrogate");
+      }
+      pos_ += 2;
+      const unsigned low = readHex4();
+      if (low < 0xDC00 || low > 0xDFFF) {
+        fail("invalid low surrogate");
+      }
+      code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+    } else if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+      fail("unpaired low surrogate");
+    }
+    appendUtf8(out, code_point);
+    return;
+  }
+  default:
+    fail("invalid escape");
+  }
+}
+
+void JsonReader::readString(std::string &out) {
+  expect('"');
+  out.clear();
+  while (true) {
+    // Copy the longest run that needs no decoding in one append.
+    const char *const data = input_.data();
+    const std::size_t size = input_.size();
+    const std::size_t run_start = pos_;
+    std::size_t end = run_start;
+    while (end < size) {
+      const auto c = static_cast<unsigned char>(data[end]);
+      if (c == '"' || c == '\\' || c < 0x20) {
+        break;
+      }
+      ++end;
+    }
+    pos_ = end;
+    out.append(data + run_start, end - run_start);
+    if (pos_ >= input_.size()) {
+      fail("unterminated string");
+    }
+    const char c = input_[pos_++];
+    if (c == '"') {
+      return;
+    }
+    if (c != '\\') {
+      fail("control character in string");
+    }
+    decodeEscape(out);
+  }
+}
+
+std::string_view JsonReader::readKey() {
+  if (peek() != '"') {
+    fail("expected member name");
+  }
+  // Fast path: keys without escapes are returned as views into the input.
+  // Anything else, control characters included, goes through readString.
+  const std::size_t start = pos_ + 1;
+  std::size_t end = start;
+  while (end < input_.size()) {
+    const auto c = static_cast<unsigned char>(input_[end]);
+    if (c == '"' || c == '\\' || c < 0x20) {
+      break;
+    }
+    ++end;
+  }
+  if (end < input_.size() && input_[end] == '"') {
+    pos_ = end + 1;
+    return input_.substr(start, end - start);
+  }
+  readString(key_scratch_);
+  return key_scratch_;
+}
+
+int JsonReader::readInt() {
+  const bool negative = peek() == '-';
+  if (negative) {
+    ++pos_;
+  }
+  if (peek() < '0' || peek() > '9') {
+    fail("expected integer");
+  }
+  if (peek() == '0' && pos_ + 1 < input_.size() && input_[pos_ + 1] >= '0' &&
+      input_[pos_ + 1] <= '9') {
+    fail("leading zero");
+  }
+  constexpr long long kMax = std::numeric_limits<int>::max();
+  long long value = 0;
+  while (peek() >= '0' && peek() <= '9') {
+    value = value * 10 + (input_[pos_++] - '0');
+    if (value > kMax + 1) {
+      fail("integer out of range");
+    }
+  }
+  value = negative ? -value : value;
+  if (value > kMax) {
+    fail("integer out of range");
+  }
+  if (peek() == '.' || peek() == 'e' || peek() == 'E') {
+    fail("expected integer");
+  }
+  return static_cast<int>(value);
+}
+
+void JsonReader::skipString() {
+  expect('"');
+  std::string escaped; // One escape at a time: fits the small buffer.
+  while (true) {
+    while (pos_ < input_.size()) {
+      const auto c = static_cast<unsigned char>(input_[pos_]);
+      if (c == '"' || c == '\\' || c < 0x20) {
+        break;
+      }
+      ++pos_;
+    }
+    if (pos_ >= input_.size()) {
+      fail("unterminated string");
+    }
+    const char c = input_[pos_++];
+    if (c == '"') {
+      return;
+    }
+    if (c != '\\') {
+      fail("control character in string");
+    }
+    escaped.clear();
+    decodeEscape(escaped);
+  }
+}
+
+void JsonReader::skipDigits() {
+  if (peek() < '0' || peek() > '9') {
+    fail("expected digit");
+  }
+  while (peek() >= '0' && peek() <= '9') {
+    ++pos_;
+  }
+}
+
+void JsonReader::skipNumber() {
+  // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+  if (peek() == '-') {
+    ++pos_;
+  }
+  if (peek() == '0') {
+    ++pos_;
+  } else {
+    skipDigits();
+  }
+  if (peek() == '.') {
+    ++pos_;
+    skipDigits();
+  }
+  if (peek() == 'e' || peek() == 'E') {
+    ++pos_;
+    if (peek() == '+' || peek() == '-') {
+      ++pos_;
+    }
+    skipDigits();
+  }
+}
+
+void JsonReader::skipValue() {
+  const char c = peek();
+  if (c == '"') {
+    skipString();
+  } else if (c == '{') {
+    readObject([](std::string_view, JsonReader &value) { value.skipValue(); });
+  } else if (c == '[') {
+    ++pos_;
+    skipWhitespace();
+    if (peek() == ']') {
+      ++pos_;
+      return;
+    }
+    while (true) {
+      skipValue();
+      skipWhitespace();
+      if (peek() == ',') {
+        ++pos_;
+        skipWhitespace();
+        continue;
+      }
+      expect(']');
+      return;
+    }
+  } else if (c == '-' || (c >= '0' && c <= '9')) {
+    skipNumber();
+  } else {
+    for (const std::string_view literal : {"true", "false", "null"}) {
+      if (input_.substr(pos_, literal.size()) == literal) {
+        pos_ += literal.size();
+        return;
+      }
+    }
+    fail("unexpected value");
+  }
+}
+
+void parseCreateUserJson(std::string_view json,
+                         application::CreateUserRequest &request) {
+  parseUserJson(json, request);
+}
+
+void parseUpdateUserJson(std::string_view json,
+                         application::UpdateUserRequest &request) {
+  parseUserJson(json, request);
+}
+
+void parseNameCursorJson(std::string_view json,
+                         application::NameCursor &cursor) {
+  JsonReader reader(json);
+  reader.readObject([&cursor](std::string_view key, JsonReader &value) {
+    if (key == "name") {
+      value.readString(cursor.name);
+    } else if (key == "id") {
+      cursor.id = value.readInt();
+    } else {
+      value.skipValue();
+    }
+  });
+  reader.expectEnd();
+}
+
+} // namespace cppcrudbp::presentation
@@ -0,0 +1,120 @@
+#include "presentation/json_writer.h"
+#include <array>
+#include <charconv>
+
+namespace cppcrudbp::presentation {
+
+namespace {
+
+// For each byte: 0 if it is copied as-is, otherwise the character that
+// follows the backslash ('u' meaning a \u00XX escape).
+constexpr std::array<char, 256> makeEscapeTable() {
+  std::array<char, 256> table{};
+  for (int c = 0; c < 0x20; ++c) {
+    table[c] = 'u';
+  }
+  table['"'] = '"';
+  table['\\'] = '\\';
+  table['\b'] = 'b';
+  table['\f'] = 'f';
+  table['\n'] = 'n';
+  table['\r'] = 'r';
+  table['\t'] = 't';
+  return table;
+}
+
+constexpr std::array<char, 256> kEscape = makeEscapeTable();
+
+} // namespace
+
+JsonWriter::JsonWriter(std::ostream *sink, std::size_t flush_threshold)
+    : sink_(sink), flush_threshold_(flush_threshold) {
+  buffer_.reserve(sink_ ? flush_threshold_ + 256 : 256);
+}
+
+JsonWriter::~JsonWriter() {
+  if (sink_) {
+    flush();
+  }
+}
+
+JsonWriter &JsonWriter::raw(std::string_view text) {
+  buffer_.append(text);
+  maybeFlush();
+  return *this;
+}
+
+JsonWriter &JsonWriter::string(std::string_view value) {
+  buffer_ += '"';
+  std::size_t run_start = 0;
+  for (std::size_t i = 0; i < value.size(); ++i) {
+    const char escape = kEscape[static_cast<unsigned char>(value[i])];
+    if (escape == 0) {
+      continue;
+    }
+    buffer_.append(value.data() + run_start, i - run_start);
+    buffer_ += '\\';
+    buffer_ += escape;
+    if (escape == 'u') {
+      constexpr char kHex[] = "0123456789abcdef";
+      const auto c = static_cast<unsigned char>(value[i]);
+      buffer_ += "00";
+      buffer_ += kHex[c >> 4];
+      buffer_ += kHex[c & 0xF];
+    }
+    run_start = i + 1;
+  }
+  buffer_.append(value.data() + run_start, value.size() - run_start);
+  buffer_ += '"';
+  maybeFlush();
+  return *this;
+}
+
+JsonWriter &JsonWriter::number(long long value) {
+  char digits[24];
+  const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer_.append(digits, result.ptr);
+  maybeFlush();
+  return *this;
+}
+
+JsonWriter &JsonWriter::user(const application::UserView &user) {
+  raw("{\"id\":").number(user.id);
+  raw(",\"name\":").string(user.name);
+  raw(",\"email\":").string(user.email);
+  return raw("}");
+}
+
+JsonWriter &
+JsonWriter::users(const std::vector<application::UserResponse> &users) {
+  raw("[");
+  for (std::size_t i = 0; i < users.size(); ++i) {
+    if (i > 0) {
+      raw(",");
+    }
+    user(users[i]);
+  }
+  return raw("]");
+}
+
+JsonWriter &JsonWriter::users(const application::UserBatch &users) {
+  raw("[");
+  for (std::size_t i = 0; i < users.size(); ++i) {
+    if (i > 0) {
+      raw(",");
+    }
+    user(users[i]);
+  }
+  return raw("]");
+}
+
+void JsonWriter::flush() {
+  if (!sink_ || buffer_.empty()) {
+    return;
+  }
+  sink_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  flushed_ += buffer_.size();
+  buffer_.clear();
+}
+
+} // namespace cppcrudbp::presentation
@@ -0,0 +1,19 @@
+#include "presentation/request_validation.h"
+#include <regex> // For basic email validation (example)
+#include <stdexcept>
+
+namespace cppcrudbp::presentation {
+
+void validateUserFields(const std::string &name, const std::string &email,
+                        const std::string &operation) {
+  if (name.empty() || email.empty()) {
+    throw std::invalid_argument("Name and email are required in JSON for " +
+                                operation + ".");
+  }
+  static const std::regex email_regex(R"(^[^@\s]+@[^@\s]+\.[^@\s]+$)");
+  if (!std::regex_match(email, email_regex)) {
+    throw std::invalid_argument("Invalid email format.");
+  }
+}
+
+} // namespace cppcrudbp::presentation